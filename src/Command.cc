@@ -6,6 +6,7 @@
 \*---------------------------------------------------------------------------*/
 
 #include <map>
+#include <vector>
 
 #include <zypp/base/NamedValue.h>
 #include <zypp/base/Exception.h>
@@ -23,12 +24,42 @@
 ///////////////////////////////////////////////////////////////////
 namespace
 {
+  /** All names of each command, the primary one first. */
+  static std::map<ZypperCommand::Command, std::vector<std::string> > & commandNames()
+  {
+    static std::map<ZypperCommand::Command, std::vector<std::string> > _names;
+    return _names;
+  }
+
+  /** Passes the names on to the table's inserter and remembers them. */
+  template <class TInserter>
+  struct NameRecorder
+  {
+    NameRecorder( TInserter inserter_r, ZypperCommand::Command command_r )
+      : _inserter( inserter_r ), _command( command_r )
+    {}
+
+    NameRecorder & operator|( const std::string & name_r )
+    {
+      _inserter | name_r;
+      commandNames()[_command].push_back( name_r );
+      return *this;
+    }
+
+    TInserter _inserter;
+    ZypperCommand::Command _command;
+  };
+
+  template <class TInserter>
+  inline NameRecorder<TInserter> recordNames( TInserter inserter_r, ZypperCommand::Command command_r )
+  { return NameRecorder<TInserter>( inserter_r, command_r ); }
+
   static zypp::NamedValue<ZypperCommand::Command> & table()
   {
     static zypp::NamedValue<ZypperCommand::Command> _table;
     if ( _table.empty() )
     {
-#define _T(C) _table( ZypperCommand::C )
+#define _T(C) recordNames( _table( ZypperCommand::C ), ZypperCommand::C )
       _T( NONE_e )		| "NONE"		| "none" | "";
 
       _T( ADD_SERVICE_e )	| "addservice"		| "as" | "service-add" | "sa";
@@ -198,3 +229,9 @@ const std::string & ZypperCommand::asString() const
 {
   return table().getName( _command );
 }
+
+const std::vector<std::string> & ZypperCommand::names() const
+{
+  table();
+  return commandNames()[_command];
+}
@@ -10,6 +10,7 @@
 
 //#include<iosfwd>
 #include<string>
+#include<vector>
 
 /**
  * Enumeration of <b>zypper</b> commands with mapping of command aliases.
@@ -178,6 +179,9 @@ struct ZypperCommand
 
   const std::string & asString() const;
 
+  /** All names of the command (including aliases), the primary one first. */
+  const std::vector<std::string> & names() const;
+
   Command _command;
 };
 
@@ -96,6 +96,7 @@ namespace
   enum class ConfigOption {
     MAIN_SHOW_ALIAS,
     MAIN_REPO_LIST_COLUMNS,
+    MAIN_PROGRESS_FRAME_RATE,
 
     SOLVER_INSTALL_RECOMMENDS,
     SOLVER_FORCE_RESOLUTION_COMMANDS,
@@ -125,6 +126,7 @@ namespace
     static const std::vector<std::pair<std::string,ConfigOption>> _data = {
       { "main/showAlias",			ConfigOption::MAIN_SHOW_ALIAS			},
       { "main/repoListColumns",			ConfigOption::MAIN_REPO_LIST_COLUMNS		},
+      { "main/progressFrameRate",		ConfigOption::MAIN_PROGRESS_FRAME_RATE		},
       { "solver/installRecommends",		ConfigOption::SOLVER_INSTALL_RECOMMENDS		},
       { "solver/forceResolutionCommands",	ConfigOption::SOLVER_FORCE_RESOLUTION_COMMANDS	},
 
@@ -166,6 +168,7 @@ namespace
 
 Config::Config()
   : repo_list_columns("anr")
+  , progress_frameRate(10)
   , solver_installRecommends(!ZConfig::instance().solver_onlyRequires())
   , do_colors		(false)
   , color_useColors	("autodetect")
@@ -210,6 +213,19 @@ void Config::read( const std::string & file )
     if (!s.empty()) // TODO add some validation
       repo_list_columns = s;
 
+    s = augeas.getOption(asString( ConfigOption::MAIN_PROGRESS_FRAME_RATE ));
+    if (!s.empty())
+    {
+      // 1 to 1000 redraws per second; anything else is clamped
+      long rate = str::strtonum<long>(s);
+      if (rate < 1 || rate > 1000)
+      {
+        WAR << "progressFrameRate " << s << " out of range, clamped" << endl;
+        rate = rate < 1 ? 1 : 1000;
+      }
+      progress_frameRate = rate;
+    }
+
     // ---------------[ solver ]------------------------------------------------
 
     s = augeas.getOption(asString( ConfigOption::SOLVER_INSTALL_RECOMMENDS ));
@@ -30,6 +30,9 @@ struct Config
   /** Which columns to show in repo list by default (string of short options).*/
   std::string repo_list_columns;
 
+  /** zypper.conf: main.progressFrameRate (max progress redraws per second, 1-1000) */
+  unsigned progress_frameRate;
+
   bool solver_installRecommends;
   std::set<ZypperCommand> solver_forceResolutionCommands;
 
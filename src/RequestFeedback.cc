@@ -273,7 +273,12 @@ void SolverRequester::Feedback::print(
   {
   case NOT_FOUND_NAME:
   case NOT_FOUND_CAP:
-    out.error(asUserString(opts));
+    if (_suggestions.empty())
+      out.error(asUserString(opts));
+    else
+      // translators: %s is a comma separated list of package names
+      out.error(asUserString(opts), str::form(_("Did you mean: %s?"),
+          str::join(_suggestions.begin(), _suggestions.end(), ", ").c_str()));
     break;
   case NOT_FOUND_NAME_TRYING_CAPS:
   case NOT_INSTALLED:
@@ -135,14 +135,15 @@ void SolverRequester::install(const PackageSpec & pkg)
 
   if (!_opts.force_by_cap)
   {
-    PoolQuery q = pkg_spec_to_poolquery(pkg.parsed_cap, _opts.from_repos);
+    list<string> repos(_opts.from_repos);
     if (!pkg.repo_alias.empty())
-      q.addRepo(pkg.repo_alias);
+      repos.push_back(pkg.repo_alias);
+    vector<sat::Solvable> matches = pkg_spec_lookup(_nameIndex, pkg.parsed_cap, repos);
 
     // get the best matching items and tag them for installation.
     // FIXME this ignores vendor lock - we need some way to do --from which
     // would respect vendor lock: e.g. a new Selectable::updateCandidateObj(Options&)
-    PoolItemBest bestMatches(q.begin(), q.end());
+    PoolItemBest bestMatches(matches.begin(), matches.end());
     if (!bestMatches.empty())
     {
       unsigned notInstalled = 0;
@@ -257,17 +258,18 @@ void SolverRequester::remove(const PackageSpec & pkg)
 
   if (!_opts.force_by_cap)
   {
-    PoolQuery q = pkg_spec_to_poolquery(pkg.parsed_cap, "");
+    vector<sat::Solvable> matches = pkg_spec_lookup(_nameIndex, pkg.parsed_cap);
 
-    if (!q.empty())
+    if (!matches.empty())
     {
       bool got_installed = false;
-      for_(it, q.poolItemBegin(), q.poolItemEnd())
+      for_(it, matches.begin(), matches.end())
       {
-        if (it->status().isInstalled())
+        PoolItem pi(*it);
+        if (pi.status().isInstalled())
         {
-          DBG << "Marking for deletion: " << *it << endl;
-          setToRemove(*it);
+          DBG << "Marking for deletion: " << pi << endl;
+          setToRemove(pi);
           got_installed = true;
         }
       }
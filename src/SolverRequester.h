@@ -22,6 +22,7 @@
 #include "Command.h"
 #include "PackageArgs.h"
 #include "utils/misc.h" // for ResKindSet; might make sense to move this elsewhere
+#include "misc.h"
 
 
 class Out;
@@ -227,6 +228,10 @@ public:
     const zypp::PoolItem selectedObj() const
     { return _objsel; }
 
+    /** Names to suggest instead of a requested one which was not found. */
+    void setSuggestions(const std::vector<std::string> & names)
+    { _suggestions = names; }
+
     std::string asUserString(const SolverRequester::Options & opts) const;
     void print(Out & out, const SolverRequester::Options & opts) const;
 
@@ -240,6 +245,8 @@ public:
     zypp::PoolItem _objsel;
     /** The installed object */
     zypp::PoolItem _objinst;
+    /** "Did you mean" names for NOT_FOUND_NAME and NOT_FOUND_CAP */
+    std::vector<std::string> _suggestions;
   };
 
 public:
@@ -381,6 +388,8 @@ private:
       const zypp::PoolItem & installed = zypp::PoolItem())
   {
     _feedback.push_back(Feedback(id, reqpkg, selected, installed));
+    if (id == Feedback::NOT_FOUND_NAME || id == Feedback::NOT_FOUND_CAP)
+      _feedback.back().setSuggestions(_nameIndex.similar(reqpkg.parsed_cap));
   }
 
 private:
@@ -399,6 +408,9 @@ private:
   std::set<zypp::PoolItem> _toremove;
   std::set<zypp::Capability> _requires;
   std::set<zypp::Capability> _conflicts;
+
+  /** Name lookups of all requested packages share one index. */
+  PoolNameIndex _nameIndex;
 };
 
 #endif /* SOLVERREQUESTER_H_ */
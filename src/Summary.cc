@@ -23,6 +23,7 @@
 #include "utils/colors.h"
 #include "utils/misc.h"
 #include "Table.h"
+#include "output/OutJSON.h"
 #include "Zypper.h"
 
 #include "Summary.h"
@@ -437,7 +438,7 @@ void Summary::writeResolvableList(ostream & out, const ResPairSet & resolvables,
       s << " ";
     }
     mbs_write_wrapped(out, s.str(), 2, _wrap_width);
-    out << endl;
+    out << '\n';
     return;
   }
 
@@ -494,7 +495,7 @@ void Summary::writeResolvableList(ostream & out, const ResPairSet & resolvables,
     t << tr;
   }
 
-  out << t << endl;
+  out << t << '\n';
 }
 
 // --------------------------------------------------------------------------
@@ -536,7 +537,7 @@ void Summary::writeNewlyInstalled(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::POSITIVE << label ) << endl;
+    out << '\n' << ( ColorContext::POSITIVE << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::POSITIVE);
   }
 }
@@ -577,7 +578,7 @@ void Summary::writeRemoved(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::NEGATIVE << label ) << endl;
+    out << '\n' << ( ColorContext::NEGATIVE << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::NEGATIVE);
   }
   _viewop = vop;
@@ -617,7 +618,7 @@ void Summary::writeUpgraded(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::POSITIVE << label ) << endl;
+    out << '\n' << ( ColorContext::POSITIVE << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::POSITIVE);
   }
 }
@@ -656,7 +657,7 @@ void Summary::writeDowngraded(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::NEGATIVE << label ) << endl;
+    out << '\n' << ( ColorContext::NEGATIVE << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::NEGATIVE);
   }
 }
@@ -703,7 +704,7 @@ void Summary::writeReinstalled(ostream & out)
     }
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::CHANGE << label ) << endl;
+    out << '\n' << ( ColorContext::CHANGE << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::CHANGE);
   }
 }
@@ -869,7 +870,7 @@ void Summary::writeRecommended(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::POSITIVE << label ) << endl;
+    out << '\n' << ( ColorContext::POSITIVE << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::POSITIVE);
   }
 
@@ -913,7 +914,7 @@ void Summary::writeRecommended(ostream & out)
 		     it->second.size() );
 	label = str::form( label.c_str(), it->second.size() );
 
-	out << endl << ( ColorContext::HIGHLIGHT << label ) << endl;
+	out << '\n' << ( ColorContext::HIGHLIGHT << label ) << '\n';
 	writeResolvableList(out, notRequired, ColorContext::HIGHLIGHT);
       }
       else
@@ -925,7 +926,7 @@ void Summary::writeRecommended(ostream & out)
 		       it->second.size() );
 	  label = str::form( label.c_str(), it->second.size() );
 
-	  out << endl << ( ColorContext::HIGHLIGHT << label ) << endl;
+	  out << '\n' << ( ColorContext::HIGHLIGHT << label ) << '\n';
 	  writeResolvableList(out, softLocked, ColorContext::HIGHLIGHT);
         }
         if ( !conflicts.empty() )
@@ -935,7 +936,7 @@ void Summary::writeRecommended(ostream & out)
 		       it->second.size() );
 	  label = str::form( label.c_str(), it->second.size() );
 
-	  out << endl << ( ColorContext::HIGHLIGHT << label ) << endl;
+	  out << '\n' << ( ColorContext::HIGHLIGHT << label ) << '\n';
           writeResolvableList(out, conflicts, ColorContext::HIGHLIGHT);
         }
       }
@@ -960,7 +961,7 @@ void Summary::writeRecommended(ostream & out)
 		     it->second.size() );
       label = str::form( label.c_str(), it->second.size() );
 
-      out << endl << ( ColorContext::HIGHLIGHT << label ) << endl;
+      out << '\n' << ( ColorContext::HIGHLIGHT << label ) << '\n';
       writeResolvableList(out, it->second, ColorContext::HIGHLIGHT);
     }
   }
@@ -969,7 +970,7 @@ void Summary::writeRecommended(ostream & out)
   for_(it, required.begin(), required.end())
   {
     string label = "These are required:";
-    out << endl << label << endl;
+    out << '\n' << label << '\n';
 
     writeResolvableList(out, it->second);
   }
@@ -1020,7 +1021,7 @@ void Summary::writeSuggested(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::HIGHLIGHT << label ) << endl;
+    out << '\n' << ( ColorContext::HIGHLIGHT << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::HIGHLIGHT);
   }
 }
@@ -1061,7 +1062,7 @@ void Summary::writeChangedArch(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::CHANGE << label ) << endl;
+    out << '\n' << ( ColorContext::CHANGE << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::CHANGE);
   }
   _viewop = vop;
@@ -1103,7 +1104,7 @@ void Summary::writeChangedVendor(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::CHANGE << label ) << endl;
+    out << '\n' << ( ColorContext::CHANGE << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::CHANGE);
   }
   _viewop = vop;
@@ -1124,7 +1125,7 @@ void Summary::writeUnsupported(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::HIGHLIGHT << label ) << endl;
+    out << '\n' << ( ColorContext::HIGHLIGHT << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::HIGHLIGHT);
   }
 }
@@ -1144,7 +1145,7 @@ void Summary::writeNeedACC(ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::HIGHLIGHT << label ) << endl;
+    out << '\n' << ( ColorContext::HIGHLIGHT << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::HIGHLIGHT);
   }
 }
@@ -1172,7 +1173,7 @@ void Summary::writeNotUpdated(std::ostream & out)
         it->second.size());
     label = str::form( label.c_str(), it->second.size() );
 
-    out << endl << ( ColorContext::HIGHLIGHT << label ) << endl;
+    out << '\n' << ( ColorContext::HIGHLIGHT << label ) << '\n';
     writeResolvableList(out, it->second, ColorContext::HIGHLIGHT);
   }
 }
@@ -1211,7 +1212,7 @@ void Summary::writeDownloadAndInstalledSizeSummary(ostream & out)
   }
 
   mbs_write_wrapped(out, s.str(), 0, _wrap_width);
-  out << endl;
+  out << '\n';
 }
 
 void Summary::writePackageCounts(ostream & out)
@@ -1330,7 +1331,7 @@ void Summary::writePackageCounts(ostream & out)
       s << _PL("source package to install", "source packages to install", count);
     gotcha = true;
   }
-  s << "." <<  endl;
+  s << "." << '\n';
   mbs_write_wrapped(out, s.str(), 0, _wrap_width);
 }
 
@@ -1368,7 +1369,7 @@ void Summary::dumpTo(ostream & out)
     writeNeedACC(out);
     writeUnsupported(out);
   }
-  out << endl;
+  out << '\n';
   writePackageCounts(out);
   writeDownloadAndInstalledSizeSummary(out);
 }
@@ -1386,25 +1387,31 @@ void Summary::writeXmlResolvableList(ostream & out, const KindToResPairSet & res
 
       out << "<solvable";
       out << " type=\"" << res->kind() << "\"";
-      out << " name=\"" << res->name() << "\"";
-      out << " edition=\"" << res->edition() << "\"";
+      out << " name=\""; out::writeXmlEscaped( out, res->name() ) << "\"";
+      out << " edition=\""; out::writeXmlEscaped( out, res->edition().asString() ) << "\"";
       out << " arch=\"" << res->arch() << "\"";
       if (rold)
       {
-        out << " edition-old=\"" << rold->edition() << "\"";
+        out << " edition-old=\""; out::writeXmlEscaped( out, rold->edition().asString() ) << "\"";
         out << " arch-old=\"" << rold->arch() << "\"";
       }
       {
 	const std::string & text( res->summary() );
 	if ( !text.empty() )
-	  out << " summary=\"" << xml::escape(text) << "\"";
+	{
+	  out << " summary=\"";
+	  out::writeXmlEscaped( out, text ) << "\"";
+	}
       }
       {
 	const std::string & text( res->description() );
 	if ( !text.empty())
-	  out << ">\n" << "<description>" << xml::escape( text ) << "</description>" << "</solvable>" << endl;
+	{
+	  out << ">\n" << "<description>";
+	  out::writeXmlEscaped( out, text ) << "</description>" << "</solvable>" << '\n';
+	}
 	else
-	  out << "/>" << endl;
+	  out << "/>" << '\n';
       }
     }
   }
@@ -1417,63 +1424,111 @@ void Summary::dumpAsXmlTo(ostream & out)
   out << "<install-summary";
   out << " download-size=\"" << ((ByteCount::SizeType) _todownload) << "\"";
   out << " space-usage-diff=\"" << ((ByteCount::SizeType) _inst_size_change) << "\"";
-  out << ">" << endl;
+  out << ">" << '\n';
 
   if (!_toupgrade.empty())
   {
-    out << "<to-upgrade>" << endl;
+    out << "<to-upgrade>" << '\n';
     writeXmlResolvableList(out, _toupgrade);
-    out << "</to-upgrade>" << endl;
+    out << "</to-upgrade>" << '\n';
   }
 
   if (!_todowngrade.empty())
   {
-    out << "<to-downgrade>" << endl;
+    out << "<to-downgrade>" << '\n';
     writeXmlResolvableList(out, _todowngrade);
-    out << "</to-downgrade>" << endl;
+    out << "</to-downgrade>" << '\n';
   }
 
   if (!_toinstall.empty())
   {
-    out << "<to-install>" << endl;
+    out << "<to-install>" << '\n';
     writeXmlResolvableList(out, _toinstall);
-    out << "</to-install>" << endl;
+    out << "</to-install>" << '\n';
   }
 
   if (!_toreinstall.empty())
   {
-    out << "<to-reinstall>" << endl;
+    out << "<to-reinstall>" << '\n';
     writeXmlResolvableList(out, _toreinstall);
-    out << "</to-reinstall>" << endl;
+    out << "</to-reinstall>" << '\n';
   }
 
   if (!_toremove.empty())
   {
-    out << "<to-remove>" << endl;
+    out << "<to-remove>" << '\n';
     writeXmlResolvableList(out, _toremove);
-    out << "</to-remove>" << endl;
+    out << "</to-remove>" << '\n';
   }
 
   if (!_tochangearch.empty())
   {
-    out << "<to-change-arch>" << endl;
+    out << "<to-change-arch>" << '\n';
     writeXmlResolvableList(out, _tochangearch);
-    out << "</to-change-arch>" << endl;
+    out << "</to-change-arch>" << '\n';
   }
 
   if (!_tochangevendor.empty())
   {
-    out << "<to-change-vendor>" << endl;
+    out << "<to-change-vendor>" << '\n';
     writeXmlResolvableList(out, _tochangevendor);
-    out << "</to-change-vendor>" << endl;
+    out << "</to-change-vendor>" << '\n';
   }
 
   if (_viewop & SHOW_UNSUPPORTED && !_unsupported.empty())
   {
-    out << "<_unsupported>" << endl;
+    out << "<_unsupported>" << '\n';
     writeXmlResolvableList(out, _unsupported);
-    out << "</_unsupported>" << endl;
+    out << "</_unsupported>" << '\n';
   }
 
-  out << "</install-summary>" << endl;
+  out << "</install-summary>" << '\n';
+}
+
+// --------------------------------------------------------------------------
+
+void Summary::writeJsonResolvableList(const char * action, const KindToResPairSet & resolvables)
+{
+  for_(it, resolvables.begin(), resolvables.end())
+  {
+    for_(pairit, it->second.begin(), it->second.end())
+    {
+      ResObject::constPtr res(pairit->second);
+      ResObject::constPtr rold(pairit->first);
+
+      jsonout::Record rec("solvable");
+      rec("action", action)
+         ("kind", res->kind().asString())
+         ("name", res->name())
+         ("edition", res->edition().asString())
+         ("arch", res->arch().asString());
+      if (rold)
+        rec("edition-old", rold->edition().asString())
+           ("arch-old", rold->arch().asString());
+      if (!res->summary().empty())
+        rec("summary", res->summary());
+      if (!res->description().empty())
+        rec("description", res->description());
+    }
+  }
+}
+
+// --------------------------------------------------------------------------
+
+void Summary::dumpAsJson()
+{
+  jsonout::Record("install-summary")
+    ("download-size", (ByteCount::SizeType) _todownload)
+    ("space-usage-diff", (ByteCount::SizeType) _inst_size_change);
+
+  // same order and names as in dumpAsXmlTo
+  writeJsonResolvableList("to-upgrade", _toupgrade);
+  writeJsonResolvableList("to-downgrade", _todowngrade);
+  writeJsonResolvableList("to-install", _toinstall);
+  writeJsonResolvableList("to-reinstall", _toreinstall);
+  writeJsonResolvableList("to-remove", _toremove);
+  writeJsonResolvableList("to-change-arch", _tochangearch);
+  writeJsonResolvableList("to-change-vendor", _tochangevendor);
+  if (_viewop & SHOW_UNSUPPORTED)
+    writeJsonResolvableList("_unsupported", _unsupported);
 }
@@ -106,11 +106,14 @@ public:
 
   void dumpTo(std::ostream & out);
   void dumpAsXmlTo(std::ostream & out);
+  /** Write the summary as JSON records (see \ref OutJSON). */
+  void dumpAsJson();
 
 private:
   void readPool(const zypp::ResPool & pool);
   void writeResolvableList(std::ostream & out, const ResPairSet & resolvables, ansi::Color = ansi::Color::nocolor() );
   void writeXmlResolvableList(std::ostream & out, const KindToResPairSet & resolvables);
+  void writeJsonResolvableList(const char * action, const KindToResPairSet & resolvables);
 
   void collectInstalledRecommends(const zypp::ResObject::constPtr & obj);
 
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
 
 #include <zypp/base/LogTools.h>
 #include <zypp/base/String.h>
@@ -21,6 +22,32 @@ using namespace std;
 
 TableLineStyle Table::defaultStyle = Ascii;
 
+namespace
+{
+  inline void writeSpaces( ostream & stream, unsigned n )
+  {
+    static const char spaces[] = "                                ";
+    while ( n )
+    {
+      unsigned chunk = n < sizeof(spaces) - 1 ? n : sizeof(spaces) - 1;
+      stream.write( spaces, chunk );
+      n -= chunk;
+    }
+  }
+
+  /** Write \a len_r bytes at \a text_r in \a color_r.
+   * The SGR sequences are cached by \ref ansi::Color, nothing is allocated.
+   */
+  inline void writeColored( ostream & stream, const char * text_r, string::size_type len_r, ansi::Color color_r )
+  {
+    const string & sgr( color_r.str() );
+    stream << sgr;
+    stream.write( text_r, len_r );
+    if ( ! sgr.empty() )
+      stream << ansi::Color::SGRReset();
+  }
+}
+
 static
 const char * lines[][3] = {
   { "|", "-", "+"},		///< Ascii
@@ -48,6 +75,26 @@ TableRow & TableRow::addDetail(const string& s)
   return *this;
 }
 
+TableRow & TableRow::addStyle( unsigned column_r, ansi::Color color_r,
+                               string::size_type offset_r, string::size_type length_r )
+{
+  Style style = { column_r, offset_r, length_r, color_r };
+  _styles.push_back( style );
+  return *this;
+}
+
+TableRow & TableRow::paint( unsigned column_r, ansi::Color color_r )
+{
+  for ( vector<Style>::iterator it = _styles.begin(); it != _styles.end(); )
+  {
+    if ( it->_column == column_r )
+      it = _styles.erase( it );
+    else
+      ++it;
+  }
+  return addStyle( column_r, color_r );
+}
+
 unsigned int TableRow::cols( void ) const {
   return _columns.size();
 }
@@ -62,42 +109,32 @@ void TableRow::dumbDumpTo (ostream &stream) const {
 
     stream << *i;
   }
-  stream << endl;
+  stream << '\n';
 }
 
 void TableRow::dumpDetails(ostream &stream, const Table & parent) const
 {
   unsigned width = parent._screen_width;
-  //string indent( parent._max_width[0] + (parent._style == none ? 2 : 3), ' ' );
-  string indent( 4, ' ' );
+  //unsigned indent = parent._max_width[0] + (parent._style == none ? 2 : 3);
+  unsigned indent = 4;
 
   for ( vector<string>::const_iterator it = _details.begin(); it != _details.end(); ++it )
   {
-    vector<string> text;
-    zypp::str::split( *it, std::back_inserter(text), "\n" );
-
-    for_( line, text.begin(), text.end() )
+    // line by line, wrapped in a single pass; empty lines are skipped
+    const char * b = it->c_str();
+    const char * e = b + it->size();
+    while ( b != e )
     {
-      unsigned int textSize = mbs_width( *line );
-      unsigned int startPos = 0;
-
-      while ( textSize > 0 )
+      const char * nl = static_cast<const char *>( ::memchr( b, '\n', e - b ) );
+      const char * eol = nl ? nl : e;
+      while ( b != eol && ( *b == ' ' || *b == '\t' ) )
+        ++b;
+      if ( b != eol )
       {
-        unsigned int endPos;
-
-        if ( textSize + indent.length() <= width )
-        {
-          stream << indent << zypp::str::ltrim( (*line).substr(startPos)) << endl;
-          break;
-        }
-        else
-        {
-          stream << indent << zypp::str::ltrim( (*line).substr(startPos, width-indent.length()) ) << endl;
-          endPos = startPos + width - indent.length();
-          textSize = mbs_width( (*line).substr( endPos ) );
-          startPos = endPos;
-        }
+        mbs_write_wrapped_range( stream, b, eol, indent, width );
+        stream << '\n';
       }
+      b = nl ? nl + 1 : e;
     }
   }
 }
@@ -113,7 +150,7 @@ void TableRow::dumpTo (ostream &stream, const Table & parent) const
     e = _columns.end ();
 
   stream.setf (ios::left, ios::adjustfield);
-  stream << string(parent._margin, ' ');
+  writeSpaces( stream, parent._margin );
   // current position at currently printed line
   int curpos = parent._margin;
   // whether to break the line now in order to wrap it to screen width
@@ -141,7 +178,8 @@ void TableRow::dumpTo (ostream &stream, const Table & parent) const
       {
         // start printing the next table columns to new line,
         // indent by 2 console columns
-        stream << endl << string(parent._margin + 2, ' ');
+        stream << '\n';
+        writeSpaces( stream, parent._margin + 2 );
         curpos = parent._margin + 2; // indent == 2
       }
       else
@@ -163,7 +201,6 @@ void TableRow::dumpTo (ostream &stream, const Table & parent) const
     }
     else
     {
-      string s(*i);
       if ( !parent._inHeader && parent.editionStyle( c ) && Zypper::instance()->config().do_colors )
       {
 	// Edition column
@@ -176,33 +213,43 @@ void TableRow::dumpTo (ostream &stream, const Table & parent) const
 						  _columns[*(++parent._editionStyle.begin())] );
 	  }
 
-	  if ( editionSep == 0 )
-	  {
-	    stream << ( ColorContext::CHANGE << s );
-	  }
-	  else if ( editionSep == s.size() )
-	  {
+	  if ( editionSep >= s.size() )
 	    stream << s;
-	  }
 	  else
 	  {
-	    stream << s.substr( 0, editionSep ) << ( ColorContext::CHANGE << s.substr( editionSep ) );
+	    stream.write( s.data(), editionSep );
+	    writeColored( stream, s.data() + editionSep, s.size() - editionSep, ColorContext::CHANGE );
 	  }
 	}
 	else
 	{
 	  // highlight edition-release separator
-	  editionSep = s.find( '-' );
-	  if ( editionSep != std::string::npos )
+	  string::size_type sep = s.find( '-' );
+	  if ( sep != std::string::npos )
 	  {
-	    stream << s.substr( 0, editionSep ) << ( ColorContext::HIGHLIGHT << "-" ) << s.substr( editionSep+1 );
+	    stream.write( s.data(), sep );
+	    writeColored( stream, s.data() + sep, 1, ColorContext::HIGHLIGHT );
+	    stream.write( s.data() + sep + 1, s.size() - sep - 1 );
 	  }
 	  else	// no release part
-	  {
 	    stream << s;
-	  }
 	}
       }
+      else if ( !_styles.empty() && !parent._inHeader )
+      {
+	// styled spans of this column, in order
+	string::size_type done = 0;
+	for_( it, _styles.begin(), _styles.end() )
+	{
+	  if ( it->_column != c || it->_offset < done || it->_offset >= s.size() )
+	    continue;
+	  string::size_type len = std::min( it->_length, s.size() - it->_offset );
+	  stream.write( s.data() + done, it->_offset - done );
+	  writeColored( stream, s.data() + it->_offset, len, it->_color );
+	  done = it->_offset + len;
+	}
+	stream.write( s.data() + done, s.size() - done );
+      }
       else	// no special style
       {
 	stream << s;
@@ -212,7 +259,7 @@ void TableRow::dumpTo (ostream &stream, const Table & parent) const
     stream << "";
     curpos += parent._max_width[c] + (parent._style == none ? 2 : 3);
   }
-  stream << endl;
+  stream << '\n';
 
   if ( !_details.empty() )
   {
@@ -240,6 +287,11 @@ Table & Table::add (const TableRow& tr) {
   return *this;
 }
 
+Table & Table::add (TableRow && tr) {
+  _rows.push_back (std::move(tr));
+  return *this;
+}
+
 Table & Table::setHeader (const TableHeader& tr) {
   _has_header = true;
   _header = tr;
@@ -301,7 +353,7 @@ void Table::dumpRule (ostream &stream) const {
       stream << hline;
     }
   }
-  stream << endl;
+  stream << '\n';
 }
 
 void Table::dumpTo (ostream &stream) const {
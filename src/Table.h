@@ -62,6 +62,18 @@ public:
 
   TableRow & addDetail (const string& s);
 
+  /** Color \a length_r bytes at \a offset_r of column \a column_r
+   * (the whole column by default). The SGR sequences are emitted when the
+   * row is printed, the column text itself stays plain. Spans of a column
+   * must be added in order and must not overlap.
+   */
+  TableRow & addStyle( unsigned column_r, ansi::Color color_r,
+                       std::string::size_type offset_r = 0,
+                       std::string::size_type length_r = std::string::npos );
+
+  /** Color the whole column \a column_r, replacing previous styles. */
+  TableRow & paint( unsigned column_r, ansi::Color color_r );
+
   template<class _Tp>
   TableRow & addDetail( const _Tp & val_r )
   { return addDetail( zypp::str::asString( val_r ) ); }
@@ -93,10 +105,21 @@ public:
   { return _columns; }
 
 private:
+  /** A colored span within a column, see \ref addStyle */
+  struct Style
+  {
+    unsigned _column;
+    std::string::size_type _offset;
+    std::string::size_type _length;
+    ansi::Color _color;
+  };
+
   container _columns;
 
   container _details;
 
+  vector<Style> _styles;
+
   friend class Table;
 };
 
@@ -133,6 +156,7 @@ public:
   static TableLineStyle defaultStyle;
 
   Table & add (const TableRow& tr);
+  Table & add (TableRow && tr);
   Table & setHeader (const TableHeader& tr);
   void dumpTo (ostream& stream) const;
   bool empty () const { return _rows.empty(); }
@@ -220,6 +244,11 @@ Table& operator << (Table& table, const TableRow& tr) {
   return table.add (tr);
 }
 
+inline
+Table& operator << (Table& table, TableRow && tr) {
+  return table.add (std::move(tr));
+}
+
 inline
 Table& operator << (Table& table, const TableHeader& tr) {
   return table.setHeader (tr);
@@ -309,9 +338,8 @@ public:
   {
     if ( cond_r )
     {
-      // FIXME re-coloring like this works ony once
-      std::string & lastval( _table.rows().back().columns().back() );
-      lastval = ColorString( lastval, color_r ).str();
+      TableRow & lastrow( _table.rows().back() );
+      lastrow.paint( lastrow.cols() - 1, color_r );
     }
     return *this;
   }
@@ -15,6 +15,7 @@
 #include <list>
 #include <map>
 #include <iterator>
+#include <cctype>
 
 #include <unistd.h>
 #include <readline/history.h>
@@ -35,8 +36,7 @@
 #include <zypp/PoolQuery.h>
 #include <zypp/Locks.h>
 #include <zypp/Edition.h>
-
-#include <zypp/target/rpm/RpmHeader.h> // for install <.rpmURI>
+#include <zypp/sat/Pool.h>
 
 #include "main.h"
 #include "Zypper.h"
@@ -55,13 +55,19 @@
 #include "misc.h"
 #include "locks.h"
 #include "search.h"
+#include "completion.h"
+#include "patch-status.h"
+#include "result-cache.h"
 #include "info.h"
 #include "download.h"
 #include "source-download.h"
+#include "transaction-plan.h"
+#include "install-roots.h"
 #include "configtest.h"
 
 #include "output/OutNormal.h"
 #include "output/OutXML.h"
+#include "output/OutJSON.h"
 
 using boost::format;
 using namespace zypp;
@@ -99,6 +105,68 @@ namespace {
 		     % old_r
 		     % new_r );
   }
+
+  /** Append the whitespace separated words of the list file \a file_r
+   * (one or more package specs per line) to \a args_r.
+   */
+  inline bool appendArgsFromFile( const std::string & file_r, Zypper::ArgList & args_r )
+  {
+    std::list<std::string> lines;
+    if ( ! read_list_file( file_r, lines ) )
+      return false;
+    for ( const std::string & line : lines )
+      str::split( line, std::back_inserter( args_r ) );
+    return true;
+  }
+
+  /** The long and short options in \a options_r, those taking an argument
+   * with a trailing '=' (see CompletionIndex).
+   */
+  std::vector<std::string> optionTableNames( const struct option * options_r )
+  {
+    std::vector<std::string> ret;
+    for ( ; options_r && options_r->name; ++options_r )
+    {
+      const char * arg = options_r->has_arg == required_argument ? "=" : "";
+      ret.push_back( std::string("--") + options_r->name + arg );
+      if ( ! options_r->flag && ::isalnum( options_r->val ) )
+	ret.push_back( std::string("-") + char(options_r->val) + arg );
+    }
+    return ret;
+  }
+
+  /** Set by getopt to 1 for \c --delete and to 0 for \c --no-delete of
+   * source-download, so the last one given wins; -1 if neither was given.
+   * Not a member of SourceDownloadOptions: the option table is static.
+   */
+  int sourceDownloadDelete = -1;
+
+  /** Commands writing all their output through \ref OutJSON (records). */
+  bool json_output_supported( const ZypperCommand & command_r )
+  {
+    switch ( command_r.toEnum() )
+    {
+    case ZypperCommand::SEARCH_e:
+    case ZypperCommand::INFO_e:
+    case ZypperCommand::RUG_PATCH_INFO_e:
+    case ZypperCommand::RUG_PATTERN_INFO_e:
+    case ZypperCommand::RUG_PRODUCT_INFO_e:
+    case ZypperCommand::LIST_REPOS_e:
+    case ZypperCommand::LIST_UPDATES_e:
+    case ZypperCommand::LIST_PATCHES_e:
+    case ZypperCommand::DOWNLOAD_e:
+    case ZypperCommand::INSTALL_e:
+    case ZypperCommand::REMOVE_e:
+    case ZypperCommand::UPDATE_e:
+    case ZypperCommand::PATCH_e:
+    case ZypperCommand::DIST_UPGRADE_e:
+    case ZypperCommand::VERIFY_e:
+    case ZypperCommand::INSTALL_NEW_RECOMMENDS_e:
+      return true;
+    default:
+      return false;
+    }
+  }
 } //namespace
 ///////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////
@@ -128,7 +196,8 @@ Zypper::Zypper()
     _command(ZypperCommand::NONE),
     _exit_code(ZYPPER_EXIT_OK),
     _running_shell(false), _running_help(false), _exit_requested(false),
-    _sh_argc(0), _sh_argv(NULL)
+    _sh_argc(0), _sh_argv(NULL),
+    _globalOptionTable(NULL), _commandOptionTable(NULL)
 {
   MIL << "Zypper instance created." << endl;
 }
@@ -156,6 +225,11 @@ Zypper::Ptr & Zypper::instance()
 
 int Zypper::main(int argc, char ** argv)
 {
+  // complete the JSON array on every way out of here
+  struct FinishOutput {
+    ~FinishOutput() { jsonout::finish(); }
+  } finish_output __attribute__ ((__unused__));
+
   _argc = argc;
   _argv = argv;
 
@@ -187,6 +261,7 @@ int Zypper::main(int argc, char ** argv)
 
   default:
     safeDoCommand();
+    finish_install_root_job(*this);
     cleanup();
     return exitCode();
   }
@@ -226,6 +301,8 @@ void print_main_help(Zypper & zypper)
     "\t\t\t\tDo not treat patches as interactive, which have\n"
     "\t\t\t\tthe rebootSuggested-flag set.\n"
     "\t--xmlout, -x\t\tSwitch to XML output.\n"
+    "\t--jsonout\t\tSwitch to JSON output (one array of records).\n"
+    "\t--ndjsonout\t\tSwitch to JSON output, one record per line.\n"
     "\t--ignore-unknown, -i\tIgnore unknown packages.\n"
   );
 
@@ -252,7 +329,8 @@ void print_main_help(Zypper & zypper)
   );
 
   static string help_global_target_options = _("     Target Options:\n"
-    "\t--root, -R <dir>\tOperate on a different root directory.\n"
+    "\t--root, -R <dir>\tOperate on a different root directory. If given\n"
+    "\t\t\t\tmore than once, install into all of them.\n"
     "\t--disable-system-resolvables\n"
     "\t\t\t\tDo not read installed packages.\n"
   );
@@ -458,12 +536,16 @@ void Zypper::processGlobalOptions()
     {"no-cd",                      no_argument,       0,  0 },
     {"no-remote",                  no_argument,       0,  0 },
     {"xmlout",                     no_argument,       0, 'x'},
+    {"jsonout",                    no_argument,       0,  0 },
+    {"ndjsonout",                  no_argument,       0,  0 },
     {"config",                     required_argument, 0, 'c'},
     {"userdata",                   required_argument, 0,  0 },
     {"ignore-unknown",             no_argument,       0, 'i'},
     {0, 0, 0, 0}
   };
 
+  _globalOptionTable = global_options;
+
   // parse global options
   parsed_opts gopts = parse_options (_argc, _argv, global_options);
   if (gopts.count("_unknown") || gopts.count("_missing_arg"))
@@ -533,10 +615,17 @@ void Zypper::processGlobalOptions()
     _gopts.machine_readable = true;
     _gopts.no_abbrev = true;
   }
+  else if (gopts.count("jsonout") || gopts.count("ndjsonout"))
+  {
+    _out_ptr = new OutJSON(verbosity, gopts.count("ndjsonout"));
+    _gopts.machine_readable = true;
+    _gopts.no_abbrev = true;
+  }
   else
   {
     OutNormal * p = new OutNormal(verbosity);
     p->setUseColors(_config.do_colors);
+    p->setProgressFrameRate(_config.progress_frameRate);
     _out_ptr = p;
   }
 
@@ -624,13 +713,21 @@ void Zypper::processGlobalOptions()
   if ((it = gopts.find("root")) != gopts.end()) {
     _gopts.root_dir = it->second.front();
     _gopts.changedRoot = true;
-    Pathname tmp(_gopts.root_dir);
-    if (!tmp.absolute())
+    for_(rit, it->second.begin(), it->second.end())
     {
-      out().error(
-        _("The path specified in the --root option must be absolute."));
-      _exit_code = ZYPPER_EXIT_ERR_INVALID_ARGS;
-      return;
+      Pathname tmp(*rit);
+      if (!tmp.absolute())
+      {
+        out().error(
+          _("The path specified in the --root option must be absolute."));
+        _exit_code = ZYPPER_EXIT_ERR_INVALID_ARGS;
+        return;
+      }
+    }
+    if (it->second.size() > 1)
+    {
+      _gopts.install_roots = it->second;
+      DBG << "install roots = " << _gopts.install_roots << endl;
     }
 
     DBG << "root dir = " << _gopts.root_dir << endl;
@@ -896,6 +993,26 @@ void Zypper::processGlobalOptions()
     }
   }
 
+  // multi-root mode
+  if (_gopts.install_roots.size() > 1)
+  {
+    if (!install_roots_supported(*this))
+    {
+      out().error(boost::str(format(
+        // TranslatorExplanation %s is "--root"
+        _("The %s option can be given more than once only for commands installing or removing packages.")) % "--root"));
+      setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+      return;
+    }
+    if (!out().typeNORMAL())
+    {
+      out().error(boost::str(format(
+        _("%s cannot be combined with more than one %s.")) % (out().typeXML() ? "--xmlout" : "--jsonout") % "--root"));
+      setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+      return;
+    }
+  }
+
   if (gopts.count("ignore-unknown"))
     _gopts.ignore_unknown = true;
 
@@ -1079,7 +1196,7 @@ void Zypper::processCommandOptions()
 {
   MIL << "START" << endl;
 
-  struct option no_options = {0, 0, 0, 0};
+  static struct option no_options = {0, 0, 0, 0};
   struct option *specific_options = &no_options;
 
   if (command() == ZypperCommand::HELP)
@@ -1148,6 +1265,8 @@ void Zypper::processCommandOptions()
       // rug compatibility, we have --auto-agree-with-licenses
       {"agree-to-third-party-licenses",  no_argument,  0,  0 },
       {"debug-solver",              no_argument,       0,  0 },
+      {"plan-out",                  required_argument, 0,  0 },
+      {"plan-in",                   required_argument, 0,  0 },
       {"no-force-resolution",       no_argument,       0, 'R'},
       {"force-resolution",          no_argument,       0,  0 },
       {"dry-run",                   no_argument,       0, 'D'},
@@ -1165,6 +1284,7 @@ void Zypper::processCommandOptions()
       {"download-as-needed",        no_argument,       0,  0 },
       // rug compatibility - will mark all packages for installation (like 'in *')
       {"entire-catalog",            required_argument, 0,  0 },
+      {"from-file",                 required_argument, 0,  0 },
       {"help",                      no_argument,       0, 'h'},
       {0, 0, 0, 0}
     };
@@ -1186,6 +1306,8 @@ void Zypper::processCommandOptions()
       "                            Default: %s.\n"
       "-n, --name                  Select packages by plain name, not by capability.\n"
       "-C, --capability            Select packages by capability.\n"
+      "    --from-file <file>      Read further packages from <file>, '-' for\n"
+      "                            standard input.\n"
       "-f, --force                 Install even if the item is already installed (reinstall),\n"
       "                            downgraded or changes vendor or architecture.\n"
       "    --oldpackage            Allow to replace a newer item with an older one.\n"
@@ -1199,6 +1321,9 @@ void Zypper::processCommandOptions()
       "                            confirmation prompt.\n"
       "                            See 'man zypper' for more details.\n"
       "    --debug-solver          Create solver test case for debugging.\n"
+      "    --plan-out <file>       Write the resolved transaction to <file>.\n"
+      "    --plan-in <file>        Commit the transaction stored in <file> without\n"
+      "                            running the solver, if it matches this system.\n"
       "    --no-recommends         Do not install recommended packages, only required.\n"
       "    --recommends            Install also recommended packages in addition\n"
       "                            to the required.\n"
@@ -1237,6 +1362,7 @@ void Zypper::processCommandOptions()
       {"details",		    no_argument,       0,  0 },
       // rug uses -N shorthand
       {"dry-run",    no_argument,       0, 'N'},
+      {"from-file",  required_argument, 0,  0 },
       {"help",       no_argument,       0, 'h'},
       {0, 0, 0, 0}
     };
@@ -1256,6 +1382,8 @@ void Zypper::processCommandOptions()
       "                            Default: %s.\n"
       "-n, --name                  Select packages by plain name, not by capability.\n"
       "-C, --capability            Select packages by capability.\n"
+      "    --from-file <file>      Read further packages from <file>, '-' for\n"
+      "                            standard input.\n"
       "    --debug-solver          Create solver test case for debugging.\n"
       "-R, --no-force-resolution   Do not force the solver to find solution,\n"
       "                            let it ask.\n"
@@ -1795,6 +1923,7 @@ void Zypper::processCommandOptions()
       {"type",        required_argument, 0, 't'},
       {"all",         no_argument,       0, 'a'},
       {"best-effort", no_argument,       0,  0 },
+      {"format",      required_argument, 0,  0 },
       {"help", no_argument, 0, 'h'},
       {0, 0, 0, 0}
     };
@@ -1816,6 +1945,8 @@ void Zypper::processCommandOptions()
       "-a, --all                     List all packages for which newer versions are\n"
       "                              available, regardless whether they are\n"
       "                              installable or not.\n"
+      "    --format <template>       Print each update using the template instead of\n"
+      "                              the table (see 'man zypper').\n"
     ), "package, patch, pattern, product", "package");
     break;
   }
@@ -1835,6 +1966,8 @@ void Zypper::processCommandOptions()
       {"agree-to-third-party-licenses",  no_argument,  0, 0},
       {"best-effort",               no_argument,       0, 0},
       {"debug-solver",              no_argument,       0, 0},
+      {"plan-out",                  required_argument, 0, 0},
+      {"plan-in",                   required_argument, 0, 0},
       {"no-force-resolution",       no_argument,       0, 'R'},
       {"force-resolution",          no_argument,       0,  0 },
       {"no-recommends",             no_argument,       0,  0 },
@@ -1854,6 +1987,7 @@ void Zypper::processCommandOptions()
       // rug-compatibility - dummy for now
       //! \todo category can now be implemented in 'patch' using PoolQuery
       {"category",                  no_argument,       0, 'g'},
+      {"from-file",                 required_argument, 0,  0 },
       {"help", no_argument, 0, 'h'},
       {0, 0, 0, 0}
     };
@@ -1871,6 +2005,8 @@ void Zypper::processCommandOptions()
       "-t, --type <type>           Type of package (%s).\n"
       "                            Default: %s.\n"
       "-r, --repo <alias|#|URI>    Load only the specified repository.\n"
+      "    --from-file <file>      Read further packages from <file>, '-' for\n"
+      "                            standard input.\n"
       "    --skip-interactive      Skip interactive updates.\n"
       "    --with-interactive      Do not skip interactive updates.\n"
       "-l, --auto-agree-with-licenses\n"
@@ -1881,6 +2017,9 @@ void Zypper::processCommandOptions()
       "                            to a lower than the latest version are\n"
       "                            also acceptable.\n"
       "    --debug-solver          Create solver test case for debugging.\n"
+      "    --plan-out <file>       Write the resolved transaction to <file>.\n"
+      "    --plan-in <file>        Commit the transaction stored in <file> without\n"
+      "                            running the solver, if it matches this system.\n"
       "    --no-recommends         Do not install recommended packages, only required.\n"
       "    --recommends            Install also recommended packages in addition\n"
       "                            to the required.\n"
@@ -1975,6 +2114,7 @@ void Zypper::processCommandOptions()
       {"category",    required_argument, 0, 'g'},
       {"date",        required_argument, 0,  0 },
       {"issues",      optional_argument, 0,  0 },
+      {"from-file",   required_argument, 0,  0 },
       {"all",         no_argument,       0, 'a'},
       {"help", no_argument, 0, 'h'},
       {0, 0, 0, 0}
@@ -1990,6 +2130,8 @@ void Zypper::processCommandOptions()
       "    --cve[=#]              List needed patches for CVE issues.\n"
       "-g  --category <category>  List all patches in this category.\n"
       "    --issues[=string]      Look for issues matching the specified string.\n"
+      "    --from-file <file>     Read Bugzilla and CVE issue numbers from a file,\n"
+      "                           one per line ('-' for standard input).\n"
       "-a, --all                  List all patches, not only the needed ones.\n"
       "-r, --repo <alias|#|URI>   List only patches from the specified repository.\n"
       "    --date <YYYY-MM-DD>    List patches issued up to the specified date\n"
@@ -2007,6 +2149,8 @@ void Zypper::processCommandOptions()
       {"replacefiles",              no_argument,       0,  0 },
       {"auto-agree-with-licenses",  no_argument,       0, 'l'},
       {"debug-solver",              no_argument,       0,  0 },
+      {"plan-out",                  required_argument, 0,  0 },
+      {"plan-in",                   required_argument, 0,  0 },
       {"dry-run",                   no_argument,       0, 'D'},
       // rug uses -N shorthand
       {"dry-run",                   no_argument,       0, 'N'},
@@ -2036,6 +2180,9 @@ void Zypper::processCommandOptions()
       "                            confirmation prompt.\n"
       "                            See man zypper for more details.\n"
       "    --debug-solver          Create solver test case for debugging\n"
+      "    --plan-out <file>       Write the resolved transaction to <file>.\n"
+      "    --plan-in <file>        Commit the transaction stored in <file> without\n"
+      "                            running the solver, if it matches this system.\n"
       "    --no-recommends         Do not install recommended packages, only required.\n"
       "    --recommends            Install also recommended packages in addition\n"
       "                            to the required.\n"
@@ -2079,6 +2226,7 @@ void Zypper::processCommandOptions()
       {"repo", required_argument, 0, 'r'},
       {"details", no_argument, 0, 's'},
       {"verbose", no_argument, 0, 'v'},
+      {"format", required_argument, 0, 0},
       {"help", no_argument, 0, 'h'},
       {0, 0, 0, 0}
     };
@@ -2113,6 +2261,8 @@ void Zypper::processCommandOptions()
       "                           on a separate line.\n"
       "-v, --verbose              Like --details, with additional information where the\n"
       "                           search has matched (useful for search in dependencies).\n"
+      "    --format <template>    Print each match using the template instead of\n"
+      "                           the table, e.g. '%{name} %{edition}\\n'.\n"
       "\n"
       "* and ? wildcards can also be used within search strings.\n"
       "If a search string is enclosed in '/', it's interpreted as a regular expression.\n"
@@ -2133,7 +2283,8 @@ void Zypper::processCommandOptions()
     _command_help = _(
       "patch-check (pchk) [options]\n"
       "\n"
-      "Check for available patches.\n"
+      "Check for available patches. The result is remembered until the installed\n"
+      "packages or the repositories change.\n"
       "\n"
       "  Command options:\n"
       "\n"
@@ -2179,6 +2330,7 @@ void Zypper::processCommandOptions()
       {"sort-by-name",		no_argument,		0, 'N'},
       {"sort-by-repo",		no_argument,		0, 'R'},
       {"sort-by-catalog",	no_argument,		0,  0 },	// TRANSLATED into sort-by-repo
+      {"format",		required_argument,	0,  0 },
       {"help",			no_argument,		0, 'h'},
       {0, 0, 0, 0}
     };
@@ -2199,6 +2351,8 @@ void Zypper::processCommandOptions()
       "    --unneeded            Show packages which are unneeded.\n"
       "-N, --sort-by-name        Sort the list by package name.\n"
       "-R, --sort-by-repo        Sort the list by repository.\n"
+      "    --format <template>   Print each package using the template instead of\n"
+      "                          the table (see 'man zypper').\n"
     );
     break;
   }
@@ -2269,6 +2423,7 @@ void Zypper::processCommandOptions()
       {"obsoletes", no_argument, 0, 0},
       {"recommends", no_argument, 0, 0},
       {"suggests", no_argument, 0, 0},
+      {"format", required_argument, 0, 0},
       {"help", no_argument, 0, 'h'},
       {0, 0, 0, 0}
     };
@@ -2292,6 +2447,8 @@ void Zypper::processCommandOptions()
         "    --obsoletes           Show obsoletes.\n"
         "    --recommends          Show recommends.\n"
         "    --suggests            Show suggests.\n"
+        "    --format <template>   Print each package using the template instead of\n"
+        "                          the property list (see 'man zypper').\n"
       ), "package, patch, pattern, product", "package");
 
     break;
@@ -2598,11 +2755,12 @@ void Zypper::processCommandOptions()
   {
     shared_ptr<DownloadOptions> myOpts( new DownloadOptions() );
     _commandOptions = myOpts;
+    // no flag pointers into myOpts: the table is static, myOpts is not
     static struct option options[] =
     {
       {"help",			no_argument,		0, 'h'},
-      {"all-matches",		no_argument,		&myOpts->_allmatches, 1},
-      {"dry-run",		no_argument,		&myOpts->_dryrun, 1},
+      {"all-matches",		no_argument,		0, 0},
+      {"dry-run",		no_argument,		0, 0},
       {0, 0, 0, 0}
     };
     specific_options = options;
@@ -2633,15 +2791,17 @@ void Zypper::processCommandOptions()
   {
     shared_ptr<SourceDownloadOptions> myOpts( new SourceDownloadOptions() );
     _commandOptions = myOpts;
+    sourceDownloadDelete = -1;
     static struct option options[] =
     {
       {"help",			no_argument, 0, 'h'},
       {"directory",		required_argument, 0, 'd'},
 //       {"manifest",		no_argument, &myOpts->_manifest, 1},
 //       {"no-manifest",		no_argument, &myOpts->_manifest, 0},
-      {"delete",		no_argument, &myOpts->_delete, 1},
-      {"no-delete",		no_argument, &myOpts->_delete, 0},
-      {"status",		no_argument, &myOpts->_dryrun, 1},
+      {"delete",		no_argument, &sourceDownloadDelete, 1},
+      {"no-delete",		no_argument, &sourceDownloadDelete, 0},
+      {"status",		no_argument, 0, 0},
+      {"jobs",			required_argument, 0, 'j'},
       {0, 0, 0, 0}
     };
     specific_options = options;
@@ -2658,6 +2818,8 @@ void Zypper::processCommandOptions()
       "--no-delete          Do not delete extraneous source rpms.\n"
       "--status             Don't download any source rpms,\n"
       "                     but show which source rpms are missing or extraneous.\n"
+      "-j, --jobs <N>       Number of source rpms to download in parallel.\n"
+      "                     Default: 1\n"
     );
 //       "--manifest           Write MANIFEST of packages and coresponding source rpms.\n"
 //       "--no-manifest        Do not write MANIFEST.\n"
@@ -2821,6 +2983,8 @@ void Zypper::processCommandOptions()
   }
   }
 
+  _commandOptionTable = specific_options;
+
   // no need to parse command options if we already know we just want help
   if (runningHelp())
     return;
@@ -2879,11 +3043,52 @@ void Zypper::processCommandOptions()
   MIL << "Done " << endl;
 }
 
+std::vector<std::string> Zypper::optionNames( const ZypperCommand & command_r )
+{
+  if ( command_r == ZypperCommand::NONE )
+    return optionTableNames( _globalOptionTable );
+
+  // run just the option setup of the command, like for its help; it may
+  // replace the command options of the running command
+  ZypperCommand command( _command );
+  bool running_help = _running_help;
+  std::string command_help( _command_help );
+  shared_ptr<Options> command_options( _commandOptions );
+  const struct option * command_option_table = _commandOptionTable;
+  setCommand( command_r );
+  setRunningHelp( true );
+  _commandOptionTable = NULL;
+  try
+  {
+    processCommandOptions();
+  }
+  catch ( const Exception & e )
+  {
+    ZYPP_CAUGHT( e );
+  }
+  std::vector<std::string> ret( optionTableNames( _commandOptionTable ) );
+  setCommand( command );
+  setRunningHelp( running_help );
+  _command_help.swap( command_help );
+  _commandOptions = command_options;
+  _commandOptionTable = command_option_table;
+  return ret;
+}
+
 /// process one command from the OS shell or the zypper shell
 void Zypper::doCommand()
 {
   if (runningHelp()) { out().info(_command_help, Out::QUIET); return; }
 
+  // other commands would print plain text into the JSON stream
+  if (out().typeJSON() && !json_output_supported(command()))
+  {
+    out().error(boost::str(format(
+      _("JSON output is not supported for the '%s' command.")) % command().asString()));
+    setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+    return;
+  }
+
   // === ZYpp lock ===
   switch ( command().toEnum() )
   {
@@ -3630,6 +3835,10 @@ void Zypper::doCommand()
     }
     initRepoManager();
     refresh_repos(*this);
+    if (exitCode() == ZYPPER_EXIT_OK && _arguments.empty() && !copts.count("repo"))
+      update_patch_status_snapshot(*this);
+    if (exitCode() == ZYPPER_EXIT_OK)
+      update_completion_index(*this);
     break;
   }
 
@@ -3660,7 +3869,16 @@ void Zypper::doCommand()
   {
     if (runningHelp()) { out().info(_command_help, Out::QUIET); return; }
 
-    if (_arguments.size() < 1 && !_copts.count("entire-catalog"))
+    if (_copts.count("from-file")
+        && !appendArgsFromFile(_copts["from-file"].back(), _arguments))
+    {
+      out().error(boost::str(format(_("Cannot read packages from '%s'.")) % _copts["from-file"].back()));
+      setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+      return;
+    }
+
+    // with --plan-in the plan names the packages
+    if (_arguments.size() < 1 && !_copts.count("entire-catalog") && !_copts.count("plan-in"))
     {
       out().error(
           _("Too few arguments."),
@@ -3724,13 +3942,22 @@ void Zypper::doCommand()
       throw ExitRequestException("not implemented");
     }
 
+    // the plan already defines the whole transaction
+    if (copts.count("plan-in") && !_arguments.empty())
+    {
+      out().error(str::form(_("Package arguments cannot be used together with '%s'."), "--plan-in"));
+      setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+      return;
+    }
+
     // parse the download options to check for errors
     get_download_option(*this);
 
     initRepoManager();
 
     // check for rpm files among the arguments
-    ArgList rpms_files_caps;
+    std::string rpm_cache_dir((_gopts.root_dir != "/" ? _gopts.root_dir : "") + ZYPPER_RPM_CACHE_DIR);
+    std::set<std::string> rpms_files;
     if (install_not_remove)
     {
       for (vector<string>::iterator it = _arguments.begin();
@@ -3744,11 +3971,8 @@ void Zypper::doCommand()
             Out::HIGH);
 
           // download the rpm into the cache
-          //! \todo do we want this or a tmp dir? What about the files cached before?
           //! \todo optimize: don't mount the same media multiple times for each rpm
-          Pathname rpmpath = cache_rpm(*it,
-              (_gopts.root_dir != "/" ? _gopts.root_dir : "")
-              + ZYPPER_RPM_CACHE_DIR);
+          Pathname rpmpath = cache_rpm(*it, rpm_cache_dir);
 
           if (rpmpath.empty())
           {
@@ -3758,29 +3982,9 @@ void Zypper::doCommand()
           }
           else
           {
-            using target::rpm::RpmHeader;
-            // rpm header (need name-version-release)
-            RpmHeader::constPtr header =
-              RpmHeader::readPackage(rpmpath, RpmHeader::NOSIGNATURE);
-            if (header)
-            {
-              string nvrcap =
-                TMP_RPM_REPO_ALIAS ":" +
-                header->tag_name() + "=" +
-                str::numstring(header->tag_epoch()) + ":" +
-                header->tag_version() + "-" +
-                header->tag_release();
-              DBG << "rpm package capability: " << nvrcap << endl;
-
-              // store the rpm file capability string (name=version-release)
-              rpms_files_caps.push_back(nvrcap);
-            }
-            else
-            {
-              out().error(boost::str(format(
-                _("Problem reading the RPM header of %s. Is it an RPM file?"))
-                  % *it));
-            }
+            // The rpm header is read just once, when building the
+            // temporary repo. The capability is taken from the pool.
+            rpms_files.insert(rpmpath.basename());
           }
 
           // remove this rpm argument
@@ -3791,15 +3995,22 @@ void Zypper::doCommand()
       }
     }
 
-    // if there were some rpm files, add the rpm cache as a temporary plaindir repo
-    if (!rpms_files_caps.empty())
+    // if there were some rpm files, add them as a temporary plaindir repo
+    if (!rpms_files.empty())
     {
+      // The repo is built upon a private directory holding links to just
+      // the requested rpms. Other rpms in the cache don't inflate it, and
+      // the links go away along with tmpdir.
+      Pathname batchdir(runtimeData().tmpdir.path() / "RPMS");
+      filesystem::assert_dir(batchdir);
+      for_(it, rpms_files.begin(), rpms_files.end())
+        if (filesystem::hardlinkCopy(Pathname(rpm_cache_dir) / *it, batchdir / *it) != 0)
+          WAR << "Failed to link " << *it << " into " << batchdir << endl;
+
       // add a plaindir repo
       RepoInfo repo;
       repo.setType(repo::RepoType::RPMPLAINDIR);
-      repo.addBaseUrl(Url("dir://"
-          + (_gopts.root_dir != "/" ? _gopts.root_dir : "")
-          + ZYPPER_RPM_CACHE_DIR));
+      repo.addBaseUrl(Url("dir://" + batchdir.asString()));
       repo.setEnabled(true);
       repo.setAutorefresh(true);
       repo.setAlias(TMP_RPM_REPO_ALIAS);
@@ -3807,7 +4018,7 @@ void Zypper::doCommand()
       repo.setKeepPackages(false);
       // empty packages path would cause unwanted removal of installed rpms
       // in current working directory (bnc #445504)
-      // OTOH packages path == ZYPPER_RPM_CACHE_DIR (the same as repo URI)
+      // OTOH packages path == the repo URI (batchdir)
       // causes cp file thesamefile, which fails silently. This may be worth
       // fixing in libzypp.
       repo.setPackagesPath(runtimeData().tmpdir);
@@ -3818,7 +4029,7 @@ void Zypper::doCommand()
       refresh_repo(*this, repo);
     }
     // no rpms and no other arguments either
-    else if (_arguments.empty())
+    else if (_arguments.empty() && !copts.count("plan-in"))
     {
       out().error(_("No valid arguments specified."));
       setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
@@ -3848,6 +4059,13 @@ void Zypper::doCommand()
     init_target(*this);
     // load metadata
     load_resolvables(*this);
+
+    if (apply_transaction_plan_if_requested(*this))
+    {
+      solve_and_commit(*this);
+      break;
+    }
+
     // needed to compute status of PPP
     resolve(*this);
 
@@ -3895,8 +4113,29 @@ void Zypper::doCommand()
       sr.install(args);
     else
       sr.remove(args);
-    PackageArgs rpm_args(rpms_files_caps);
-    sr.install(rpm_args);
+    if (!rpms_files.empty())
+    {
+      // capabilities (name=version-release) of the rpm files
+      ArgList rpms_files_caps;
+      Repository tmprepo(sat::Pool::instance().reposFind(TMP_RPM_REPO_ALIAS));
+      for_(it, tmprepo.solvablesBegin(), tmprepo.solvablesEnd())
+      {
+        if (!rpms_files.erase(it->lookupLocation().filename().basename()))
+          continue;
+        string nvrcap = str::Str() << TMP_RPM_REPO_ALIAS ":" << it->name() << "=" << it->edition();
+        DBG << "rpm package capability: " << nvrcap << endl;
+        rpms_files_caps.push_back(nvrcap);
+      }
+      for_(it, rpms_files.begin(), rpms_files.end())
+      {
+        // not picked up by the temporary repo
+        out().error(boost::str(format(
+          _("Problem reading the RPM header of %s. Is it an RPM file?"))
+            % *it));
+      }
+      PackageArgs rpm_args(rpms_files_caps);
+      sr.install(rpm_args);
+    }
 
     sr.printFeedback(out());
 
@@ -4053,12 +4292,13 @@ void Zypper::doCommand()
     if (exitCode() != ZYPPER_EXIT_OK)
       return;
 
-    // add available repos to query
+    // available repos to search (added to the query after it is set up)
+    std::set<std::string> searchRepos;
     if (cOpts().count("repo"))
     {
       std::list<zypp::RepoInfo>::const_iterator repo_it;
       for (repo_it = _rdata.repos.begin();repo_it != _rdata.repos.end();++repo_it){
-        query.addRepo( repo_it->alias());
+        searchRepos.insert( repo_it->alias());
         if (! repo_it->enabled())
         {
           out().warning(boost::str(format(
@@ -4069,6 +4309,20 @@ void Zypper::doCommand()
     }
 
     bool details = _copts.count("details") || _copts.count("verbose");
+    // dependencies searched in; exact searches only in these and the file
+    // lists are answered from the repo indexes (see evaluate_query_indexed)
+    std::vector<Dep> depSearch;
+    if (copts.count("provides"))	depSearch.push_back( Dep::PROVIDES );
+    if (copts.count("requires"))	depSearch.push_back( Dep::REQUIRES );
+    if (copts.count("recommends"))	depSearch.push_back( Dep::RECOMMENDS );
+    if (copts.count("suggests"))	depSearch.push_back( Dep::SUGGESTS );
+    if (copts.count("conflicts"))	depSearch.push_back( Dep::CONFLICTS );
+    if (copts.count("obsoletes"))	depSearch.push_back( Dep::OBSOLETES );
+    std::vector<Capability> depSpecs;
+    std::vector<string> fileSpecs;
+    bool indexable = ( ! depSearch.empty() || copts.count("file-list") )
+                  && ! copts.count("name")
+                  && ! cOpts().count("search-descriptions");
     // add argument strings and attributes to query
     for ( vector<string>::const_iterator it = _arguments.begin();
           it != _arguments.end(); ++it )
@@ -4091,6 +4345,16 @@ void Zypper::doCommand()
         query.setMatchRegex();
       }
 
+      if ( query.matchRegex() || query.matchGlob() || name.find_first_of("?*") != string::npos )
+        indexable = false;
+      depSpecs.push_back( cap );
+      if ( copts.count("file-list") || ( copts.count("provides") && ! name.empty() && name[0] == '/' ) )
+      {
+        if ( cap.detail().isVersioned() )
+          indexable = false;
+        fileSpecs.push_back( name );
+      }
+
       zypp::sat::SolvAttr attr = sat::SolvAttr::name;
 
       if (copts.count("provides"))
@@ -4155,18 +4419,85 @@ void Zypper::doCommand()
       }
     }
 
+    std::unique_ptr<SolvableFormat> qformat( get_solvable_format(*this) );
+    if ( qformat && !qformat->valid() )
+      return;
+
     init_target(*this);
 
+    // repeated searches on an unchanged system are answered from the cache
+    ResultCache cache(*this);
+    if (cache.replay())
+      break;
+
     // now load resolvables:
     load_resolvables(*this);
     // needed to compute status of PPP
     resolve(*this);
+    cache.capture();
+
+    // Matching summaries and descriptions is CPU bound: let forked jobs
+    // evaluate the query on ranges of repos (see evaluate_query_parallel).
+    std::vector<sat::Solvable> matches;
+    bool evaluated = cOpts().count("search-descriptions")
+                  && ! _copts.count("verbose")
+                  && command() != ZypperCommand::RUG_PATCH_SEARCH
+                  && evaluate_query_parallel( query, searchRepos, matches );
+    // Exact dependency and file searches look up the candidates in the
+    // repo indexes instead of scanning all dependencies and file lists.
+    if ( ! evaluated )
+    {
+      evaluated = indexable && query.matchExact() && !query.matchWord()
+                && ! _copts.count("verbose")
+                && command() != ZypperCommand::RUG_PATCH_SEARCH
+                && evaluate_query_indexed( *this, query, depSpecs, depSearch, fileSpecs, searchRepos, matches );
+    }
+    if ( ! evaluated )
+    {
+      for ( const auto & alias : searchRepos )
+        query.addRepo( alias );
+    }
 
     Table t;
     t.lineStyle(Ascii);
 
     try
     {
+      if ((!out().typeNORMAL() || qformat) && command() != ZypperCommand::RUG_PATCH_SEARCH)
+      {
+        // stream the result while iterating the query
+        SearchResultWriter writer(out(), qformat.get());
+        if (_gopts.is_rug_compatible || details)
+        {
+          FillSearchTableSolvable callback(t, inst_notinst, &writer);
+          if ( _copts.count("verbose") )
+          {
+            for_( it, query.begin(), query.end() )
+              callback( it );
+          }
+          else if ( evaluated )
+            invokeOnEachSelectable( matches, callback );
+          else
+            invokeOnEach(query.selectableBegin(), query.selectableEnd(), callback);
+        }
+        else
+        {
+          FillSearchTableSelectable callback(t, inst_notinst, &writer);
+          if ( evaluated )
+            invokeOnEachSelectable( matches, callback );
+          else
+            invokeOnEach(query.selectableBegin(), query.selectableEnd(), callback);
+        }
+        writer.close();
+
+        if (!writer.count())
+        {
+          out().info(_("No packages found."), Out::QUIET);
+          setExitCode(ZYPPER_EXIT_INF_CAP_NOT_FOUND);
+        }
+        break;
+      }
+
       if (command() == ZypperCommand::RUG_PATCH_SEARCH)
       {
         FillPatchesTable callback(t, inst_notinst);
@@ -4182,13 +4513,18 @@ void Zypper::doCommand()
 	  for_( it, query.begin(), query.end() )
 	    callback( it );
 	}
+	else if ( evaluated )
+	  invokeOnEachSelectable( matches, callback );
 	else
 	  invokeOnEach(query.selectableBegin(), query.selectableEnd(), callback);
       }
       else
       {
         FillSearchTableSelectable callback(t, inst_notinst);
-        invokeOnEach(query.selectableBegin(), query.selectableEnd(), callback);
+        if ( evaluated )
+          invokeOnEachSelectable( matches, callback );
+        else
+          invokeOnEach(query.selectableBegin(), query.selectableEnd(), callback);
       }
 
       if (t.empty())
@@ -4242,6 +4578,7 @@ void Zypper::doCommand()
       setExitCode(ZYPPER_EXIT_ERR_ZYPP);
     }
 
+    cache.store();
     break;
   }
 
@@ -4267,14 +4604,23 @@ void Zypper::doCommand()
     if (exitCode() != ZYPPER_EXIT_OK)
       return;
 
-    // TODO calc token?
+    // answer from the snapshot if neither rpmdb nor repos changed since
+    PatchStatusSnapshot snapshot(*this);
+    PatchStatus status;
+    if (!snapshot.read(status))
+    {
+      // now load resolvables:
+      load_resolvables(*this);
+      // needed to compute status of PPP
+      resolve(*this);
 
-    // now load resolvables:
-    load_resolvables(*this);
-    // needed to compute status of PPP
-    resolve(*this);
+      status = PatchStatus::fromPool();
+      // keep the snapshot for the whole system only
+      if (!copts.count("repo") && !copts.count("catalog"))
+        snapshot.write(status);
+    }
 
-    patch_check();
+    patch_check(status);
 
     if (_rdata.security_patches_count > 0)
     {
@@ -4299,6 +4645,10 @@ void Zypper::doCommand()
   {
     if (runningHelp()) { out().info(_command_help, Out::QUIET); return; }
 
+    std::unique_ptr<SolvableFormat> qformat( get_solvable_format(*this) );
+    if ( qformat && !qformat->valid() )
+      return;
+
     initRepoManager();
 
     init_target(*this);
@@ -4323,7 +4673,7 @@ void Zypper::doCommand()
       list_patterns(*this);
       break;
     case ZypperCommand::PACKAGES_e:
-      list_packages(*this);
+      list_packages(*this, qformat.get());
       break;
     case ZypperCommand::PRODUCTS_e:
       list_products(*this);
@@ -4424,29 +4774,60 @@ void Zypper::doCommand()
         Out::HIGH);
     }
 
-    if ((copts.count("bugzilla") || copts.count("bz") || copts.count("cve")) &&
-        copts.count("issues"))
+    if ((copts.count("bugzilla") || copts.count("bz") || copts.count("cve")
+         || copts.count("from-file")) && copts.count("issues"))
     {
       out().error(str::form(
-        _("Cannot use %s together with %s."), "--issues", "--bz, --cve"));
+        _("Cannot use %s together with %s."), "--issues", "--bz, --cve, --from-file"));
       setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
       return;
     }
 
+    // --from-file: as if the numbers were given as --cve and --bz
+    if (copts.count("from-file"))
+    {
+      std::list<std::string> cves;
+      std::list<std::string> bugs;
+      const std::string & file(copts["from-file"].back());
+      if (!read_issue_numbers(file, cves, bugs))
+      {
+        out().error(boost::str(format(_("Cannot read issue numbers from '%s'.")) % file));
+        setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+        return;
+      }
+      if (!cves.empty())
+        _copts["cve"].splice(_copts["cve"].end(), cves);
+      if (!bugs.empty())
+        _copts["bz"].splice(_copts["bz"].end(), bugs);
+      ::copts = _copts;
+    }
+
+    std::unique_ptr<SolvableFormat> qformat( get_solvable_format(*this) );
+    if ( qformat && !qformat->valid() )
+      return;
+
     initRepoManager();
     init_target(*this);
     init_repos(*this);
     if (exitCode() != ZYPPER_EXIT_OK)
       return;
+
+    // automation polling an unchanged system is answered from the cache
+    ResultCache cache(*this);
+    if (cache.replay())
+      break;
+
     load_resolvables(*this);
     resolve(*this);
+    cache.capture();
 
-    if (copts.count("bugzilla") || copts.count("bz")
-        || copts.count("cve") || copts.count("issues"))
+    if (copts.count("bugzilla") || copts.count("bz") || copts.count("cve")
+        || copts.count("issues") || copts.count("from-file"))
       list_patches_by_issue(*this);
     else
-      list_updates(*this, kinds, best_effort);
+      list_updates(*this, kinds, best_effort, qformat.get());
 
+    cache.store();
     break;
   }
 
@@ -4466,6 +4847,14 @@ void Zypper::doCommand()
       return;
     }
 
+    if (_copts.count("from-file")
+        && !appendArgsFromFile(_copts["from-file"].back(), _arguments))
+    {
+      out().error(boost::str(format(_("Cannot read packages from '%s'.")) % _copts["from-file"].back()));
+      setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+      return;
+    }
+
     // too many arguments
     if (!_arguments.empty() && command() == ZypperCommand::PATCH)
     {
@@ -4540,6 +4929,14 @@ void Zypper::doCommand()
       return;
     }
 
+    // the plan already defines the whole transaction
+    if (copts.count("plan-in") && !_arguments.empty())
+    {
+      out().error(str::form(_("Package arguments cannot be used together with '%s'."), "--plan-in"));
+      setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+      return;
+    }
+
     bool best_effort = copts.count( "best-effort" );
     if (globalOpts().is_rug_compatible && best_effort)
     {
@@ -4565,6 +4962,13 @@ void Zypper::doCommand()
       return;
 
     load_resolvables(*this);
+
+    if (apply_transaction_plan_if_requested(*this))
+    {
+      solve_and_commit(*this);
+      break;
+    }
+
     resolve(*this); // needed to compute status of PPP
 
 
@@ -4704,6 +5108,7 @@ void Zypper::doCommand()
       return;
     load_resolvables(*this);
 
+    apply_transaction_plan_if_requested(*this);
     solve_and_commit(*this);
 
     break;
@@ -4754,6 +5159,10 @@ void Zypper::doCommand()
       }
     }
 
+    std::unique_ptr<SolvableFormat> qformat( get_solvable_format(*this) );
+    if ( qformat && !qformat->valid() )
+      return;
+
     initRepoManager();
     init_target(*this);
     init_repos(*this);
@@ -4763,7 +5172,7 @@ void Zypper::doCommand()
     // needed to compute status of PPP
     resolve(*this);
 
-    printInfo(*this, kind);
+    printInfo(*this, kind, qformat.get());
 
     return;
   }
@@ -5077,6 +5486,9 @@ void Zypper::doCommand()
 
     shared_ptr<DownloadOptions> myOpts( assertCommandOptions<DownloadOptions>() );
 
+    if ( _copts.count( "all-matches" ) )
+      myOpts->_allmatches = true;
+
     if ( _copts.count( "dry-run" ) )
       myOpts->_dryrun = true;
 
@@ -5101,9 +5513,24 @@ void Zypper::doCommand()
     if ( _copts.count( "directory" ) )
       myOpts->_directory = _copts["directory"].back();	// last wins
 
-    if ( _copts.count( "dry-run" ) )
+    if ( sourceDownloadDelete >= 0 )
+      myOpts->_delete = sourceDownloadDelete;	// last wins
+
+    if ( _copts.count( "status" ) || _copts.count( "dry-run" ) )
       myOpts->_dryrun = true;
 
+    if ( _copts.count( "jobs" ) )
+    {
+      const std::string & arg( _copts["jobs"].back() );	// last wins
+      myOpts->_jobs = str::strtonum<unsigned>( arg );
+      if ( ! myOpts->_jobs )
+      {
+	out().error( boost::format(_("Invalid number of jobs '%s'.")) % arg );
+	setExitCode( ZYPPER_EXIT_ERR_INVALID_ARGS );
+	return;
+      }
+    }
+
     sourceDownload( *this );
 
     break;
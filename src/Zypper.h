@@ -101,6 +101,8 @@ struct GlobalOptions
   /** Whether to ignore remote (http, ...) repos */
   bool no_remote;
   std::string root_dir;
+  /** All roots if --root was given more than once (multi-root mode), empty otherwise. */
+  std::list<std::string> install_roots;
   zypp::RepoManagerOptions rm_options;
   bool no_abbrev;
   bool terse;
@@ -221,6 +223,11 @@ public:
 
   void cleanup();
 
+  /** Names of the options of \a command_r, or of the global options for
+   * \c ZypperCommand::NONE (for the completion index, see CompletionIndex).
+   */
+  std::vector<std::string> optionNames( const ZypperCommand & command_r );
+
 public:
    /** Flags for tuning \ref defaultLoadSystem. */
   enum _LoadSystemFlags
@@ -297,6 +304,10 @@ private:
   int _sh_argc;
   char **_sh_argv;
 
+  /** Option tables of the global options and the current command. */
+  const struct option * _globalOptionTable;
+  const struct option * _commandOptionTable;
+
   /** Command specific options (see also _copts). */
   shared_ptr<Options>  _commandOptions;
 };
@@ -4,8 +4,9 @@
 # Major rewrite by Josef Reidinger <jreidinger@suse.cz>
 # 2009/02/19 Allow empty spaces in repos names, Werner Fink <werner@suse.de>
 #
-# some TODOs:
-# - complete package names for install/remove/update
+# Completions are answered by 'zypper --complete' from the completion index
+# written by 'zypper refresh' and commits, which also knows package names.
+# Without an index the options are dug from the help texts.
 
 _strip()
 {
@@ -37,6 +38,15 @@ _zypper() {
 	# Do not expand `?' for help
 	set -o noglob
 
+	# the completion index needs neither the full zypper startup nor the pool
+	local reply
+	if reply=$(LC_ALL=POSIX $ZYPPER --complete "${COMP_WORDS[@]:1:COMP_CWORD}" 2>/dev/null) ; then
+		COMPREPLY=($reply)
+		_strip
+		eval $noglob
+		return 0
+	fi
+
 	if test ${#ZYPPER_CMDLIST[@]} -eq 0; then
 		ZYPPER_CMDLIST=($(LC_ALL=POSIX $ZYPPER -q -h | \
 				sed -rn '/^[[:blank:]]*Commands:/,$ {
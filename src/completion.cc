@@ -0,0 +1,169 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <set>
+
+#include <zypp/base/Logger.h>
+#include <zypp/PathInfo.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/ResPool.h>
+#include <zypp/Package.h>
+
+#include "Zypper.h"
+#include "utils/completion.h"
+#include "completion.h"
+
+using namespace zypp;
+
+namespace
+{
+  bool readFile( const std::string & file_r, std::string & data_r )
+  {
+    std::ifstream str( file_r.c_str(), std::ios::binary );
+    if ( ! str )
+      return false;
+    data_r.assign( std::istreambuf_iterator<char>( str ), std::istreambuf_iterator<char>() );
+    return true;
+  }
+
+  /** The space separated \a names_r, as in the package lines of the index. */
+  std::string joinNames( const std::set<std::string> & names_r )
+  {
+    std::string ret;
+    for ( const std::string & name : names_r )
+    {
+      if ( ! ret.empty() )
+	ret += ' ';
+      ret += name;
+    }
+    return ret;
+  }
+} // namespace
+
+std::set<std::string> package_names_after_commit()
+{
+  std::set<std::string> ret;
+  ResPool pool( ResPool::instance() );
+  for_( it, pool.byKindBegin<Package>(), pool.byKindEnd<Package>() )
+  {
+    const ResStatus & status( it->status() );
+    if ( status.isInstalled() ? ! status.isToBeUninstalled() : status.isToBeInstalled() )
+      ret.insert( (*it)->name() );
+  }
+  return ret;
+}
+
+void update_completion_index( Zypper & zypper, const std::set<std::string> * installed_r )
+{
+  Pathname file( zypper.globalOpts().rm_options.repoCachePath / "completion" );
+  CompletionIndex index;
+  {
+    std::string data;
+    CompletionIndex old;
+    if ( readFile( file.asString(), data ) && old.parse( data ) )
+      index.packages.swap( old.packages );
+  }
+
+  index.global_options = zypper.optionNames( ZypperCommand::NONE );
+  for ( int cmd = ZypperCommand::NONE_e + 1; cmd <= ZypperCommand::MOO_e; ++cmd )
+  {
+    ZypperCommand command( static_cast<ZypperCommand::Command>( cmd ) );
+    if ( command == ZypperCommand::SHELL_QUIT )
+      continue;
+    CompletionIndex::Command entry;
+    entry.names = command.names();
+    if ( command != ZypperCommand::HELP )	// would print the help
+      entry.options = zypper.optionNames( command );
+    index.commands.push_back( entry );
+  }
+
+  std::set<std::string> known;
+  known.insert( sat::Pool::instance().systemRepoAlias() );
+  for ( const auto & repo : zypper.repoManager().knownRepositories() )
+  {
+    index.repos.push_back( repo.alias() );
+    if ( repo.enabled() )
+      known.insert( repo.alias() );
+  }
+  for ( const auto & service : zypper.repoManager().knownServices() )
+    index.services.push_back( service.alias() );
+
+  for_( it, sat::Pool::instance().reposBegin(), sat::Pool::instance().reposEnd() )
+  {
+    std::set<std::string> names;
+    for_( solv, it->solvablesBegin(), it->solvablesEnd() )
+    {
+      if ( solv->isKind( ResKind::package ) )
+	names.insert( solv->name() );
+    }
+    index.packages[it->alias()] = joinNames( names );
+  }
+  if ( installed_r )
+    index.packages[sat::Pool::instance().systemRepoAlias()] = joinNames( *installed_r );
+  for ( auto it = index.packages.begin(); it != index.packages.end(); )
+  {
+    if ( known.count( it->first ) )
+      ++it;
+    else
+      index.packages.erase( it++ );	// removed or disabled repo
+  }
+
+  Pathname tmpfile( file.extend( ".new" ) );
+  {
+    std::ofstream str( tmpfile.c_str() );
+    str << index.asString();
+    if ( ! str )
+    {
+      DBG << "Cannot write " << file << endl;	// e.g. not root
+      str.close();
+      filesystem::unlink( tmpfile );
+      return;
+    }
+  }
+  if ( filesystem::rename( tmpfile, file ) != 0 )
+  {
+    WAR << "Cannot write " << file << endl;
+    filesystem::unlink( tmpfile );
+    return;
+  }
+  MIL << "Wrote completion index " << file << endl;
+}
+
+int complete_command_line( int argc_r, char ** argv_r )
+{
+  std::vector<std::string> words( argv_r, argv_r + argc_r );
+  if ( words.empty() )
+    words.push_back( "" );
+
+  std::string root;
+  std::string cache;
+  for ( unsigned i = 0; i + 1 < words.size(); ++i )
+  {
+    const std::string & word( words[i] );
+    if ( ( word == "--root" || word == "-R" ) && i + 2 < words.size() )
+      root = words[i+1];
+    else if ( word.compare( 0, 7, "--root=" ) == 0 )
+      root = word.substr( 7 );
+    else if ( ( word == "--cache-dir" || word == "-C" ) && i + 2 < words.size() )
+      cache = words[i+1];
+    else if ( word.compare( 0, 12, "--cache-dir=" ) == 0 )
+      cache = word.substr( 12 );
+  }
+  std::string file( cache.empty() ? root + "/var/cache/zypp/completion" : cache + "/completion" );
+
+  std::string data;
+  CompletionIndex index;
+  if ( ! readFile( file, data ) || ! index.parse( data ) )
+    return 1;
+
+  for ( const std::string & candidate : index.complete( words ) )
+    std::cout << candidate << '\n';
+  return 0;
+}
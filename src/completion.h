@@ -0,0 +1,49 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/**
+ * Shell completion without starting the full zypper.
+ *
+ * \c refresh and \c commit write a completion index (see CompletionIndex)
+ * to <tt>[repoCachePath]/completion</tt>: the commands and their options,
+ * the repo and service aliases and the package names of each repo. The
+ * bash completion asks <tt>zypper --complete <words></tt>, which reads
+ * only that file and prints the candidates for the last word.
+ */
+#ifndef ZYPPER_COMPLETION_H
+#define ZYPPER_COMPLETION_H
+
+#include <set>
+#include <string>
+
+class Zypper;
+
+/** The names of the packages installed once the transaction set up in the
+ * pool is committed. Call it before the commit, which unloads @System from
+ * the pool (or reloads it in the shell).
+ */
+std::set<std::string> package_names_after_commit();
+
+/** Write the completion index. Package names are taken from the repos
+ * loaded in the pool and kept from the previous index for the other
+ * enabled repos; those of removed and disabled repos are dropped. The
+ * names installed after a commit are passed in \a installed_r instead of
+ * reloading @System.
+ * Failing to write it (e.g. not root) is only logged.
+ */
+void update_completion_index( Zypper & zypper, const std::set<std::string> * installed_r = nullptr );
+
+/** The \c --complete entry point: print the candidates completing the last
+ * of the words in \a argv_r (the command line after \c zypper up to the
+ * word being completed), one per line. The index is looked up below
+ * \c --root or \c --cache-dir if given there.
+ *
+ * \return 0, or 1 if there is no index.
+ */
+int complete_command_line( int argc_r, char ** argv_r );
+
+#endif // ZYPPER_COMPLETION_H
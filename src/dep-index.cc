@@ -0,0 +1,141 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+
+#include <zypp/base/Logger.h>
+#include <zypp/Capabilities.h>
+
+#include "Zypper.h"
+#include "dep-index.h"
+
+using namespace zypp;
+
+///////////////////////////////////////////////////////////////////
+namespace
+{
+  /** The dependencies indexed. */
+  const Dep indexedDeps[] = {
+    Dep::PROVIDES, Dep::REQUIRES, Dep::CONFLICTS, Dep::OBSOLETES,
+    Dep::RECOMMENDS, Dep::SUGGESTS, Dep::SUPPLEMENTS, Dep::ENHANCES
+  };
+
+  /** Case insensitive FNV-1a hash of \a name_r. */
+  uint32_t nameHash( const char * name_r )
+  {
+    uint32_t hash = 2166136261U;
+    for ( ; *name_r; ++name_r )
+    {
+      unsigned char ch = *name_r;
+      hash ^= ( ch >= 'A' && ch <= 'Z' ) ? ch - 'A' + 'a' : ch;
+      hash *= 16777619U;
+    }
+    return hash;
+  }
+} // namespace
+///////////////////////////////////////////////////////////////////
+
+struct DepIndex::Name
+{
+  uint32_t _hash;
+  uint32_t _first;	//< index of the first posting
+};
+
+DepIndex::DepIndex( const Repository & repo_r )
+  : RepoIndex( repo_r, "ZYDEPIX2" )
+  , _names( nullptr )
+  , _postings( nullptr )
+  , _nameCount( 0 )
+  , _postingCount( 0 )
+{}
+
+std::unique_ptr<DepIndex> DepIndex::forRepo( Zypper & zypper, const Repository & repo_r )
+{
+  std::unique_ptr<DepIndex> ret( new DepIndex( repo_r ) );
+  if ( ! ret->load( zypper, "zypper-depindex" ) )
+    ret.reset();
+  return ret;
+}
+
+bool DepIndex::attach( const char * data_r, std::size_t size_r )
+{
+  if ( size_r < 2 * sizeof(uint32_t) )
+    return false;
+  const uint32_t * counts = reinterpret_cast<const uint32_t *>( data_r );
+  if ( uint64_t(size_r) != 2 * sizeof(uint32_t) + uint64_t(counts[0]) * sizeof(Name) + uint64_t(counts[1]) * sizeof(uint32_t) )
+    return false;
+
+  const Name * names = reinterpret_cast<const Name *>( counts + 2 );
+  const uint32_t * postings = reinterpret_cast<const uint32_t *>( names + counts[0] );
+  // offsets in the tables are checked when looked up
+
+  _nameCount = counts[0];
+  _postingCount = counts[1];
+  _names = names;
+  _postings = postings;
+  return true;
+}
+
+void DepIndex::build( std::string & data_r )
+{
+  std::vector<std::pair<uint32_t,uint32_t> > entries;	// hash, posting
+  entries.reserve( _repo.solvablesSize() * 8 );
+  for_( it, _repo.solvablesBegin(), _repo.solvablesEnd() )
+  {
+    uint32_t off = offset( *it );
+    for ( const Dep & dep : indexedDeps )
+    {
+      for ( const Capability & cap : it->dep( dep ) )
+      {
+	CapDetail detail( cap.detail() );
+	if ( detail.isSimple() )
+	  entries.push_back( std::make_pair( nameHash( detail.name().c_str() ), ( off << 4 ) | dep.inSwitch() ) );
+      }
+    }
+  }
+  std::sort( entries.begin(), entries.end() );
+  entries.erase( std::unique( entries.begin(), entries.end() ), entries.end() );
+
+  std::vector<Name> names;
+  for ( uint32_t idx = 0; idx < entries.size(); ++idx )
+  {
+    if ( names.empty() || names.back()._hash != entries[idx].first )
+      names.push_back( Name{ entries[idx].first, idx } );
+  }
+
+  uint32_t counts[2] = { uint32_t(names.size()), uint32_t(entries.size()) };
+  data_r.reserve( data_r.size() + sizeof(counts) + names.size() * sizeof(Name) + entries.size() * sizeof(uint32_t) );
+  data_r.append( reinterpret_cast<const char *>( counts ), sizeof(counts) );
+  data_r.append( reinterpret_cast<const char *>( names.data() ), names.size() * sizeof(Name) );
+  for ( const auto & entry : entries )
+    data_r.append( reinterpret_cast<const char *>( &entry.second ), sizeof(entry.second) );
+  MIL << "Indexed " << names.size() << " dependency names of " << _repo.alias() << endl;
+}
+
+void DepIndex::lookup( const std::string & name_r, unsigned deps_r, std::vector<sat::Solvable> & result_r ) const
+{
+  uint32_t hash = nameHash( name_r.c_str() );
+  const Name * end = _names + _nameCount;
+  const Name * it = std::lower_bound( _names, end, hash,
+                                      []( const Name & lhs, uint32_t rhs ) { return lhs._hash < rhs; } );
+  if ( it == end || it->_hash != hash )
+    return;
+
+  uint32_t last = ( it + 1 == end ) ? _postingCount : (it + 1)->_first;
+  if ( last > _postingCount )
+    return;
+  uint32_t solvables = _repo.solvablesSize();
+  uint32_t off = uint32_t(-1);
+  for ( uint32_t idx = it->_first; idx < last; ++idx )
+  {
+    uint32_t posting = _postings[idx];
+    if ( ! ( deps_r & ( 1U << ( posting & 0xf ) ) ) || ( posting >> 4 ) == off || ( posting >> 4 ) >= solvables )
+      continue;
+    off = posting >> 4;	// postings are sorted by offset
+    result_r.push_back( solvable( off ) );
+  }
+}
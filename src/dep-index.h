@@ -0,0 +1,79 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/**
+ * Reverse dependency index of a repository: dependency name to the
+ * solvables having it in their provides, requires, conflicts, obsoletes,
+ * recommends, suggests, supplements or enhances.
+ *
+ * Stored as <tt>[repoSolvCachePath]/[alias]/zypper-depindex</tt> (see
+ * repo-index.h). Building it costs one pass over the repo's dependencies,
+ * which is what a search costs without the index anyway.
+ *
+ * Data after the common header (host byte order):
+ * \code
+ * uint32_t names		entries in the name table
+ * uint32_t postings		entries in the posting list
+ * { uint32_t hash, first }	name table, sorted by hash
+ * uint32_t			posting list: (offset << 4) | Dep::inSwitch()
+ * \endcode
+ * Names are hashed case insensitive, so hash collisions and case only
+ * differences are possible: the solvables a lookup returns are candidates
+ * to be checked by the caller.
+ */
+#ifndef ZYPPER_DEP_INDEX_H
+#define ZYPPER_DEP_INDEX_H
+
+#include <vector>
+
+#include <zypp/Dep.h>
+
+#include "repo-index.h"
+
+///////////////////////////////////////////////////////////////////
+/// \class DepIndex
+/// \brief Reverse dependency index of a loaded repository.
+/// \code
+///   std::unique_ptr<DepIndex> index( DepIndex::forRepo( zypper, repo ) );
+///   if ( index )
+///     index->lookup( "libfoo.so.1", DepIndex::bit( Dep::REQUIRES ), candidates );
+/// \endcode
+///////////////////////////////////////////////////////////////////
+class DepIndex : public RepoIndex
+{
+public:
+  /** The index of \a repo_r, mapped from the cache or (re)built and
+   * stored. \c nullptr if the repo can't be indexed or the index can't be
+   * stored.
+   */
+  static std::unique_ptr<DepIndex> forRepo( Zypper & zypper, const zypp::Repository & repo_r );
+
+  /** Mask bit of \a dep_r for \ref lookup. */
+  static unsigned bit( const zypp::Dep & dep_r )
+  { return 1U << dep_r.inSwitch(); }
+
+  /** Append the solvables having \a name_r in one of the dependencies in
+   * \a deps_r (mask of \ref bit) to \a result_r, in repo order.
+   */
+  void lookup( const std::string & name_r, unsigned deps_r, std::vector<zypp::sat::Solvable> & result_r ) const;
+
+protected:
+  virtual void build( std::string & data_r );
+  virtual bool attach( const char * data_r, std::size_t size_r );
+
+private:
+  struct Name;
+
+  explicit DepIndex( const zypp::Repository & repo_r );
+
+  const Name * _names;
+  const uint32_t * _postings;
+  uint32_t _nameCount;
+  uint32_t _postingCount;
+};
+
+#endif // ZYPPER_DEP_INDEX_H
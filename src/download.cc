@@ -18,6 +18,7 @@
 #include "Zypper.h"
 #include "PackageArgs.h"
 #include "Table.h"
+#include "output/OutJSON.h"
 #include "download.h"
 #include "callbacks/media.h"
 
@@ -76,6 +77,20 @@ namespace
     }
   }
 
+  inline void logJsonResult( const PoolItem & pi_r, const Pathname & localfile_r )
+  {
+    // {"type":"download-result","kind":"package","name":"glibc","edition":"2.18-4.11.1",
+    //  "arch":"i586","repository":"repo-oss-update","localfile":"/tmp/..."}
+    // ("localfile":"" on error)
+    jsonout::Record( "download-result" )
+      ( "kind", pi_r->kind().asString() )
+      ( "name", pi_r->name() )
+      ( "edition", pi_r->edition().asString() )
+      ( "arch", pi_r->arch().asString() )
+      ( "repository", pi_r->repository().alias() )
+      ( "localfile", localfile_r.asString() );
+  }
+
   void DownloadImpl::download()
   {
     typedef ui::SelectableTraits::AvailableItemSet AvailableItemSet;
@@ -193,6 +208,8 @@ namespace
 	    localfile.resetDispose();
 	    if ( _zypper.out().typeXML() )
 	      logXmlResult( pi, localfile );
+	    else if ( _zypper.out().typeJSON() )
+	      logJsonResult( pi, localfile );
 
 	    if ( _zypper.exitRequested() )
 	      throw( Out::Error( ZYPPER_EXIT_ON_SIGNAL ) );
@@ -210,6 +227,8 @@ namespace
 	  Out::ProgressBar report( _zypper.out(), localfile.asString(), current, total );
 	  if ( _zypper.out().typeXML() )
 	    logXmlResult( pi, localfile );
+	  else if ( _zypper.out().typeJSON() )
+	    logJsonResult( pi, localfile );
 	}
 
 	if ( !_options->_allmatches )
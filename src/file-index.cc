@@ -0,0 +1,228 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+
+#include <zypp/base/Logger.h>
+#include <zypp/sat/LookupAttr.h>
+
+#include "Zypper.h"
+#include "file-index.h"
+
+using namespace zypp;
+
+///////////////////////////////////////////////////////////////////
+namespace
+{
+  const unsigned blockSize = 16;
+
+  inline unsigned char fold( unsigned char ch )
+  { return ( ch >= 'A' && ch <= 'Z' ) ? ch - 'A' + 'a' : ch; }
+
+  /** Compare ASCII case insensitive. */
+  int foldCompare( const std::string & lhs, const std::string & rhs )
+  {
+    std::string::size_type len = std::min( lhs.size(), rhs.size() );
+    for ( std::string::size_type pos = 0; pos < len; ++pos )
+    {
+      unsigned char l = fold( lhs[pos] );
+      unsigned char r = fold( rhs[pos] );
+      if ( l != r )
+	return l < r ? -1 : 1;
+    }
+    return lhs.size() == rhs.size() ? 0 : ( lhs.size() < rhs.size() ? -1 : 1 );
+  }
+
+  /** Index order: case insensitive, then case sensitive. */
+  bool pathLess( const std::string & lhs, const std::string & rhs )
+  {
+    int cmp = foldCompare( lhs, rhs );
+    return cmp ? cmp < 0 : lhs < rhs;
+  }
+
+  void putVarint( std::string & data_r, uint32_t val_r )
+  {
+    while ( val_r >= 0x80 )
+    {
+      data_r += char( ( val_r & 0x7f ) | 0x80 );
+      val_r >>= 7;
+    }
+    data_r += char( val_r );
+  }
+
+  /** Decode a varint at \a pos_r; \c false if it runs past \a end_r. */
+  bool getVarint( const char *& pos_r, const char * end_r, uint32_t & val_r )
+  {
+    val_r = 0;
+    for ( unsigned shift = 0; pos_r < end_r && shift < 32; shift += 7 )
+    {
+      unsigned char ch = *pos_r++;
+      val_r |= uint32_t( ch & 0x7f ) << shift;
+      if ( ! ( ch & 0x80 ) )
+	return true;
+    }
+    return false;
+  }
+} // namespace
+///////////////////////////////////////////////////////////////////
+
+struct FileIndex::Block
+{
+  uint32_t _text;	//< offset of the first path in the text
+  uint32_t _posting;	//< index of the first path's first posting
+};
+
+FileIndex::FileIndex( const Repository & repo_r )
+  : RepoIndex( repo_r, "ZYFILIX1" )
+  , _blocks( nullptr )
+  , _postings( nullptr )
+  , _text( nullptr )
+  , _blockCount( 0 )
+  , _postingCount( 0 )
+  , _textSize( 0 )
+{}
+
+std::unique_ptr<FileIndex> FileIndex::forRepo( Zypper & zypper, const Repository & repo_r )
+{
+  std::unique_ptr<FileIndex> ret( new FileIndex( repo_r ) );
+  if ( ! ret->load( zypper, "zypper-fileindex" ) )
+    ret.reset();
+  return ret;
+}
+
+bool FileIndex::attach( const char * data_r, std::size_t size_r )
+{
+  if ( size_r < 3 * sizeof(uint32_t) )
+    return false;
+  const uint32_t * counts = reinterpret_cast<const uint32_t *>( data_r );
+  if ( uint64_t(size_r) != 3 * sizeof(uint32_t) + uint64_t(counts[0]) * sizeof(Block) + uint64_t(counts[1]) * sizeof(uint32_t) + counts[2] )
+    return false;
+
+  const Block * blocks = reinterpret_cast<const Block *>( counts + 3 );
+  const uint32_t * postings = reinterpret_cast<const uint32_t *>( blocks + counts[0] );
+  // offsets in the tables are checked when looked up
+
+  _blockCount = counts[0];
+  _postingCount = counts[1];
+  _textSize = counts[2];
+  _blocks = blocks;
+  _postings = postings;
+  _text = reinterpret_cast<const char *>( postings + counts[1] );
+  return true;
+}
+
+void FileIndex::build( std::string & data_r )
+{
+  std::vector<std::pair<std::string,uint32_t> > entries;	// path, offset
+  sat::LookupAttr files( sat::SolvAttr::filelist, _repo );
+  for_( it, files.begin(), files.end() )
+    entries.push_back( std::make_pair( it.asString(), offset( it.inSolvable() ) ) );
+  std::sort( entries.begin(), entries.end(),
+             []( const std::pair<std::string,uint32_t> & lhs, const std::pair<std::string,uint32_t> & rhs )
+             { return pathLess( lhs.first, rhs.first ) || ( lhs.first == rhs.first && lhs.second < rhs.second ); } );
+  entries.erase( std::unique( entries.begin(), entries.end() ), entries.end() );
+
+  std::vector<Block> blocks;
+  std::vector<uint32_t> postings;
+  std::string text;
+  const std::string * prev = nullptr;
+  unsigned paths = 0;
+  for ( auto it = entries.begin(); it != entries.end(); )
+  {
+    const std::string & path( it->first );
+    std::string::size_type shared = 0;
+    if ( paths % blockSize == 0 )
+      blocks.push_back( Block{ uint32_t(text.size()), uint32_t(postings.size()) } );
+    else
+    {
+      std::string::size_type len = std::min( prev->size(), path.size() );
+      while ( shared < len && (*prev)[shared] == path[shared] )
+	++shared;
+    }
+    putVarint( text, shared );
+    putVarint( text, path.size() - shared );
+    text.append( path, shared, std::string::npos );
+
+    uint32_t count = 0;
+    for ( ; it != entries.end() && it->first == path; ++it, ++count )
+      postings.push_back( it->second );
+    putVarint( text, count );
+    prev = &path;
+    ++paths;
+  }
+
+  uint32_t counts[3] = { uint32_t(blocks.size()), uint32_t(postings.size()), uint32_t(text.size()) };
+  data_r.reserve( data_r.size() + sizeof(counts) + blocks.size() * sizeof(Block) + postings.size() * sizeof(uint32_t) + text.size() );
+  data_r.append( reinterpret_cast<const char *>( counts ), sizeof(counts) );
+  data_r.append( reinterpret_cast<const char *>( blocks.data() ), blocks.size() * sizeof(Block) );
+  data_r.append( reinterpret_cast<const char *>( postings.data() ), postings.size() * sizeof(uint32_t) );
+  data_r.append( text );
+  MIL << "Indexed " << paths << " files of " << _repo.alias() << " (" << text.size() << " bytes)" << endl;
+}
+
+void FileIndex::lookup( const std::string & path_r, bool caseSensitive_r, std::vector<sat::Solvable> & result_r ) const
+{
+  if ( ! _blockCount )
+    return;
+
+  const char * end = _text + _textSize;
+  // the complete first path of block \a idx
+  auto firstPath = [&]( uint32_t idx_r ) -> std::string
+  {
+    if ( _blocks[idx_r]._text >= _textSize )
+      return std::string();
+    const char * pos = _text + _blocks[idx_r]._text;
+    uint32_t shared, len;
+    if ( ! getVarint( pos, end, shared ) || ! getVarint( pos, end, len ) || len > uint32_t(end - pos) )
+      return std::string();
+    return std::string( pos, len );
+  };
+
+  // the last block starting before the path, the path may be in it
+  uint32_t lo = 0;
+  uint32_t hi = _blockCount;
+  while ( hi - lo > 1 )
+  {
+    uint32_t mid = lo + ( hi - lo ) / 2;
+    if ( foldCompare( firstPath( mid ), path_r ) < 0 )
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  if ( _blocks[lo]._text >= _textSize || _blocks[lo]._posting > _postingCount )
+    return;
+  const char * pos = _text + _blocks[lo]._text;
+  uint32_t posting = _blocks[lo]._posting;
+  uint32_t solvables = _repo.solvablesSize();
+  std::string path;
+  while ( pos < end )
+  {
+    uint32_t shared, len, count;
+    if ( ! getVarint( pos, end, shared ) || ! getVarint( pos, end, len )
+      || shared > path.size() || len > uint32_t(end - pos) )
+      break;
+    path.resize( shared );
+    path.append( pos, len );
+    pos += len;
+    if ( ! getVarint( pos, end, count ) || count > _postingCount - posting )
+      break;
+
+    int cmp = foldCompare( path, path_r );
+    if ( cmp > 0 )
+      break;
+    if ( cmp == 0 && ( ! caseSensitive_r || path == path_r ) )
+    {
+      for ( uint32_t idx = posting; idx < posting + count; ++idx )
+      {
+	if ( _postings[idx] < solvables )
+	  result_r.push_back( solvable( _postings[idx] ) );
+      }
+    }
+    posting += count;
+  }
+}
@@ -0,0 +1,77 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/**
+ * File path index of a repository: path to the solvables containing it.
+ *
+ * Stored as <tt>[repoSolvCachePath]/[alias]/zypper-fileindex</tt> (see
+ * repo-index.h). Paths are sorted (ASCII case insensitive first) and front
+ * coded in blocks of 16: each path stores only the length of the prefix
+ * it shares with the previous one and the rest. A lookup binary searches
+ * the blocks by their first (complete) path and decodes one or two blocks.
+ *
+ * Data after the common header (host byte order):
+ * \code
+ * uint32_t blocks		entries in the block table
+ * uint32_t postings		entries in the posting list
+ * uint32_t text		bytes of path data
+ * { uint32_t text, posting }	block table: offsets of the block's first path
+ * uint32_t			posting list: solvable offsets
+ * char				path data, per path:
+ *				  varint shared, varint length, the rest of the path,
+ *				  varint number of postings
+ * \endcode
+ */
+#ifndef ZYPPER_FILE_INDEX_H
+#define ZYPPER_FILE_INDEX_H
+
+#include <vector>
+
+#include "repo-index.h"
+
+///////////////////////////////////////////////////////////////////
+/// \class FileIndex
+/// \brief File path index of a loaded repository.
+/// \code
+///   std::unique_ptr<FileIndex> index( FileIndex::forRepo( zypper, repo ) );
+///   if ( index )
+///     index->lookup( "/usr/bin/foo", true, providers );
+/// \endcode
+///////////////////////////////////////////////////////////////////
+class FileIndex : public RepoIndex
+{
+public:
+  /** The index of \a repo_r, mapped from the cache or (re)built and
+   * stored. \c nullptr if the repo can't be indexed or the index can't be
+   * stored.
+   */
+  static std::unique_ptr<FileIndex> forRepo( Zypper & zypper, const zypp::Repository & repo_r );
+
+  /** Append the solvables containing the file \a path_r to \a result_r.
+   * Unless \a caseSensitive_r the path is compared ASCII
+   * case insensitive.
+   */
+  void lookup( const std::string & path_r, bool caseSensitive_r, std::vector<zypp::sat::Solvable> & result_r ) const;
+
+protected:
+  virtual void build( std::string & data_r );
+  virtual bool attach( const char * data_r, std::size_t size_r );
+
+private:
+  struct Block;
+
+  explicit FileIndex( const zypp::Repository & repo_r );
+
+  const Block * _blocks;
+  const uint32_t * _postings;
+  const char * _text;
+  uint32_t _blockCount;
+  uint32_t _postingCount;
+  uint32_t _textSize;
+};
+
+#endif // ZYPPER_FILE_INDEX_H
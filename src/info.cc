@@ -6,6 +6,8 @@
 \*---------------------------------------------------------------------------*/
 
 #include <iostream>
+#include <algorithm>
+#include <memory>
 
 #include <boost/format.hpp>
 
@@ -20,12 +22,13 @@
 
 #include "Zypper.h"
 #include "main.h"
-//#include "misc.h"
+#include "misc.h"
 #include "Table.h"
 #include "utils/misc.h" // for kind_to_string_localized and string_patch_status
 #include "utils/text.h"
 #include "search.h"
 #include "update.h"
+#include "output/OutJSON.h"
 
 #include "info.h"
 
@@ -76,6 +79,133 @@ namespace
     return str << " " << word_r;
   }
 
+  /** The package to show: the update candidate, else the installed one,
+   * preferably as available in the repo it came from.
+   */
+  PoolItem infoPackage( const ui::Selectable & s )
+  {
+    PoolItem theone( s.updateCandidateObj() );
+    if ( !theone )
+    {
+      theone = s.identicalAvailableObj( s.installedObj() );
+      if ( !theone )
+	theone = s.installedObj();
+    }
+    return theone;
+  }
+
+  /** Selectables of \a kind matching \a name_r like the info command
+   * always did: exact (case insensitive) names are looked up in \a index_r,
+   * globs and \c --match-substrings still need a PoolQuery.
+   */
+  std::vector<ui::Selectable::Ptr> infoSelectables( Zypper & zypper, PoolNameIndex & index_r,
+						    const ResKind & kind, const std::string & name_r )
+  {
+    std::vector<ui::Selectable::Ptr> ret;
+    if ( zypper.cOpts().count("match-substrings") || name_r.find_first_of("?*") != std::string::npos )
+    {
+      PoolQuery q;
+      q.addKind( kind );
+      q.addAttribute( sat::SolvAttr::name, name_r );
+      if ( !zypper.cOpts().count("match-substrings") )
+	q.setMatchExact();
+      if ( name_r.find_first_of("?*") != std::string::npos )
+	q.setMatchGlob();
+      ret.insert( ret.end(), q.selectableBegin(), q.selectableEnd() );
+      return ret;
+    }
+
+    for ( const sat::Solvable & solv : index_r.lookup( kind, name_r ) )
+    {
+      ui::Selectable::Ptr sel( ui::Selectable::get( solv ) );
+      if ( std::find( ret.begin(), ret.end(), sel ) == ret.end() )
+	ret.push_back( sel );
+    }
+    return ret;
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class InfoWriter
+  /// \brief XML and JSON output of the info command.
+  ///
+  /// Each selectable is written as one \c <info> element (or JSON record)
+  /// as soon as it was looked up, so bulk queries don't need to keep
+  /// anything in memory. Products keep their \c <product> element in XML.
+  ///////////////////////////////////////////////////////////////////
+  class InfoWriter : private base::NonCopyable
+  {
+  public:
+    InfoWriter( Out & out_r )
+      : _json( out_r.typeJSON() )
+      , _list( out_r, "info-list" )
+    {}
+
+    void write( const ui::Selectable & s )
+    {
+      PoolItem pi( s.kind() == ResKind::package ? infoPackage( s ) : s.theObj() );
+      std::string status;
+      if ( s.kind() == ResKind::package )
+	status = !s.hasInstalledObj() ? "not-installed" : s.updateCandidateObj() ? "out-of-date" : "up-to-date";
+      else if ( s.kind() == ResKind::patch )
+	status = string_patch_status( pi );
+      else
+	status = s.hasInstalledObj() ? "installed" : "not-installed";
+      Patch::constPtr patch( asKind<Patch>( pi.resolvable() ) );
+
+      if ( _json )
+      {
+	jsonout::Record rec( "info" );
+	rec ( "kind", s.kind().asString() )
+	    ( "name", pi->name() )
+	    ( "edition", pi->edition().asString() )
+	    ( "arch", pi->arch().asString() )
+	    ( "vendor", pi->vendor().asString() )
+	    ( "repository", pi->repository().alias() )
+	    ( "installed", s.hasInstalledObj() )
+	    ( "status", status );
+	if ( s.kind() == ResKind::package )
+	  rec( "installsize", (long long)pi->installSize() );
+	if ( patch )
+	  rec( "category", patch->category() )( "severity", patch->severity() );
+	rec( "summary", pi->summary() )( "description", pi->description() );
+	return;
+      }
+
+      cout << "<info kind=\"" << s.kind() << "\" name=\"";
+      out::writeXmlEscaped( cout, pi->name() );
+      cout << "\" edition=\"";
+      out::writeXmlEscaped( cout, pi->edition().asString() );
+      cout << "\" arch=\"" << pi->arch() << "\" vendor=\"";
+      out::writeXmlEscaped( cout, pi->vendor().asString() );
+      cout << "\" repository=\"";
+      out::writeXmlEscaped( cout, pi->repository().alias() );
+      cout << "\" installed=\"" << ( s.hasInstalledObj() ? "true" : "false" )
+	   << "\" status=\"" << status << "\"";
+      if ( s.kind() == ResKind::package )
+	cout << " installsize=\"" << (long long)pi->installSize() << "\"";
+      if ( patch )
+      {
+	cout << " category=\"";
+	out::writeXmlEscaped( cout, patch->category() );
+	cout << "\" severity=\"";
+	out::writeXmlEscaped( cout, patch->severity() );
+	cout << "\"";
+      }
+      cout << ">" << '\n';
+      cout << "<summary>";
+      out::writeXmlEscaped( cout, pi->summary() );
+      cout << "</summary>" << '\n';
+      cout << "<description>";
+      out::writeXmlEscaped( cout, pi->description() );
+      cout << "</description>" << '\n';
+      cout << "</info>" << '\n';
+    }
+
+  private:
+    bool _json;
+    Out::XmlNode _list;
+  };
+
 } // namespace out
 ///////////////////////////////////////////////////////////////////
 
@@ -95,70 +225,81 @@ void printSummaryDesc(const ResObject::constPtr & res)
 }
 
 /**
- *
+ * All arguments are looked up in one PoolNameIndex (built with a single
+ * pass over the pool), and each match is printed right away.
  */
-void printInfo(Zypper & zypper, const ResKind & kind)
+void printInfo(Zypper & zypper, const ResKind & kind, const SolvableFormat * qformat)
 {
-  ResPool pool = God->pool();
-
-  cout << endl;
+  Out & out( zypper.out() );
+  // products have their own XML output
+  bool machine = !qformat && ( out.typeJSON() || ( out.typeXML() && kind != ResKind::product ) );
+  std::unique_ptr<InfoWriter> writer;
+  if ( machine )
+    writer.reset( new InfoWriter( out ) );
+  else if ( !qformat )
+    cout << endl;
 
+  PoolNameIndex index;
   for(vector<string>::const_iterator nameit = zypper.arguments().begin();
       nameit != zypper.arguments().end(); ++nameit )
   {
-    PoolQuery q;
-    q.addKind(kind);
-    q.addAttribute(sat::SolvAttr::name, *nameit);
-
-    if ( !zypper.cOpts().count("match-substrings") )
-    {
-      q.setMatchExact();
-    }
+    std::vector<ui::Selectable::Ptr> sels( infoSelectables( zypper, index, kind, *nameit ) );
 
-    if ( (*nameit).find_first_of("?*") != string::npos )
-    {
-      q.setMatchGlob();
-    }
-
-    if (q.empty())
+    if (sels.empty())
     {
       // TranslatorExplanation E.g. "package 'zypper' not found."
       //! \todo use a separate string for each kind so that it is translatable.
-      cout << "\n" << format(_("%s '%s' not found."))
-          % kind_to_string_localized(kind, 1) % *nameit
-          << endl;
+      string msg = boost::str( format(_("%s '%s' not found."))
+                               % kind_to_string_localized(kind, 1) % *nameit );
+      if ( machine )
+        out.warning( msg );
+      else if ( qformat )
+        cerr << msg << endl;	// keep stdout to the template
+      else
+        cout << "\n" << msg << endl;
+      continue;
     }
-    else
+
+    for_( it, sels.begin(), sels.end() )
     {
-      for ( zypp::PoolQuery::Selectable_iterator it = q.selectableBegin();
-	     it != q.selectableEnd(); it++)
+      if ( qformat )
       {
-        // print info
-        // TranslatorExplanation E.g. "Information for package zypper:"
-
-        if (zypper.out().type() != Out::TYPE_XML)
-        {
-          string info = boost::str( format(_("Information for %s %s:"))
-                                    % kind_to_string_localized(kind, 1)
-                                    % (*it)->name() );
-
-          cout << endl << info << endl;
-          cout << string( mbs_width(info), '-' ) << endl;
-        }
-
-        if (kind == ResKind::package)
-          printPkgInfo(zypper, *(*it));
-        else if (kind == ResKind::patch)
-          printPatchInfo(zypper, *(*it));
-        else if (kind == ResKind::pattern)
-          printPatternInfo(zypper, *(*it));
-        else if (kind == ResKind::product)
-          printProductInfo(zypper, *(*it));
-        else
-          // TranslatorExplanation %s = resolvable type (package, patch, pattern, etc - untranslated).
-          zypper.out().info(
-                            boost::str(format(_("Info for type '%s' not implemented.")) % kind));
+        const ui::Selectable & s( **it );
+        qformat->print( cout, s.kind() == ResKind::package ? infoPackage( s ) : s.theObj(),
+                        s.hasInstalledObj() ? "i" : "" );
+        continue;
       }
+      if ( writer )
+      {
+        writer->write( **it );
+        continue;
+      }
+
+      // print info
+      // TranslatorExplanation E.g. "Information for package zypper:"
+
+      if (zypper.out().type() != Out::TYPE_XML)
+      {
+        string info = boost::str( format(_("Information for %s %s:"))
+                                  % kind_to_string_localized(kind, 1)
+                                  % (*it)->name() );
+
+        cout << endl << info << endl;
+        cout << string( mbs_width(info), '-' ) << endl;
+      }
+
+      if (kind == ResKind::package)
+        printPkgInfo(zypper, *(*it));
+      else if (kind == ResKind::patch)
+        printPatchInfo(zypper, *(*it));
+      else if (kind == ResKind::pattern)
+        printPatternInfo(zypper, *(*it));
+      else if (kind == ResKind::product)
+        printProductInfo(zypper, *(*it));
+      else
+        // TranslatorExplanation %s = resolvable type (package, patch, pattern, etc - untranslated).
+        zypper.out().info(
+                          boost::str(format(_("Info for type '%s' not implemented.")) % kind));
     }
   }
 }
@@ -190,13 +331,7 @@ void printPkgInfo(Zypper & zypper, const ui::Selectable & s)
   // An updateCandidate is always better than any installed object.
   // If the best version is already installed try to look it up in
   // the repo it came from, otherwise use the installed one.
-  PoolItem theone( updateCand );
-  if ( !theone )
-  {
-    theone = s.identicalAvailableObj( installed );
-    if ( !theone )
-      theone = installed;
-  }
+  PoolItem theone( infoPackage( s ) );
 
   cout << _("Repository: ")
        << theone.resolvable()->repository().asUserString() << endl;
@@ -14,6 +14,11 @@
 
 #include "Zypper.h"
 
-void printInfo(Zypper & zypper, const zypp::ResKind & kind);
+class SolvableFormat;
+
+/** Print the info of all packages named in the arguments, using
+ * \a format (\c --format) instead of the property list if given.
+ */
+void printInfo(Zypper & zypper, const zypp::ResKind & kind, const SolvableFormat * format = nullptr);
 
 #endif /*ZYPPERINFO_H_*/
@@ -0,0 +1,422 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <cerrno>
+
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+
+#include <zypp/ZYpp.h>
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/PathInfo.h>
+#include <zypp/Repository.h>
+#include <zypp/sat/Pool.h>
+
+#include "Zypper.h"
+#include "main.h"
+#include "output/OutNormal.h"
+#include "transaction-plan.h"
+#include "install-roots.h"
+
+extern ZYpp::Ptr God;
+
+///////////////////////////////////////////////////////////////////
+namespace
+{
+  /** Index of the root this job works on (-1 in the parent). */
+  int jobIndex = -1;
+
+  /** Shared by parent and jobs: the parents tmpdir. */
+  Pathname sharedDir( Zypper & zypper )
+  { return zypper.runtimeData().tmpdir.path(); }
+
+  Pathname plansDir( Zypper & zypper )
+  { return sharedDir( zypper ) / "plans"; }
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class Job
+  /// \brief A forked job as seen from the parent.
+  ///////////////////////////////////////////////////////////////////
+  struct Job
+  {
+    std::string _root;
+    pid_t _pid = -1;
+    int _fd = -1;		//< read end of the jobs stdout/stderr
+    std::string _pending;	//< incomplete last line
+    int _exitcode = ZYPPER_EXIT_OK;
+  };
+
+  /** Print the complete lines in \a job_r's buffer (all if \a flush_r). */
+  void relayLines( Job & job_r, bool flush_r )
+  {
+    std::string::size_type start = 0;
+    std::string::size_type end;
+    while ( ( end = job_r._pending.find( '\n', start ) ) != std::string::npos )
+    {
+      std::cout << "[" << job_r._root << "] " << job_r._pending.substr( start, end - start ) << std::endl;
+      start = end + 1;
+    }
+    job_r._pending.erase( 0, start );
+    if ( flush_r && ! job_r._pending.empty() )
+    {
+      std::cout << "[" << job_r._root << "] " << job_r._pending << std::endl;
+      job_r._pending.clear();
+    }
+  }
+
+  /** Relay the jobs output until all of them closed their pipe. */
+  void relayOutput( std::vector<Job> & jobs_r )
+  {
+    char buf[4096];
+    while ( true )
+    {
+      std::vector<pollfd> fds;
+      std::vector<Job*> open;
+      for ( Job & job : jobs_r )
+      {
+	if ( job._fd < 0 )
+	  continue;
+	fds.push_back( pollfd{ job._fd, POLLIN, 0 } );
+	open.push_back( &job );
+      }
+      if ( fds.empty() )
+	break;
+
+      if ( ::poll( &fds[0], fds.size(), -1 ) < 0 )
+      {
+	if ( errno == EINTR )
+	  continue;
+	ERR << "poll failed: " << str::strerror( errno ) << endl;
+	break;
+      }
+
+      for ( unsigned i = 0; i < fds.size(); ++i )
+      {
+	if ( ! fds[i].revents )
+	  continue;
+	ssize_t got = ::read( fds[i].fd, buf, sizeof(buf) );
+	if ( got < 0 && errno == EINTR )
+	  continue;
+	if ( got > 0 )
+	{
+	  open[i]->_pending.append( buf, got );
+	  relayLines( *open[i], false );
+	}
+	else
+	{
+	  relayLines( *open[i], true );
+	  ::close( open[i]->_fd );
+	  open[i]->_fd = -1;
+	}
+      }
+    }
+  }
+
+  /** Errors take precedence over informational exit codes; first one wins. */
+  int combinedExitCode( const std::vector<Job> & jobs_r )
+  {
+    int info = ZYPPER_EXIT_OK;
+    for ( const Job & job : jobs_r )
+    {
+      if ( job._exitcode == ZYPPER_EXIT_OK )
+	continue;
+      if ( job._exitcode < ZYPPER_EXIT_INF_UPDATE_NEEDED || job._exitcode == ZYPPER_EXIT_ON_SIGNAL )
+	return job._exitcode;
+      if ( info == ZYPPER_EXIT_OK )
+	info = job._exitcode;
+    }
+    return info;
+  }
+
+  /** Turn the current process into the job for \a root_r. */
+  void setupJob( Zypper & zypper, int index_r, const std::string & root_r )
+  {
+    jobIndex = index_r;
+
+    // stdout is a pipe now, no fancy progress
+    OutNormal * out = new OutNormal( zypper.out().verbosity() );
+    out->setUseColors( false );
+    zypper.setOutputWriter( out );
+
+    GlobalOptions & gopts( zypper.globalOptsNoConst() );
+    if ( root_r != gopts.root_dir )
+    {
+      gopts.root_dir = root_r;
+      try
+      {
+	God->finishTarget();
+	God->initializeTarget( root_r );
+      }
+      catch ( const Exception & e )
+      {
+	ZYPP_CAUGHT( e );
+	zypper.out().error( e, _("Target initialization failed:") );
+	zypper.setExitCode( ZYPPER_EXIT_ERR_ZYPP );
+	throw ExitRequestException( "Target initialization failed: " + e.msg() );
+      }
+    }
+
+    // The package cache is shared, so a job must not clean it up after commit.
+    // The parent does this when all jobs are done.
+    for_( it, sat::Pool::instance().reposBegin(), sat::Pool::instance().reposEnd() )
+    {
+      Repository repo( *it );
+      RepoInfo info( repo.info() );
+      if ( ! info.keepPackages() )
+      {
+	info.setKeepPackages( true );
+	repo.setInfo( info );
+      }
+    }
+    MIL << "Install root job " << index_r << " for " << root_r << endl;
+  }
+
+  /** Remove the packages the jobs kept in the cache of non-keeppackages repos. */
+  void cleanSharedPackageCache( Zypper & zypper )
+  {
+    if ( zypper.cOpts().count( "download-only" ) || zypper.cOpts().count( "dry-run" ) )
+      return;
+
+    SCOPED_VERBOSITY( zypper.out(), Out::QUIET );
+    for ( const RepoInfo & repo : zypper.runtimeData().repos )
+    {
+      if ( repo.keepPackages() )
+	continue;
+      try
+      {
+	zypper.repoManager().cleanPackages( repo );
+      }
+      catch ( const Exception & e )
+      {
+	ZYPP_CAUGHT( e );
+	WAR << "Could not clean packages of " << repo.alias() << endl;
+      }
+    }
+  }
+
+} // namespace
+///////////////////////////////////////////////////////////////////
+
+bool install_roots_supported( Zypper & zypper )
+{
+  switch ( zypper.command().toEnum() )
+  {
+  case ZypperCommand::INSTALL_e:
+  case ZypperCommand::REMOVE_e:
+  case ZypperCommand::UPDATE_e:
+  case ZypperCommand::PATCH_e:
+  case ZypperCommand::DIST_UPGRADE_e:
+  case ZypperCommand::VERIFY_e:
+  case ZypperCommand::INSTALL_NEW_RECOMMENDS_e:
+    return true;
+  default:
+    return false;
+  }
+}
+
+void run_install_root_jobs( Zypper & zypper )
+{
+  const std::list<std::string> & roots( zypper.globalOpts().install_roots );
+  if ( roots.size() < 2 || jobIndex >= 0 )
+    return;
+
+  // Nobody can answer a prompt of a job.
+  if ( ! zypper.globalOpts().non_interactive )
+  {
+    zypper.globalOptsNoConst().non_interactive = true;
+    zypper.out().info( _("Running in non-interactive mode as more than one root was given."), Out::HIGH );
+  }
+  filesystem::assert_dir( plansDir( zypper ) );
+
+  std::vector<Job> jobs;
+  jobs.reserve( roots.size() );
+  int index = 0;
+  for ( const std::string & root : roots )
+  {
+    int fds[2];
+    if ( ::pipe( fds ) != 0 )
+    {
+      ERR << "pipe failed: " << str::strerror( errno ) << endl;
+      break;
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = ::fork();
+    if ( pid < 0 )
+    {
+      ERR << "fork failed: " << str::strerror( errno ) << endl;
+      ::close( fds[0] );
+      ::close( fds[1] );
+      break;
+    }
+
+    if ( pid == 0 )
+    {
+      ::close( fds[0] );
+      for ( const Job & job : jobs )
+	::close( job._fd );
+      ::dup2( fds[1], STDOUT_FILENO );
+      ::dup2( fds[1], STDERR_FILENO );
+      ::close( fds[1] );
+      setupJob( zypper, index, root );
+      return;	// go on with the command
+    }
+
+    ::close( fds[1] );
+    Job job;
+    job._root = root;
+    job._pid = pid;
+    job._fd = fds[0];
+    jobs.push_back( job );
+    ++index;
+  }
+
+  if ( jobs.size() != roots.size() )
+  {
+    zypper.out().error( _("Cannot start a job for each root.") );
+    for ( const Job & job : jobs )
+      ::kill( job._pid, SIGTERM );
+  }
+
+  relayOutput( jobs );
+
+  for ( Job & job : jobs )
+  {
+    int status = 0;
+    while ( ::waitpid( job._pid, &status, 0 ) < 0 && errno == EINTR )
+      ;
+    if ( WIFEXITED( status ) )
+      job._exitcode = WEXITSTATUS( status );
+    else
+      job._exitcode = ZYPPER_EXIT_ON_SIGNAL;
+    MIL << "Install root job " << job._root << " exited with " << job._exitcode << endl;
+  }
+
+  cleanSharedPackageCache( zypper );
+
+  for ( const Job & job : jobs )
+  {
+    if ( job._exitcode == ZYPPER_EXIT_OK || job._exitcode >= ZYPPER_EXIT_INF_UPDATE_NEEDED )
+      zypper.out().info( boost::format(_("Root '%s': done.")) % job._root );
+    else
+      zypper.out().error( boost::str( boost::format(_("Root '%s': failed with exit code %d.")) % job._root % job._exitcode ) );
+  }
+
+  int exitcode = combinedExitCode( jobs );
+  if ( jobs.size() != roots.size() && exitcode == ZYPPER_EXIT_OK )
+    exitcode = ZYPPER_EXIT_ERR_BUG;
+  zypper.setExitCode( exitcode );
+  throw ExitRequestException( "install root jobs done" );
+}
+
+void finish_install_root_job( Zypper & zypper )
+{
+  if ( jobIndex < 0 )
+    return;
+
+  // The regular shutdown would also remove the repos, tmpdir and zypp lock
+  // shared with the parent, so the job leaves via _exit. Release what is
+  // its own explicitly: the target (rpmdb) of its root and pending output.
+  try
+  {
+    God->finishTarget();
+  }
+  catch ( const Exception & e )
+  {
+    ZYPP_CAUGHT( e );
+    ERR << "Install root job " << jobIndex << ": releasing the target failed" << endl;
+  }
+  MIL << "Install root job " << jobIndex << " exits with " << zypper.exitCode() << endl;
+  std::cout.flush();
+  std::cerr.flush();
+  ::_exit( zypper.exitCode() );
+}
+
+///////////////////////////////////////////////////////////////////
+// InstallRootPrepareLock
+///////////////////////////////////////////////////////////////////
+
+InstallRootPrepareLock::InstallRootPrepareLock( Zypper & zypper )
+  : _zypper( zypper )
+  , _fd( -1 )
+  , _reused( false )
+{
+  if ( jobIndex < 0 )
+    return;
+
+  Pathname lockfile( sharedDir( zypper ) / "prepare.lock" );
+  _fd = ::open( lockfile.c_str(), O_RDWR|O_CREAT|O_CLOEXEC, 0600 );
+  if ( _fd < 0 )
+  {
+    ERR << "Cannot open " << lockfile << ": " << str::strerror( errno ) << endl;
+    return;	// go on unserialized
+  }
+  while ( ::flock( _fd, LOCK_EX ) != 0 && errno == EINTR )
+    ;
+
+  if ( ! zypper.runtimeData().solve_before_commit )
+    return;	// --plan-in applied or no solver run anyway
+
+  std::list<std::string> plans;
+  filesystem::readdir( plans, plansDir( zypper ), false );
+  for ( const std::string & plan : plans )
+  {
+    if ( apply_transaction_plan( zypper, plansDir( zypper ) / plan ) )
+    {
+      unsigned index = str::strtonum<unsigned>( plan );
+      std::list<std::string>::const_iterator root( zypper.globalOpts().install_roots.begin() );
+      std::advance( root, std::min<unsigned>( index, zypper.globalOpts().install_roots.size() - 1 ) );
+      zypper.out().info( boost::format(_("Reusing the solution computed for root '%s'.")) % *root );
+      zypper.runtimeData().solve_before_commit = false;
+      _reused = true;
+      break;
+    }
+  }
+}
+
+InstallRootPrepareLock::~InstallRootPrepareLock()
+{
+  if ( _fd >= 0 )
+    ::close( _fd );	// releases the lock
+}
+
+void InstallRootPrepareLock::publish()
+{
+  if ( jobIndex < 0 || _reused )
+    return;
+
+  SCOPED_VERBOSITY( _zypper.out(), Out::QUIET );
+  if ( ! write_transaction_plan( _zypper, plansDir( _zypper ) / str::numstring( jobIndex ) ) )
+    WAR << "Could not publish the solution of job " << jobIndex << endl;
+}
+
+void InstallRootPrepareLock::downloadAndRelease( const ZYppCommitPolicy & policy_r )
+{
+  if ( _fd < 0 )
+    return;
+
+  if ( ! policy_r.dryRun() && policy_r.downloadMode() != DownloadOnly )
+  {
+    ZYppCommitPolicy policy( policy_r );
+    policy.downloadMode( DownloadOnly );
+    MIL << "Downloading into the shared package cache" << endl;
+    God->commit( policy );
+  }
+
+  ::close( _fd );
+  _fd = -1;
+}
@@ -0,0 +1,76 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/**
+ * Multi-root mode (--root given more than once).
+ *
+ * The repository data are loaded once, then one job per install root is
+ * forked off. Each job reads the rpmdb of its root, solves and commits into
+ * it. Jobs prepare their transaction one at a time: a job whose rpmdb
+ * equals the one of a job prepared before reuses that job's solution (see
+ * transaction-plan.h), and packages are downloaded into the shared package
+ * cache just once. The actual commits run concurrently.
+ *
+ * The output of the jobs is relayed line by line, prefixed by the root.
+ */
+#ifndef ZYPPER_INSTALL_ROOTS_H
+#define ZYPPER_INSTALL_ROOTS_H
+
+#include "zypp/ZYppCommitPolicy.h"
+
+class Zypper;
+
+/** Whether the command supports more than one \c --root. */
+bool install_roots_supported( Zypper & zypper );
+
+/** Fork one job per install root, if more than one was given.
+ *
+ * To be called after the repository data were loaded and before the target
+ * is loaded. In a job the target is switched to the job's root and the
+ * function returns, so the job continues the command. The parent relays the
+ * jobs output, waits for them to finish, sets the exit code and throws an
+ * \ref ExitRequestException.
+ */
+void run_install_root_jobs( Zypper & zypper );
+
+/** If running as a job, exit it (does not return). The \ref Zypper::cleanup
+ * is left to the parent.
+ */
+void finish_install_root_job( Zypper & zypper );
+
+///////////////////////////////////////////////////////////////////
+/// \class InstallRootPrepareLock
+/// \brief Serializes solving and downloading among the jobs.
+///
+/// Outside of a job all methods are no-ops.
+///////////////////////////////////////////////////////////////////
+class InstallRootPrepareLock
+{
+public:
+  /** Take the lock and apply the plan of an earlier job with equal rpmdb
+   * and repos, if there is one.
+   */
+  InstallRootPrepareLock( Zypper & zypper );
+
+  /** Release the lock (if not yet released). */
+  ~InstallRootPrepareLock();
+
+  /** Publish the solution for later jobs (unless it was reused). */
+  void publish();
+
+  /** Download the packages needed by \a policy_r into the shared cache and
+   * release the lock.
+   */
+  void downloadAndRelease( const zypp::ZYppCommitPolicy & policy_r );
+
+private:
+  Zypper & _zypper;
+  int _fd;
+  bool _reused;
+};
+
+#endif // ZYPPER_INSTALL_ROOTS_H
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cstring>
 #include <signal.h>
 //#include <readline/readline.h>
 
@@ -7,6 +8,7 @@
 
 #include "main.h"
 #include "Zypper.h"
+#include "completion.h"
 
 #include "callbacks/rpm.h"
 #include "callbacks/keyring.h"
@@ -56,12 +58,20 @@ void signal_handler(int sig)
 
 int main(int argc, char **argv)
 {
+  // shell completion (see bash-completion.sh) reads just the completion
+  // index, so skip the usual startup
+  if (argc > 1 && ::strcmp(argv[1], "--complete") == 0)
+    return complete_command_line(argc - 2, argv + 2);
+
   struct Bye {
     ~Bye() {
       MIL << "===== Exiting main() =====" << endl;
     }
   } say_goodbye __attribute__ ((__unused__));
 
+  // buffer large listings unless writing to a terminal
+  out::setupSink();
+
   // set locale
   setlocale (LC_ALL, "");
   bindtextdomain (PACKAGE, LOCALEDIR);
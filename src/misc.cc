@@ -7,6 +7,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <boost/format.hpp>
 
 #include <zypp/ZYppFactory.h>
@@ -22,6 +23,8 @@
 
 #include <zypp/PoolQuery.h>
 #include <zypp/PoolItemBest.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/base/String.h>
 
 #include "Zypper.h"
 #include "main.h"
@@ -30,6 +33,7 @@
 #include "utils/prompt.h"
 #include "utils/getopt.h"
 #include "utils/richtext.h"
+#include "utils/suggest.h"
 
 #include "misc.h"
 
@@ -162,7 +166,6 @@ bool confirm_licenses(Zypper & zypper)
         continue;
       }
 
-      ostringstream s;
       string kindstr =
         it->resolvable()->kind() != ResKind::package ?
           " (" + kind_to_string_localized(it->resolvable()->kind(), 1) + ")" :
@@ -171,23 +174,37 @@ bool confirm_licenses(Zypper & zypper)
       if ( !it->resolvable()->needToAcceptLicense() )
         to_accept = false;
 
+      string intro;
       if (to_accept)
       {
         // introduction
-        s << str::form(
+        intro = str::form(
                        // translators: the first %s is the name of the package, the second
                        // is " (package-type)" if other than "package" (patch/product/pattern)
                        _("In order to install '%s'%s, you must agree"
                          " to terms of the following license agreement:"),
                        get_display_name(it->resolvable()).c_str(), kindstr.c_str());
-        s << endl << endl;
       }
-      // license text
-      printRichText( s, it->resolvable()->licenseToConfirm() );
 
-      // show in pager unless we are read by a machine or the pager fails
-      if (zypper.globalOpts().machine_readable || !show_text_in_pager(s.str()))
+      // show in pager unless we are read by a machine or the pager fails;
+      // the license text is rendered straight into the pager
+      bool shown = false;
+      if (!zypper.globalOpts().machine_readable)
+      {
+        Pager pager;
+        if (!intro.empty())
+          pager.stream() << intro << endl << endl;
+        printRichText( pager.stream(), it->resolvable()->licenseToConfirm() );
+        shown = pager.close();
+      }
+      if (!shown)
+      {
+        ostringstream s;
+        if (!intro.empty())
+          s << intro << endl << endl;
+        printRichText( s, it->resolvable()->licenseToConfirm() );
         zypper.out().info(s.str(), Out::QUIET);
+      }
 
       if (to_accept)
       {
@@ -485,6 +502,178 @@ pkg_spec_to_poolquery(const Capability & cap, const string & repo)
   return pkg_spec_to_poolquery(cap, repos);
 }
 
+namespace
+{
+  /** Names are matched case insensitively, like in a PoolQuery. */
+  inline string nameKey(const string & name_r)
+  { return str::toLower(name_r); }
+}
+
+bool PoolNameIndex::usable(const Capability & cap)
+{
+  sat::Solvable::SplitIdent splid(cap.detail().name());
+  return splid.name().asString().find_first_of("*?[\\") == string::npos;
+}
+
+const PoolNameIndex::NameMap & PoolNameIndex::names(const ResKind & kind)
+{
+  map<ResKind, NameMap>::iterator idx = _index.find(kind);
+  if (idx == _index.end())
+  {
+    idx = _index.insert(make_pair(kind, NameMap())).first;
+    for_(it, sat::Pool::instance().solvablesBegin(), sat::Pool::instance().solvablesEnd())
+    {
+      if (it->kind() == kind)
+        idx->second[nameKey(it->name())].push_back(*it);
+    }
+    DBG << "indexed " << idx->second.size() << " names of kind " << kind << endl;
+  }
+  return idx->second;
+}
+
+vector<sat::Solvable> PoolNameIndex::lookup(const Capability & cap, const list<string> & repos)
+{
+  sat::Solvable::SplitIdent splid(cap.detail().name());
+  const NameMap & index(names(splid.kind()));
+
+  vector<sat::Solvable> ret;
+  NameMap::const_iterator hit = index.find(nameKey(splid.name().asString()));
+  if (hit == index.end())
+    return ret;
+
+  // same as the edition and arch predicate of the PoolQuery
+  Arch arch(cap.detail().arch());
+  bool anyEdition = cap.detail().op() == Rel::ANY;
+  Edition::MatchRange range(cap.detail().op(), cap.detail().ed());
+  for_(it, hit->second.begin(), hit->second.end())
+  {
+    if (!repos.empty()
+        && find(repos.begin(), repos.end(), it->repository().alias()) == repos.end())
+      continue;
+    if (!arch.empty() && it->arch() != arch)
+      continue;
+    if (!anyEdition && !overlaps(Edition::MatchRange(Rel::EQ, it->edition()), range))
+      continue;
+    ret.push_back(*it);
+  }
+  return ret;
+}
+
+vector<sat::Solvable> PoolNameIndex::lookup(const ResKind & kind, const string & name)
+{
+  const NameMap & index(names(kind));
+  NameMap::const_iterator hit = index.find(nameKey(name));
+  return hit == index.end() ? vector<sat::Solvable>() : hit->second;
+}
+
+vector<string> PoolNameIndex::similar(const Capability & cap, unsigned max)
+{
+  sat::Solvable::SplitIdent splid(cap.detail().name());
+  // globs and non-name capabilities like /usr/bin/foo or perl(Foo)
+  if (!usable(cap) || splid.name().asString().find_first_of("/()") != string::npos)
+    return vector<string>();
+
+  std::shared_ptr<NameSuggester> & suggester(_suggesters[splid.kind()]);
+  if (!suggester)
+  {
+    const NameMap & index(names(splid.kind()));
+    vector<string> known;
+    known.reserve(index.size());
+    for_(it, index.begin(), index.end())
+      known.push_back(it->second.front().name());
+    suggester.reset(new NameSuggester(known));
+    DBG << "suggester for " << suggester->size() << " names of kind " << splid.kind() << endl;
+  }
+  return suggester->suggest(splid.name().asString(), max);
+}
+
+vector<sat::Solvable>
+pkg_spec_lookup(PoolNameIndex & index, const Capability & cap, const list<string> & repos)
+{
+  if (PoolNameIndex::usable(cap))
+    return index.lookup(cap, repos);
+
+  PoolQuery q = pkg_spec_to_poolquery(cap, repos);
+  return vector<sat::Solvable>(q.begin(), q.end());
+}
+
+namespace
+{
+  enum FormatTag
+  {
+    TAG_NAME, TAG_KIND, TAG_EDITION, TAG_VERSION, TAG_RELEASE, TAG_ARCH,
+    TAG_VENDOR, TAG_REPOSITORY, TAG_SUMMARY, TAG_DESCRIPTION,
+    TAG_INSTALLSIZE, TAG_DOWNLOADSIZE, TAG_BUILDTIME, TAG_STATUS
+  };
+
+  /** In the order of FormatTag */
+  const vector<string> & formatTags()
+  {
+    static const vector<string> _tags = {
+      "name", "kind", "edition", "version", "release", "arch",
+      "vendor", "repository", "summary", "description",
+      "installsize", "downloadsize", "buildtime", "status"
+    };
+    return _tags;
+  }
+}
+
+SolvableFormat::SolvableFormat(const string & format)
+  : _format(format, formatTags())
+{}
+
+void SolvableFormat::print(ostream & str, const PoolItem & pi, const string & status) const
+{
+  _format.print(str, [&](unsigned tag) -> string
+  {
+    switch (tag)
+    {
+    case TAG_NAME:         return pi->name();
+    case TAG_KIND:         return pi->kind().asString();
+    case TAG_EDITION:      return pi->edition().asString();
+    case TAG_VERSION:      return pi->edition().version();
+    case TAG_RELEASE:      return pi->edition().release();
+    case TAG_ARCH:         return pi->arch().asString();
+    case TAG_VENDOR:       return pi->vendor().asString();
+    case TAG_REPOSITORY:   return pi->repository().alias();
+    case TAG_SUMMARY:      return pi->summary();
+    case TAG_DESCRIPTION:  return pi->description();
+    case TAG_INSTALLSIZE:  return str::numstring((long long)pi->installSize());
+    case TAG_DOWNLOADSIZE: return str::numstring((long long)pi->downloadSize());
+    case TAG_BUILDTIME:    return str::numstring((long long)pi->buildtime());
+    case TAG_STATUS:       return status;
+    }
+    return string();
+  });
+}
+
+std::unique_ptr<SolvableFormat> get_solvable_format(Zypper & zypper)
+{
+  parsed_opts::const_iterator it = zypper.cOpts().find("format");
+  if (it == zypper.cOpts().end())
+    return std::unique_ptr<SolvableFormat>();
+
+  std::unique_ptr<SolvableFormat> ret(new SolvableFormat(it->second.back()));
+  // the template text would end up inside the XML or JSON document
+  if (!zypper.out().typeNORMAL())
+  {
+    zypper.out().error(str::form(_("Cannot use %s together with %s."), "--format",
+                                 zypper.out().typeJSON() ? "--jsonout" : "--xmlout"));
+    zypper.setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+    ret->reject();
+    return ret;
+  }
+  if (!ret->valid())
+  {
+    zypper.out().error(
+        // translators: %s is the reason, e.g. "unknown tag 'foo'"
+        str::form(_("Invalid --format template: %s."), ret->error().c_str()),
+        _("See 'man zypper' for the tags available."));
+    zypper.setExitCode(ZYPPER_EXIT_ERR_INVALID_ARGS);
+  }
+  return ret;
+}
+
 set<PoolItem>
 get_installed_providers(const Capability & cap)
 {
@@ -10,13 +10,21 @@
 
 #include <string>
 #include <list>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <memory>
 
 #include <zypp/PoolQuery.h>
+#include <zypp/sat/Solvable.h>
 #include <zypp/ResKind.h>
 #include <zypp/RepoInfo.h>
 #include <zypp/Capability.h>
 
+#include "utils/queryformat.h"
+
 class Zypper;
+class NameSuggester;
 
 /**
  * Loops through resolvables, checking if there is license to confirm. When
@@ -73,6 +81,96 @@ pkg_spec_to_poolquery(
     const zypp::Capability & cap,
     const std::string & repo = std::string());
 
+///////////////////////////////////////////////////////////////////
+/// \class PoolNameIndex
+/// \brief Pool solvables by kind and name, for resolving many package
+/// specs without running a PoolQuery for each of them.
+///
+/// The index of a kind is built on the first lookup of that kind, with
+/// a single pass over the pool. Lookups yield the same solvables as the
+/// query built by \ref pkg_spec_to_poolquery, as long as the name
+/// contains no glob characters (see \ref usable).
+///////////////////////////////////////////////////////////////////
+class PoolNameIndex
+{
+public:
+  /** Whether \a cap can be looked up here (its name is no glob). */
+  static bool usable(const zypp::Capability & cap);
+
+  /** Solvables matching the name, edition and arch of \a cap, in pool
+   * order. If \a repos is not empty, only those from these repos.
+   */
+  std::vector<zypp::sat::Solvable> lookup(
+      const zypp::Capability & cap,
+      const std::list<std::string> & repos = std::list<std::string>());
+
+  /** All solvables of \a kind named \a name (case insensitive), in pool
+   * order.
+   */
+  std::vector<zypp::sat::Solvable> lookup(const zypp::ResKind & kind, const std::string & name);
+
+  /** Up to \a max names of the kind of \a cap closest to its name, for
+   * "did you mean" hints. The \ref NameSuggester of a kind is built on the
+   * first call for that kind.
+   */
+  std::vector<std::string> similar(const zypp::Capability & cap, unsigned max = 3);
+
+private:
+  typedef std::unordered_map<std::string, std::vector<zypp::sat::Solvable> > NameMap;
+  const NameMap & names(const zypp::ResKind & kind);
+
+  std::map<zypp::ResKind, NameMap> _index;
+  std::map<zypp::ResKind, std::shared_ptr<NameSuggester> > _suggesters;
+};
+
+/**
+ * Solvables matching \a cap by name like \ref pkg_spec_to_poolquery, using
+ * \a index unless the name is a glob.
+ */
+std::vector<zypp::sat::Solvable>
+pkg_spec_lookup(
+    PoolNameIndex & index,
+    const zypp::Capability & cap,
+    const std::list<std::string> & repos = std::list<std::string>());
+
+///////////////////////////////////////////////////////////////////
+/// \class SolvableFormat
+/// \brief The \c --format template of the listing commands.
+///
+/// Tags are: name, kind, edition, version, release, arch, vendor,
+/// repository (alias), summary, description, installsize, downloadsize,
+/// buildtime and status (the S column of the tables: i, v or empty).
+///////////////////////////////////////////////////////////////////
+class SolvableFormat
+{
+public:
+  explicit SolvableFormat(const std::string & format);
+
+  bool valid() const
+  { return !_rejected && _format.valid(); }
+
+  /** Make \ref valid fail for a template which must not be used. */
+  void reject()
+  { _rejected = true; }
+
+  const std::string & error() const
+  { return _format.error(); }
+
+  /** Write the template for \a pi to \a str. */
+  void print(std::ostream & str, const zypp::PoolItem & pi, const std::string & status = "") const;
+
+private:
+  QueryFormat _format;
+  bool _rejected = false;
+};
+
+/**
+ * The \c --format template of the current command, if given. An invalid
+ * template, or one given with XML or JSON output, is reported and the
+ * exit code set; check \c valid().
+ */
+std::unique_ptr<SolvableFormat> get_solvable_format(Zypper & zypper);
+
 std::set<zypp::PoolItem>
 get_installed_providers(const zypp::Capability & cap);
 
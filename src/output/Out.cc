@@ -1,4 +1,5 @@
 #include <unistd.h>
+#include <stdio.h>
 
 #include <iostream>
 #include <sstream>
@@ -11,6 +12,53 @@
 
 #include "Zypper.h"
 
+////////////////////////////////////////////////////////////////////////////////
+//	output sink
+////////////////////////////////////////////////////////////////////////////////
+
+namespace out
+{
+  void setupSink( std::size_t bufsize_r )
+  {
+    if ( ::isatty( STDOUT_FILENO ) )
+      return;	// stay line buffered for the user
+
+    // stdout is flushed after static objects are destroyed, so the buffer
+    // is intentionally never freed.
+    static char * buffer = new char[bufsize_r];
+    ::setvbuf( stdout, buffer, _IOFBF, bufsize_r );
+  }
+
+  void flushSink()
+  {
+    std::cout.flush();
+    ::fflush( stdout );
+  }
+
+  std::ostream & writeXmlEscaped( std::ostream & str_r, const std::string & text_r )
+  {
+    const char * run = text_r.c_str();
+    const char * end = run + text_r.size();
+    for ( const char * p = run; p != end; ++p )
+    {
+      const char * entity = nullptr;
+      switch ( *p )
+      {
+	case '&':  entity = "&amp;";  break;
+	case '<':  entity = "&lt;";   break;
+	case '>':  entity = "&gt;";   break;
+	case '"':  entity = "&quot;"; break;
+	case '\'': entity = "&apos;"; break;
+	default:   continue;
+      }
+      str_r.write( run, p - run );
+      str_r << entity;
+      run = p + 1;
+    }
+    return str_r.write( run, end - run );
+  }
+} // namespace out
+
 ////////////////////////////////////////////////////////////////////////////////
 //	class TermLine
 ////////////////////////////////////////////////////////////////////////////////
@@ -32,6 +32,26 @@ class Zypper;
 namespace out
 {
   static constexpr unsigned termwidthUnlimited = 0u;
+
+  /** Set up the output sink for std::cout.
+   *
+   * Unless stdout is a terminal, it gets a large buffer of \a bufsize_r
+   * bytes, so listings written with \c '\\n' cost one write per buffer
+   * instead of one per line. The sink is flushed by \ref flushSink (on prompts
+   * and before error messages), by progress frames and on exit.
+   *
+   * Must be called before anything is written to stdout.
+   */
+  void setupSink( std::size_t bufsize_r = 64*1024 );
+
+  /** Write out everything buffered in the std::cout sink. */
+  void flushSink();
+
+  /** Write \a text_r XML-escaped to \a str_r.
+   * Unlike \c xml::escape no temporary string is built; runs of plain
+   * characters are written as they are.
+   */
+  std::ostream & writeXmlEscaped( std::ostream & str_r, const std::string & text_r );
 } // namespace out
 ///////////////////////////////////////////////////////////////////
 
@@ -273,7 +293,8 @@ public:
   enum TypeBit
   {
     TYPE_NORMAL = 0x01<<0,	///< plain text output
-    TYPE_XML    = 0x01<<1	///< xml output
+    TYPE_XML    = 0x01<<1,	///< xml output
+    TYPE_JSON   = 0x01<<2	///< json output (array or NDJSON)
   };
   ZYPP_DECLARE_FLAGS(Type,TypeBit);
 
@@ -688,6 +709,8 @@ public:
   bool typeNORMAL() const { return type( TYPE_NORMAL ); }
   /** \overload test for TPE_XML */
   bool typeXML() const { return type( TYPE_XML ); }
+  /** \overload test for TYPE_JSON */
+  bool typeJSON() const { return type( TYPE_JSON ); }
 
 protected:
   /** Width for formated output [0==unlimited]. */
@@ -0,0 +1,338 @@
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+
+#include <zypp/base/String.h>
+
+#include "OutJSON.h"
+#include "utils/misc.h"
+#include "Table.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::ostringstream;
+
+///////////////////////////////////////////////////////////////////
+namespace jsonout
+{
+  namespace
+  {
+    bool _ndjson = false;	//< set by OutJSON
+    bool _open = false;		//< OutJSON started and not yet finished
+    unsigned _records = 0;	//< records written so far
+    bool _firstMember = true;	//< in the current record
+  }
+
+  std::ostream & writeString( std::ostream & str_r, const std::string & text_r )
+  {
+    str_r << '"';
+    const char * run = text_r.c_str();
+    const char * end = run + text_r.size();
+    for ( const char * p = run; p != end; ++p )
+    {
+      unsigned char ch = *p;
+      if ( ch >= 0x20 && ch != '"' && ch != '\\' )
+	continue;	// UTF-8 passes unchanged
+
+      str_r.write( run, p - run );
+      switch ( ch )
+      {
+	case '"':  str_r << "\\\""; break;
+	case '\\': str_r << "\\\\"; break;
+	case '\n': str_r << "\\n";  break;
+	case '\r': str_r << "\\r";  break;
+	case '\t': str_r << "\\t";  break;
+	default:
+	{
+	  char buf[7];
+	  ::snprintf( buf, sizeof(buf), "\\u%04x", ch );
+	  str_r << buf;
+	}
+      }
+      run = p + 1;
+    }
+    str_r.write( run, end - run );
+    return str_r << '"';
+  }
+
+  bool ndjson()
+  { return _ndjson; }
+
+  unsigned recordCount()
+  { return _records; }
+
+  void finish()
+  {
+    if ( ! _open )
+      return;
+    _open = false;
+    if ( ! _ndjson )
+      cout << "\n]";
+    cout << endl;
+  }
+
+  void writeRecords( const std::string & text_r, unsigned count_r )
+  {
+    if ( ! count_r )
+    {
+      cout << text_r;
+      return;
+    }
+    // the separator depends on what was written before
+    std::string::size_type start = 0;
+    if ( ! _ndjson )
+    {
+      if ( ! text_r.empty() && text_r[0] == ',' )
+	start = 1;
+      if ( _records )
+	cout << ',';
+    }
+    cout.write( text_r.data() + start, text_r.size() - start );
+    _records += count_r;
+  }
+
+  Record::Record( const char * type_r )
+  {
+    if ( ! _ndjson )
+      cout << ( _records ? ",\n" : "\n" );
+    ++_records;
+    cout << '{';
+    _firstMember = true;
+    operator()( "type", type_r );
+  }
+
+  Record::~Record()
+  {
+    cout << '}';
+    if ( _ndjson )
+      cout << '\n';
+  }
+
+  std::ostream & Record::key( const char * key_r )
+  {
+    if ( ! _firstMember )
+      cout << ',';
+    _firstMember = false;
+    cout << '"' << key_r << "\":";
+    return cout;
+  }
+
+  Record & Record::operator()( const char * key_r, const std::string & value_r )
+  { writeString( key( key_r ), value_r ); return *this; }
+
+  Record & Record::operator()( const char * key_r, const char * value_r )
+  { writeString( key( key_r ), value_r ); return *this; }
+
+  Record & Record::operator()( const char * key_r, bool value_r )
+  { key( key_r ) << ( value_r ? "true" : "false" ); return *this; }
+
+} // namespace jsonout
+///////////////////////////////////////////////////////////////////
+
+OutJSON::OutJSON(Verbosity verbosity_r, bool ndjson_r) : Out(TYPE_JSON, verbosity_r)
+{
+  jsonout::_ndjson = ndjson_r;
+  jsonout::_open = true;
+  if (!ndjson_r)
+    cout << '[';
+
+  // exit() paths (e.g. from the signal handler) must not depend on
+  // the destruction order of static objects
+  static bool registered = ( std::atexit( jsonout::finish ) == 0 );
+  (void)registered;
+}
+
+OutJSON::~OutJSON()
+{
+  jsonout::finish();
+}
+
+bool OutJSON::mine(Type type)
+{
+  // Type::TYPE_JSON is mine
+  if (type & Out::TYPE_JSON)
+    return true;
+  return false;
+}
+
+bool OutJSON::infoWarningFilter(Verbosity verbosity_r, Type mask)
+{
+  if (!mine(mask))
+    return true;
+  if (verbosity() < verbosity_r)
+    return true;
+  return false;
+}
+
+void OutJSON::info(const string & msg, Verbosity verbosity_r, Type mask)
+{
+  if (infoWarningFilter(verbosity_r, mask))
+    return;
+
+  jsonout::Record("message")("kind", "info")("text", msg);
+}
+
+void OutJSON::warning(const string & msg, Verbosity verbosity_r, Type mask)
+{
+  if (infoWarningFilter(verbosity_r, mask))
+    return;
+
+  jsonout::Record("message")("kind", "warning")("text", msg);
+}
+
+void OutJSON::error(const string & problem_desc, const string & hint)
+{
+  jsonout::Record rec("message");
+  rec("kind", "error")("text", problem_desc);
+  if (!hint.empty())
+    rec("hint", hint);
+}
+
+void OutJSON::error(const zypp::Exception & e,
+                    const string & problem_desc,
+                    const string & hint)
+{
+  ostringstream s;
+  // problem
+  s << problem_desc << endl;
+  // cause
+  s << zyppExceptionReport(e);
+
+  jsonout::Record rec("message");
+  rec("kind", "error")("text", s.str());
+  if (!hint.empty())
+    rec("hint", hint);
+}
+
+void OutJSON::writeProgressRecord(const string & id, const string & label,
+                                  int value, bool done, bool error)
+{
+  {
+    jsonout::Record rec("progress");
+    rec("id", id)("name", label);
+    if (done)
+      rec("done", true)("error", error);
+    // print value only if it is known (percentage progress)
+    // missing value means 'is-alive' notification
+    else if (value >= 0)
+      rec("value", value);
+  }
+  cout << std::flush;	// let consumers follow progress
+}
+
+void OutJSON::progressStart(const string & id,
+                            const string & label,
+                            bool has_range)
+{
+  if (progressFilter())
+    return;
+
+  writeProgressRecord(id, label, has_range ? 0 : -1, false);
+}
+
+void OutJSON::progress(const string & id,
+                       const string& label,
+                       int value)
+{
+  if (progressFilter())
+    return;
+
+  writeProgressRecord(id, label, value, false);
+}
+
+void OutJSON::progressEnd(const string & id, const string& label, bool error)
+{
+  if (progressFilter())
+    return;
+
+  writeProgressRecord(id, label, 100, true, error);
+}
+
+void OutJSON::dwnldProgressStart(const zypp::Url & uri)
+{
+  jsonout::Record("download")("url", uri.asString())("percent", -1)("rate", -1);
+  cout << std::flush;
+}
+
+void OutJSON::dwnldProgress(const zypp::Url & uri,
+                            int value,
+                            long rate)
+{
+  jsonout::Record("download")("url", uri.asString())("percent", value)("rate", rate);
+  cout << std::flush;
+}
+
+void OutJSON::dwnldProgressEnd(const zypp::Url & uri, long rate, bool error)
+{
+  jsonout::Record("download")("url", uri.asString())("rate", rate)("done", true)("error", error);
+  cout << std::flush;
+}
+
+void OutJSON::searchResult( const Table & table_r )
+{
+  // Same column to key mapping as in OutXML::searchResult
+  std::vector<std::string> header;
+  {
+    const TableHeader & theader( table_r.header() );
+    for_( it, theader.columns().begin(), theader.columns().end() )
+    {
+      if ( *it == "S" )
+	header.push_back( "status" );
+      else if ( *it == "Type" )
+	header.push_back( "kind" );
+      else if ( *it == "Version" )
+	header.push_back( "edition" );
+      else
+	header.push_back( zypp::str::toLower( *it ) );
+    }
+  }
+
+  const Table::container & rows( table_r.rows() );
+  for_( it, rows.begin(), rows.end() )
+  {
+    jsonout::Record rec( "solvable" );
+    const TableRow::container & cols( it->columns() );
+    unsigned cidx = 0;
+    for_( cit, cols.begin(), cols.end() )
+    {
+      const char * key = cidx < header.size() ? header[cidx].c_str() : "?";
+      if ( cidx == 0 )
+	rec( key, *cit == "i" ? "installed" : *cit == "v" ? "other-version" : "not-installed" );
+      else
+	rec( key, *cit );
+      ++cidx;
+    }
+  }
+}
+
+void OutJSON::prompt(PromptId id,
+                     const string & prompt,
+                     const PromptOptions & poptions,
+                     const string & startdesc)
+{
+  {
+    jsonout::Record rec("prompt");
+    rec("id", int(id))("text", prompt);
+    if (!startdesc.empty())
+      rec("description", startdesc);
+    if (poptions.defaultOpt() < poptions.options().size())
+      rec("default", poptions.options()[poptions.defaultOpt()]);
+  }
+
+  unsigned int i = 0;
+  for (PromptOptions::StrVector::const_iterator it = poptions.options().begin();
+       it != poptions.options().end(); ++it, ++i)
+  {
+    if (poptions.isDisabled(i))
+      continue;
+    jsonout::Record("prompt-option")("prompt", int(id))("value", *it)("desc", poptions.optionHelp(i));
+  }
+  cout << std::flush;
+}
+
+void OutJSON::promptHelp(const PromptOptions & poptions)
+{
+  // nothing to do here
+}
@@ -0,0 +1,124 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef OUTJSON_H_
+#define OUTJSON_H_
+
+#include <type_traits>
+
+#include "Out.h"
+
+///////////////////////////////////////////////////////////////////
+namespace jsonout
+{
+  /** Write \a text_r as quoted and escaped JSON string to \a str_r. */
+  std::ostream & writeString( std::ostream & str_r, const std::string & text_r );
+
+  /** Whether writing one record per line (NDJSON). */
+  bool ndjson();
+
+  /** Number of records written so far. */
+  unsigned recordCount();
+
+  /** Close the JSON array (flush NDJSON) of the active \ref OutJSON.
+   * Done just once, later calls are no-ops. Called when zypper leaves
+   * \ref Zypper::main and, for \c exit() and signal paths, from an
+   * \c atexit handler.
+   */
+  void finish();
+
+  /** Write \a text_r, \a count_r records captured from an earlier run
+   * (see \ref ResultCache), as if they were written now.
+   */
+  void writeRecords( const std::string & text_r, unsigned count_r );
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class Record
+  /// \brief One flat JSON object written straight to std::cout.
+  ///
+  /// Every record carries a \c type member. Depending on the mode of
+  /// \ref OutJSON the records are elements of one JSON array or
+  /// (NDJSON) one per line.
+  /// \code
+  ///   jsonout::Record( "repo" )( "alias", repo.alias() )( "enabled", repo.enabled() );
+  /// \endcode
+  ///////////////////////////////////////////////////////////////////
+  class Record : private zypp::base::NonCopyable
+  {
+  public:
+    explicit Record( const char * type_r );
+    ~Record();
+
+    Record & operator()( const char * key_r, const std::string & value_r );
+    Record & operator()( const char * key_r, const char * value_r );
+    Record & operator()( const char * key_r, bool value_r );
+
+    template <class _Int, typename = typename std::enable_if<std::is_integral<_Int>::value>::type>
+    Record & operator()( const char * key_r, _Int value_r )
+    { key( key_r ) << value_r; return *this; }
+
+  private:
+    std::ostream & key( const char * key_r );
+  };
+} // namespace jsonout
+///////////////////////////////////////////////////////////////////
+
+class OutJSON : public Out
+{
+public:
+  /** \a ndjson_r: one record per line instead of one JSON array. */
+  OutJSON(Verbosity verbosity = NORMAL, bool ndjson_r = false);
+  virtual ~OutJSON();
+
+public:
+  virtual void info(const std::string & msg, Verbosity verbosity = NORMAL, Type mask = TYPE_ALL);
+  virtual void warning(const std::string & msg, Verbosity verbosity = NORMAL, Type mask = TYPE_ALL);
+  virtual void error(const std::string & problem_desc, const std::string & hint = "");
+  virtual void error(const zypp::Exception & e,
+             const std::string & problem_desc,
+             const std::string & hint = "");
+
+  // progress
+  virtual void progressStart(const std::string & id,
+                             const std::string & label,
+                             bool is_tick = false);
+  virtual void progress(const std::string & id,
+                        const std::string & label,
+                        int value = -1);
+  virtual void progressEnd(const std::string & id,
+                           const std::string & label,
+                           bool error);
+
+  // progress with download rate
+  virtual void dwnldProgressStart(const zypp::Url & uri);
+  virtual void dwnldProgress(const zypp::Url & uri,
+                             int value = -1,
+                             long rate = -1);
+  virtual void dwnldProgressEnd(const zypp::Url & uri,
+                                long rate = -1,
+                                bool error = false);
+
+  virtual void searchResult( const Table & table_r );
+
+  virtual void prompt(PromptId id,
+                      const std::string & prompt,
+                      const PromptOptions & poptions,
+                      const std::string & startdesc = "");
+
+  virtual void promptHelp(const PromptOptions & poptions);
+
+protected:
+  virtual bool mine(Type type);
+
+private:
+  bool infoWarningFilter(Verbosity verbosity, Type mask);
+  void writeProgressRecord(const std::string & id,
+                           const std::string & label,
+                           int value, bool done, bool error = false);
+};
+
+#endif /*OUTJSON_H_*/
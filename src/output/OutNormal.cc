@@ -26,7 +26,8 @@ using namespace std;
 
 OutNormal::OutNormal(Verbosity verbosity_r)
   : Out(TYPE_NORMAL, verbosity_r),
-    _use_colors(false), _isatty(isatty(STDOUT_FILENO)), _newline(true), _oneup(false)
+    _use_colors(false), _isatty(isatty(STDOUT_FILENO)), _newline(true), _oneup(false),
+    _frame_rate(10)
 {}
 
 OutNormal::~OutNormal()
@@ -88,6 +89,7 @@ void OutNormal::error(const std::string & problem_desc, const std::string & hint
 {
   if (!_newline)
     cout << endl;
+  out::flushSink();	// keep order with stderr
 
   cerr << ( ColorContext::MSG_ERROR << problem_desc );
   if (!hint.empty() && verbosity() > Out::QUIET)
@@ -104,6 +106,7 @@ void OutNormal::error(const zypp::Exception & e,
 {
   if (!_newline)
     cout << endl;
+  out::flushSink();	// keep order with stderr
 
   // problem and cause
   cerr << ( ColorContext::MSG_ERROR << problem_desc << endl << zyppExceptionReport(e) ) << endl;
@@ -117,10 +120,44 @@ void OutNormal::error(const zypp::Exception & e,
 
 // ----------------------------------------------------------------------------
 
-void OutNormal::displayProgress (const string & s, int percent)
+bool OutNormal::progressFrameDue(bool force)
+{
+  std::chrono::steady_clock::time_point now( std::chrono::steady_clock::now() );
+  if ( force || _newline
+       || now - _last_frame >= std::chrono::milliseconds( 1000 / _frame_rate ) )
+  {
+    _last_frame = now;
+    return true;
+  }
+  return false;
+}
+
+void OutNormal::drawProgressLine(const std::string & outline)
+{
+  if (!_newline && outline == _progress_line)
+    return;
+
+  // compose the whole frame so it is written with a single flush
+  std::string frame;
+  frame.reserve( outline.size() + 16 );
+  if(_oneup)
+    frame += CLEARLN CURSORUP(1);
+  frame += CLEARLN;
+  frame += outline;
+  cout << frame << std::flush;
+  _progress_line = outline;
+  // no _oneup if CRUSHed // _oneup = ( outline.length() > termwidth() );
+}
+
+// ----------------------------------------------------------------------------
+
+void OutNormal::displayProgress (const string & s, int percent, bool force)
 {
   static AliveCursor cursor;
 
+  if (!progressFrameDue(force || percent == 100))
+    return;
+
   if (_isatty)
   {
     TermLine outstr( TermLine::SF_CRUSH | TermLine::SF_EXPAND, '-' );
@@ -134,13 +171,7 @@ void OutNormal::displayProgress (const string & s, int percent)
     ++cursor;
     outstr.rhs << '[' << cursor.current() << ']';
 
-    if(_oneup)
-      cout << CLEARLN << CURSORUP(1);
-    cout << CLEARLN;
-
-    std::string outline( outstr.get( termwidth() ) );
-    cout << outline << std::flush;
-    // no _oneup if CRUSHed // _oneup = ( outline.length() > termwidth() );
+    drawProgressLine( outstr.get( termwidth() ) );
   }
   else
     cout << '.' << std::flush;
@@ -148,10 +179,13 @@ void OutNormal::displayProgress (const string & s, int percent)
 
 // ----------------------------------------------------------------------------
 
-void OutNormal::displayTick (const string & s)
+void OutNormal::displayTick (const string & s, bool force)
 {
   static AliveCursor cursor;
 
+  if (!progressFrameDue(force))
+    return;
+
   if (_isatty)
   {
     TermLine outstr( TermLine::SF_CRUSH | TermLine::SF_EXPAND, '-' );
@@ -159,13 +193,7 @@ void OutNormal::displayTick (const string & s)
     outstr.lhs << s << ' ';
     outstr.rhs << '[' << cursor.current() << ']';
 
-    if(_oneup)
-      cout << CLEARLN << CURSORUP(1);
-    cout << CLEARLN;
-
-    std::string outline( outstr.get( termwidth() ) );
-    cout << outline << std::flush;
-    // no _oneup if CRUSHed // _oneup = ( outline.length() > termwidth() );
+    drawProgressLine( outstr.get( termwidth() ) );
   }
   else
     cout << '.' << std::flush;
@@ -184,9 +212,9 @@ void OutNormal::progressStart(const std::string & id,
     cout << label << " [";
 
   if (is_tick)
-    displayTick(label);
+    displayTick(label, true);
   else
-    displayProgress(label, 0);
+    displayProgress(label, 0, true);
 
   _newline = false;
 }
@@ -272,6 +300,7 @@ void OutNormal::dwnldProgressStart(const zypp::Url & uri)
   std::string outline( outstr.get( termwidth() ) );
   cout << outline << std::flush;
   // no _oneup if CRUSHed // _oneup = (outline.length() > termwidth());
+  _progress_line.clear();
 
   _newline = false;
 }
@@ -283,16 +312,15 @@ void OutNormal::dwnldProgress(const zypp::Url & uri,
   if (verbosity() < NORMAL)
     return;
 
+  if (!progressFrameDue(value == 100))
+    return;
+
   if (!isatty(STDOUT_FILENO))
   {
     cout << '.' << std::flush;
     return;
   }
 
-  if(_oneup)
-    cout << CLEARLN << CURSORUP(1);
-  cout << CLEARLN;
-
   TermLine outstr( TermLine::SF_CRUSH | TermLine::SF_EXPAND, '-' );
   outstr.lhs << _("Retrieving:") << " ";
   if (verbosity() == DEBUG)
@@ -312,9 +340,7 @@ void OutNormal::dwnldProgress(const zypp::Url & uri,
     outstr.rhs << " (" << zypp::ByteCount(rate) << "/s)";
   outstr.rhs << ']';
 
-  std::string outline( outstr.get( termwidth() ) );
-  cout << outline << std::flush;
-  // no _oneup if CRUSHed // _oneup = (outline.length() > termwidth());
+  drawProgressLine( outstr.get( termwidth() ) );
   _newline = false;
 }
 
@@ -8,6 +8,8 @@
 #ifndef OUTNORMAL_H_
 #define OUTNORMAL_H_
 
+#include <chrono>
+
 #include "Out.h"
 #include <termios.h>
 #include <sys/ioctl.h>
@@ -77,6 +79,10 @@ public:
   void setUseColors(bool value)
   { _use_colors = value; }
 
+  /** Redraw progress lines at most \a value times per second (1-1000, see Config). */
+  void setProgressFrameRate(unsigned value)
+  { _frame_rate = value; }
+
 protected:
   virtual bool mine(Type type);
 
@@ -85,8 +91,13 @@ protected:
 
 private:
   bool infoWarningFilter(Verbosity verbosity, Type mask);
-  void displayProgress(const std::string & s, int percent);
-  void displayTick(const std::string & s);
+  void displayProgress(const std::string & s, int percent, bool force = false);
+  void displayTick(const std::string & s, bool force = false);
+
+  /** Whether the next progress frame is due (always if \a force or after other output). */
+  bool progressFrameDue(bool force);
+  /** Redraw the progress line if it changed, writing the frame at once. */
+  void drawProgressLine(const std::string & outline);
 
   bool _use_colors;
   bool _isatty;
@@ -95,6 +106,12 @@ private:
   bool _newline;
   /* True if the last output line was longer than the terminal width */
   bool _oneup;
+  /* Max progress redraws per second, 1-1000 */
+  unsigned _frame_rate;
+  /* Time the last progress frame was drawn */
+  std::chrono::steady_clock::time_point _last_frame;
+  /* The progress line currently shown (valid if !_newline) */
+  std::string _progress_line;
 };
 
 #endif /*OUTNORMAL_H_*/
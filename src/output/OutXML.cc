@@ -236,16 +236,16 @@ void OutXML::searchResult( const Table & table_r )
 	}
 	else
 	{
-	  cout << xml::escape(*cit) << '"';
+	  out::writeXmlEscaped( cout, *cit ) << '"';
 	}
 	++cidx;
       }
-      cout << "/>" << endl;
+      cout << "/>" << '\n';
     }
   }
     //Out::searchResult( table_r );
 
-  cout << "</solvable-list>" << endl;
+  cout << "</solvable-list>" << '\n';
   cout << "</search-result>" << endl;
 }
 
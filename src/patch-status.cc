@@ -0,0 +1,242 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <sys/stat.h>
+
+#include <zypp/ZYpp.h>
+#include <zypp/base/LogTools.h>
+#include <zypp/base/String.h>
+#include <zypp/PathInfo.h>
+#include <zypp/ResPool.h>
+#include <zypp/Patch.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/target/rpm/RpmDb.h>
+
+#include "Zypper.h"
+#include "repos.h"
+#include "solve-commit.h"
+#include "result-cache.h"
+#include "patch-status.h"
+
+extern ZYpp::Ptr God;
+
+///////////////////////////////////////////////////////////////////
+namespace
+{
+  typedef std::map<std::string,std::string> RepoCookies;
+
+  Pathname snapshotFile( Zypper & zypper )
+  { return zypper.globalOpts().rm_options.repoCachePath / "patch-status"; }
+
+  /** Cookie of the target's rpmdb file: inode, mtime and ctime in ns and
+   * size (\c "-" if there is none). Whole seconds would miss a second
+   * commit within the same second. Needs the target initialized.
+   */
+  std::string rpmdbCookie( Zypper & zypper )
+  {
+    Pathname file( Pathname::assertprefix( zypper.globalOpts().root_dir,
+                                           God->target()->rpmDb().dbPath() / "Packages" ) );
+    struct stat st;
+    if ( ::stat( file.c_str(), &st ) != 0 )
+      return "-";
+    return str::form( "%llu-%lld.%09ld-%lld.%09ld-%llu",
+		      (unsigned long long)st.st_ino,
+		      (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec,
+		      (long long)st.st_ctim.tv_sec, (long)st.st_ctim.tv_nsec,
+		      (unsigned long long)st.st_size );
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class Snapshot
+  /// \brief A parsed snapshot file.
+  ///////////////////////////////////////////////////////////////////
+  struct Snapshot
+  {
+    /** Parse \a file_r; \c false if it is not readable or malformed. */
+    bool read( const Pathname & file_r )
+    {
+      std::ifstream str( file_r.c_str() );
+      if ( ! str )
+	return false;
+
+      std::string line;
+      unsigned lineno = 0;
+      while ( std::getline( str, line ) )
+      {
+	++lineno;
+	line = str::trim( line );
+	if ( line.empty() || line[0] == '#' )
+	  continue;
+
+	std::istringstream words( line );
+	std::string tag;
+	words >> tag;
+	bool ok = false;
+	if ( tag == "rpmdb" )
+	  ok = bool( words >> _rpmdb );
+	else if ( tag == "repo" )
+	{
+	  std::string alias;
+	  std::string cookie;
+	  if ( ( ok = bool( words >> alias >> cookie ) ) )
+	    _repos[alias] = cookie;
+	}
+	else if ( tag == "needed" )
+	  ok = bool( words >> _status._needed );
+	else if ( tag == "security" )
+	  ok = bool( words >> _status._security );
+	else if ( tag == "category" || tag == "severity" )
+	{
+	  std::string name;
+	  unsigned count;
+	  if ( ( ok = bool( words >> name >> count ) ) )
+	    ( tag == "category" ? _status._categories : _status._severities )[name] = count;
+	}
+	if ( ! ok )
+	{
+	  ERR << file_r << ":" << lineno << ": malformed line '" << line << "'" << endl;
+	  return false;
+	}
+      }
+      return ! _rpmdb.empty();
+    }
+
+    std::string _rpmdb;
+    RepoCookies _repos;
+    PatchStatus _status;
+  };
+
+} // namespace
+///////////////////////////////////////////////////////////////////
+
+PatchStatus PatchStatus::fromPool()
+{
+  PatchStatus ret;
+  for_( it, God->pool().byKindBegin(ResKind::patch), God->pool().byKindEnd(ResKind::patch) )
+  {
+    if ( ! it->isRelevant() || it->isSatisfied() )
+      continue;
+
+    Patch::constPtr patch( asKind<Patch>( it->resolvable() ) );
+    ++ret._needed;
+    if ( patch->categoryEnum() == Patch::CAT_SECURITY )
+      ++ret._security;
+    ++ret._categories[patch->category().empty() ? "-" : patch->category()];
+    ++ret._severities[patch->severity().empty() ? "-" : patch->severity()];
+  }
+  return ret;
+}
+
+PatchStatusSnapshot::PatchStatusSnapshot( Zypper & zypper )
+: _zypper( zypper )
+{
+  // without the installed packages the counts mean something different
+  if ( ! zypper.globalOpts().disable_system_resolvables )
+    _rpmdb = rpmdbCookie( zypper );
+  if ( _rpmdb == "-" )
+    _rpmdb.clear();	// no rpmdb, no snapshot
+}
+
+bool PatchStatusSnapshot::read( PatchStatus & status_r ) const
+{
+  if ( _rpmdb.empty() )
+    return false;
+
+  Snapshot snapshot;
+  if ( ! snapshot.read( snapshotFile( _zypper ) ) )
+    return false;
+
+  if ( snapshot._rpmdb != _rpmdb )
+  {
+    MIL << "Patch status snapshot outdated: rpmdb differs" << endl;
+    return false;
+  }
+
+  RepoCookies repos;
+  const std::list<RepoInfo> & infos( _zypper.runtimeData().repos );
+  for_( it, infos.begin(), infos.end() )
+  {
+    if ( it->enabled() )
+      repos[it->alias()] = repo_cookie( _zypper, *it );
+  }
+  if ( snapshot._repos != repos )
+  {
+    MIL << "Patch status snapshot outdated: repos differ" << endl;
+    return false;
+  }
+
+  MIL << "Using patch status snapshot" << endl;
+  status_r = snapshot._status;
+  return true;
+}
+
+void PatchStatusSnapshot::write( const PatchStatus & status_r ) const
+{
+  if ( _rpmdb.empty() )
+    return;
+
+  Pathname file( snapshotFile( _zypper ) );
+  Pathname tmpfile( file.extend( ".new" ) );
+  {
+    std::ofstream str( tmpfile.c_str() );
+    str << "# zypper patch status snapshot" << endl;
+    str << "rpmdb " << _rpmdb << endl;
+    for_( it, sat::Pool::instance().reposBegin(), sat::Pool::instance().reposEnd() )
+    {
+      if ( ! it->isSystemRepo() )
+	str << "repo " << it->alias() << ' ' << repo_cookie( _zypper, it->info() ) << endl;
+    }
+    str << "needed " << status_r._needed << endl;
+    str << "security " << status_r._security << endl;
+    for ( const auto & cat : status_r._categories )
+      str << "category " << cat.first << ' ' << cat.second << endl;
+    for ( const auto & sev : status_r._severities )
+      str << "severity " << sev.first << ' ' << sev.second << endl;
+
+    if ( ! str )
+    {
+      WAR << "Cannot write patch status snapshot " << tmpfile << endl;
+      filesystem::unlink( tmpfile );
+      return;
+    }
+  }
+  if ( filesystem::rename( tmpfile, file ) != 0 )
+  {
+    WAR << "Cannot write patch status snapshot " << file << endl;
+    filesystem::unlink( tmpfile );
+    return;
+  }
+  MIL << "Wrote patch status snapshot " << file << endl;
+}
+
+void update_patch_status_snapshot( Zypper & zypper )
+{
+  // don't slow down the refresh of people who never asked for one
+  if ( ! PathInfo( snapshotFile( zypper ) ).isExist() )
+    return;
+
+  // refresh shows the refresh, not the loading of the pool
+  SCOPED_VERBOSITY( zypper.out(), Out::QUIET );
+  init_target( zypper );
+  PatchStatusSnapshot snapshot( zypper );
+  RuntimeData & gData( zypper.runtimeData() );
+  if ( gData.repos.empty() )
+    gData.repos.insert( gData.repos.end(), zypper.repoManager().repoBegin(), zypper.repoManager().repoEnd() );
+
+  PatchStatus status;
+  if ( snapshot.read( status ) )
+    return;
+
+  MIL << "Updating patch status snapshot" << endl;
+  load_resolvables( zypper );
+  resolve( zypper );
+  snapshot.write( PatchStatus::fromPool() );
+}
@@ -0,0 +1,92 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/**
+ * Patch status snapshot (patch-check).
+ *
+ * Counting the needed patches requires loading all repos and the rpmdb and
+ * validating every patch. The counts are therefore stored in
+ * <tt>[repoCachePath]/patch-status</tt> together with the cookies of the
+ * rpmdb and the repositories they were computed from. \c patch-check answers
+ * from the snapshot as long as the cookies still match.
+ *
+ * The rpmdb cookie is taken from the target's rpmdb file itself (not from
+ * its content as in transaction-plan.h), so it can be checked without
+ * reading the installed packages.
+ *
+ * File format (one record per line, '#' starts a comment):
+ * \code
+ * rpmdb <cookie>
+ * repo <alias> <cookie>
+ * needed <count>
+ * security <count>
+ * category <category> <count>
+ * severity <severity> <count>
+ * \endcode
+ */
+#ifndef ZYPPER_PATCH_STATUS_H
+#define ZYPPER_PATCH_STATUS_H
+
+#include <map>
+#include <string>
+
+class Zypper;
+
+///////////////////////////////////////////////////////////////////
+/// \class PatchStatus
+/// \brief Counts of the needed patches.
+///////////////////////////////////////////////////////////////////
+struct PatchStatus
+{
+  PatchStatus()
+  : _needed( 0 ), _security( 0 )
+  {}
+
+  /** Count the needed patches in the (resolved) pool. */
+  static PatchStatus fromPool();
+
+  unsigned _needed;		//< needed patches
+  unsigned _security;		//< needed security patches
+  std::map<std::string,unsigned> _categories;	//< needed patches per category
+  std::map<std::string,unsigned> _severities;	//< needed patches per severity
+};
+
+///////////////////////////////////////////////////////////////////
+/// \class PatchStatusSnapshot
+/// \brief The stored \ref PatchStatus of this system.
+///
+/// The rpmdb cookie is taken on construction, i.e. before the pool is
+/// loaded, so a commit running meanwhile can't get a snapshot wrongly
+/// accepted later. The target must be initialized.
+///////////////////////////////////////////////////////////////////
+class PatchStatusSnapshot
+{
+public:
+  explicit PatchStatusSnapshot( Zypper & zypper );
+
+  /** Read the snapshot if it matches the rpmdb and the enabled repos in
+   * \ref RuntimeData::repos (to be called before loading them).
+   * \returns whether \a status_r was set.
+   */
+  bool read( PatchStatus & status_r ) const;
+
+  /** Store \a status_r for the repos loaded into the pool. Failure is just
+   * logged, the snapshot is an optimization only.
+   */
+  void write( const PatchStatus & status_r ) const;
+
+private:
+  Zypper & _zypper;
+  std::string _rpmdb;
+};
+
+/** After a refresh: update an existing snapshot if it does not match the
+ * refreshed repos anymore. This loads the pool, without reporting it.
+ */
+void update_patch_status_snapshot( Zypper & zypper );
+
+#endif // ZYPPER_PATCH_STATUS_H
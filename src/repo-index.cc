@@ -0,0 +1,142 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/PathInfo.h>
+
+#include "Zypper.h"
+#include "result-cache.h"
+#include "repo-index.h"
+
+using namespace zypp;
+
+struct RepoIndex::Header
+{
+  char _magic[8];
+  uint32_t _solvables;
+  char _cookie[100];
+};
+
+RepoIndex::RepoIndex( const Repository & repo_r, const char * magic_r )
+  : _repo( repo_r )
+  , _magic( magic_r )
+  , _first( 0 )
+{}
+
+RepoIndex::~RepoIndex()
+{}
+
+bool RepoIndex::load( Zypper & zypper, const std::string & name_r )
+{
+  // offsets work only if the repo is one block of ids
+  sat::detail::SolvableIdType last = 0;
+  for_( it, _repo.solvablesBegin(), _repo.solvablesEnd() )
+  {
+    if ( ! _first )
+      _first = it->id();
+    last = it->id();
+  }
+  if ( ! _first || last - _first + 1 != _repo.solvablesSize() )
+  {
+    DBG << "Can't index " << _repo.alias() << ": solvables not contiguous" << endl;
+    return false;
+  }
+
+  Pathname solv( zypper.globalOpts().rm_options.repoSolvCachePath
+               / ( _repo.isSystemRepo() ? _repo.alias() : _repo.info().escaped_alias() )
+               / "solv" );
+  std::string cookie( file_cookie( solv ) );
+  Pathname file( solv.dirname() / name_r );
+
+  if ( cookie != "-" )
+  {
+    _file.reset( new MappedFile( file.asString() ) );
+    if ( _file->valid() && isCurrent( _file->data(), _file->size(), cookie ) )
+    {
+      if ( attach( _file->data() + sizeof(Header), _file->size() - sizeof(Header) ) )
+      {
+        DBG << "Mapped " << file << endl;
+        return true;
+      }
+      // current but corrupt: don't trust anything derived from it
+      ERR << "Corrupt " << file << ", not using an index for " << _repo.alias() << endl;
+      _file.reset();
+      return false;
+    }
+    _file.reset();
+  }
+
+  // building one costs about a plain query, it pays only if it's stored
+  if ( cookie == "-" || cookie.size() >= sizeof(Header::_cookie) || ! PathInfo( file.dirname() ).userMayRWX() )
+  {
+    DBG << "No stored " << name_r << " for " << _repo.alias() << ", can't store one" << endl;	// e.g. not root
+    return false;
+  }
+
+  Header header;
+  ::memset( &header, 0, sizeof(header) );
+  ::memcpy( header._magic, _magic, sizeof(header._magic) );
+  header._solvables = _repo.solvablesSize();
+  ::memcpy( header._cookie, cookie.data(), cookie.size() );
+  _built.assign( reinterpret_cast<const char *>( &header ), sizeof(header) );
+  build( _built );
+  if ( ! attach( _built.data() + sizeof(header), _built.size() - sizeof(header) ) )
+  {
+    ERR << "Built an unusable " << name_r << " for " << _repo.alias() << endl;	// can't happen
+    return false;
+  }
+  // a private tmpfile, concurrent runs may store the same index
+  std::string tmpname( file.extend( ".XXXXXX" ).asString() );
+  int fd = ::mkstemp( &tmpname[0] );
+  if ( fd < 0 )
+  {
+    DBG << "Cannot store " << file << ": " << str::strerror( errno ) << endl;	// e.g. not root
+    return true;
+  }
+  ::fchmod( fd, 0644 );
+  ::close( fd );
+
+  Pathname tmpfile( tmpname );
+  {
+    std::ofstream str( tmpfile.c_str(), std::ios::binary );
+    str.write( _built.data(), _built.size() );
+    if ( ! str )
+    {
+      WAR << "Cannot store " << file << endl;
+      str.close();
+      filesystem::unlink( tmpfile );
+      return true;
+    }
+  }
+  if ( filesystem::rename( tmpfile, file ) != 0 )
+  {
+    WAR << "Cannot store " << file << endl;
+    filesystem::unlink( tmpfile );
+    return true;
+  }
+  MIL << "Stored " << file << endl;
+  return true;
+}
+
+bool RepoIndex::isCurrent( const char * data_r, std::size_t size_r, const std::string & cookie_r ) const
+{
+  if ( size_r < sizeof(Header) )
+    return false;
+  const Header * header = reinterpret_cast<const Header *>( data_r );
+  return ::memcmp( header->_magic, _magic, sizeof(header->_magic) ) == 0
+      && header->_solvables == _repo.solvablesSize()
+      && cookie_r.size() < sizeof(header->_cookie)
+      && cookie_r == std::string( header->_cookie, ::strnlen( header->_cookie, sizeof(header->_cookie) ) );
+}
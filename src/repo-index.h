@@ -0,0 +1,98 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/**
+ * Lookup indexes of a loaded repository, stored next to its solv file.
+ *
+ * An index file lives in <tt>[repoSolvCachePath]/[alias]/</tt> and is
+ * memory-mapped when used. Solvables are stored as offsets into the repo,
+ * which are the same whenever the same solv file is loaded; the cookie of
+ * the solv file in the header tells whether the index still belongs to
+ * it. The indexes are built when \c refresh builds the repo cache. An
+ * outdated or missing index is rebuilt from the loaded repo if the cache
+ * is writable; otherwise (e.g. for non-root users) there is no index and
+ * callers use a plain query instead of building one on every run.
+ *
+ * Common header (host byte order), followed by the index specific data:
+ * \code
+ * char     magic[8]
+ * uint32_t solvables		number of solvables in the repo
+ * char     cookie[100]		file_cookie() of the solv file, NUL padded
+ * \endcode
+ */
+#ifndef ZYPPER_REPO_INDEX_H
+#define ZYPPER_REPO_INDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <zypp/base/NonCopyable.h>
+#include <zypp/Repository.h>
+#include <zypp/sat/Solvable.h>
+
+#include "utils/mappedfile.h"
+
+class Zypper;
+
+///////////////////////////////////////////////////////////////////
+/// \class RepoIndex
+/// \brief Base of the stored per repo indexes (see \ref DepIndex and
+/// \ref FileIndex).
+///
+/// Derived classes build their data in \ref build and set up their
+/// lookup tables in \ref attach, both after the common header.
+///////////////////////////////////////////////////////////////////
+class RepoIndex : private zypp::base::NonCopyable
+{
+public:
+  virtual ~RepoIndex();
+
+protected:
+  /** \a magic_r are the 8 characters identifying the file format. */
+  RepoIndex( const zypp::Repository & repo_r, const char * magic_r );
+
+  /** Map the index file \a name_r or build and store it. \c false if the
+   * repo's solvables are not contiguous in the pool, so offsets don't work,
+   * if there is no current index file and it can't be stored, or if a
+   * current one fails \ref attach (callers then fall back to a plain query).
+   */
+  bool load( Zypper & zypper, const std::string & name_r );
+
+  /** Append the index data to \a data_r (after the header). */
+  virtual void build( std::string & data_r ) = 0;
+
+  /** Set up the lookup from \a data_r (after the header); \c false if
+   * its size doesn't match the table counts in it. Called on every load,
+   * so it does not scan the tables: offsets read from them are checked
+   * where they are looked up.
+   */
+  virtual bool attach( const char * data_r, std::size_t size_r ) = 0;
+
+  /** The solvable at \a offset_r in the repo. */
+  zypp::sat::Solvable solvable( uint32_t offset_r ) const
+  { return zypp::sat::Solvable( _first + offset_r ); }
+
+  /** Offset of \a solv_r in the repo. */
+  uint32_t offset( const zypp::sat::Solvable & solv_r ) const
+  { return solv_r.id() - _first; }
+
+  zypp::Repository _repo;
+
+private:
+  struct Header;
+
+  /** Whether the header in \a data_r matches this repo and \a cookie_r. */
+  bool isCurrent( const char * data_r, std::size_t size_r, const std::string & cookie_r ) const;
+
+  const char * _magic;
+  zypp::sat::detail::SolvableIdType _first;	//< id of the repo's first solvable
+  std::unique_ptr<MappedFile> _file;
+  std::string _built;				//< index built in this run
+};
+
+#endif // ZYPPER_REPO_INDEX_H
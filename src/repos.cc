@@ -25,12 +25,17 @@
 #include <zypp/media/MediaAccess.h>
 
 #include "output/Out.h"
+#include "output/OutJSON.h"
 #include "main.h"
 #include "getopt.h"
 #include "Table.h"
 #include "utils/messages.h"
 #include "utils/misc.h"
 #include "repos.h"
+#include "install-roots.h"
+#include "result-cache.h"
+#include "dep-index.h"
+#include "file-index.h"
 
 using namespace std;
 using namespace boost;
@@ -262,6 +267,19 @@ static bool refresh_raw_metadata(Zypper & zypper,
 
 // ---------------------------------------------------------------------------
 
+/** Store the dependency and file indexes of the loaded \a repo next to its
+ * solv file (see DepIndex, FileIndex), so searches only have to map them.
+ * Nothing is stored if the cache is not writable.
+ */
+static void build_repo_indexes(Zypper & zypper, const RepoInfo & repo)
+{
+  Repository loaded(sat::Pool::instance().reposFind(repo.alias()));
+  if (!loaded)
+    return;
+  DepIndex::forRepo(zypper, loaded);
+  FileIndex::forRepo(zypper, loaded);
+}
+
 static bool build_cache(Zypper & zypper, const RepoInfo & repo, bool force_build)
 {
   if (force_build)
@@ -284,6 +302,7 @@ static bool build_cache(Zypper & zypper, const RepoInfo & repo, bool force_build
          || zypper.command() == ZypperCommand::REFRESH_SERVICES))
     {
       manager.loadFromCache(repo);
+      build_repo_indexes(zypper, repo);
     }
   }
   catch (const parser::ParseException & e)
@@ -1108,6 +1127,27 @@ static void print_xml_repo_list(Zypper & zypper, list<RepoInfo> repos)
 
 // ----------------------------------------------------------------------------
 
+static void print_json_repo_list(Zypper & zypper, list<RepoInfo> repos)
+{
+  for (std::list<RepoInfo>::const_iterator it = repos.begin();
+       it !=  repos.end(); ++it)
+  {
+    jsonout::Record rec("repo");
+    rec("alias", it->alias())
+       ("name", it->name())
+       ("repo-type", it->type().asString())
+       ("priority", it->priority())
+       ("enabled", it->enabled())
+       ("autorefresh", it->autorefresh())
+       ("gpgcheck", it->gpgCheck())
+       ("keeppackages", it->keepPackages());
+    if (!it->baseUrlsEmpty())
+      rec("url", it->url().asString());
+  }
+}
+
+// ----------------------------------------------------------------------------
+
 void print_repos_to(const std::list<zypp::RepoInfo> &repos, ostream & out)
 {
   for (std::list<RepoInfo>::const_iterator it = repos.begin();
@@ -1186,6 +1226,8 @@ void list_repos(Zypper & zypper)
   // print repo list as xml
   else if (zypper.out().type() == Out::TYPE_XML)
     print_xml_repo_list(zypper, repos);
+  else if (zypper.out().typeJSON())
+    print_json_repo_list(zypper, repos);
   // print repo list the rug's way
   else if (zypper.globalOpts().is_rug_compatible)
     print_rug_sources_list(repos);
@@ -1508,6 +1550,9 @@ void clean_repos(Zypper & zypper)
   else
     enabled_repo_count = 0;
 
+  // listings computed from the old state
+  clear_result_cache(zypper);
+
   // clean the target system cache
   if( clean_metadata )
   {
@@ -3193,6 +3238,8 @@ void load_resolvables(Zypper & zypper)
   MIL << "Going to load resolvables" << endl;
 
   load_repo_resolvables(zypper);
+  // multi-root mode: the jobs go on from here, each with its own target
+  run_install_root_jobs(zypper);
   if (!zypper.globalOpts().disable_system_resolvables)
     load_target_resolvables(zypper);
 
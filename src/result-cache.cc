@@ -0,0 +1,503 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+#include <vector>
+#include <map>
+#include <list>
+#include <cerrno>
+#include <cstdlib>
+#include <clocale>
+#include <ctime>
+#include <algorithm>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#include <zypp/ZYpp.h>
+#include <zypp/ZConfig.h>
+#include <zypp/base/LogTools.h>
+#include <zypp/base/String.h>
+#include <zypp/Digest.h>
+#include <zypp/PathInfo.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/target/rpm/RpmDb.h>
+
+#include "Zypper.h"
+#include "main.h"
+#include "output/OutJSON.h"
+#include "utils/colors.h"
+#include "utils/console.h"
+#include "result-cache.h"
+
+extern ZYpp::Ptr God;
+
+///////////////////////////////////////////////////////////////////
+namespace
+{
+  typedef std::map<std::string,std::string> RepoCookies;
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class TeeBuf
+  /// \brief Streambuf passing the output on to another one and keeping
+  /// a copy of it.
+  ///////////////////////////////////////////////////////////////////
+  class TeeBuf : public std::streambuf
+  {
+  public:
+    TeeBuf( std::streambuf * next_r )
+      : _next( next_r )
+    {}
+
+    const std::string & data() const
+    { return _data; }
+
+  protected:
+    virtual int overflow( int ch )
+    {
+      if ( traits_type::eq_int_type( ch, traits_type::eof() ) )
+        return traits_type::not_eof( ch );
+      _data += traits_type::to_char_type( ch );
+      return _next->sputc( traits_type::to_char_type( ch ) );
+    }
+
+    virtual std::streamsize xsputn( const char * s, std::streamsize n )
+    {
+      _data.append( s, n );
+      return _next->sputn( s, n );
+    }
+
+    virtual int sync()
+    { return _next->pubsync(); }
+
+  private:
+    std::streambuf * _next;
+    std::string _data;
+  };
+
+  /** The command line as far as it changes the output, normalized. */
+  std::string commandKey( Zypper & zypper )
+  {
+    const GlobalOptions & gopts( zypper.globalOpts() );
+    std::ostringstream key;
+    key << zypper.command().asString();
+    for ( const auto & arg : zypper.arguments() )
+      key << " arg=" << arg;
+    for ( const auto & opt : zypper.cOpts() )	// parsed_opts is sorted by name
+    {
+      key << " --" << opt.first;
+      for ( const auto & val : opt.second )
+        key << '=' << val;
+    }
+
+    Out & out( zypper.out() );
+    key << " out=" << ( out.typeXML() ? "xml" : out.typeJSON() ? ( jsonout::ndjson() ? "ndjson" : "json" ) : "normal" );
+    key << " verbosity=" << gopts.verbosity;
+    key << " root=" << gopts.root_dir;
+    key << " flags=" << gopts.terse << gopts.no_abbrev << gopts.is_rug_compatible
+                     << gopts.disable_system_resolvables;
+    key << " colors=" << ( do_colors() && ::isatty( STDOUT_FILENO ) );
+    key << " width=" << get_screen_width();
+    const char * locale = ::setlocale( LC_MESSAGES, NULL );
+    key << " locale=" << ( locale ? locale : "" );
+    return key.str();
+  }
+
+  std::string sha1( const std::string & text_r )
+  {
+    Digest digest;
+    digest.create( Digest::sha1() );
+    digest.update( text_r.c_str(), text_r.size() );
+    return digest.digest();
+  }
+
+  Pathname locksFile( Zypper & zypper )
+  { return Pathname::assertprefix( zypper.globalOpts().root_dir, ZConfig::instance().locksFile() ); }
+
+  /** Cookie of directory \a dir_r and the files in it (edited in place
+   * files don't change the directory).
+   */
+  std::string dirCookie( const Pathname & dir_r )
+  {
+    std::string ret( file_cookie( dir_r ) );
+    std::list<std::string> entries;
+    if ( filesystem::readdir( entries, dir_r, /*dots*/false ) == 0 )
+    {
+      entries.sort();
+      for ( const auto & entry : entries )
+	ret += ' ' + entry + '=' + file_cookie( dir_r / entry );
+    }
+    return ret;
+  }
+
+  /** Cookie of the configuration the output depends on: zypp.conf,
+   * vendors.d, zypper.conf and the repo and service definitions (priority,
+   * enabled state, ...).
+   */
+  std::string configCookie( Zypper & zypper )
+  {
+    const RepoManagerOptions & rmopts( zypper.globalOpts().rm_options );
+    const char * zyppconf = ::getenv( "ZYPP_CONF" );
+    const char * home = ::getenv( "HOME" );
+    std::ostringstream str;
+    str << file_cookie( zyppconf ? zyppconf : "/etc/zypp/zypp.conf" )
+        << ' ' << dirCookie( ZConfig::instance().vendorPath() )
+        << ' ' << file_cookie( "/etc/zypp/zypper.conf" )
+        << ' ' << ( home ? file_cookie( Pathname( home ) / ".zypper.conf" ) : "-" )
+        << ' ' << dirCookie( rmopts.knownReposPath )
+        << ' ' << dirCookie( rmopts.knownServicesPath );
+    return sha1( str.str() );
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class Entry
+  /// \brief A cache file.
+  ///////////////////////////////////////////////////////////////////
+  struct Entry
+  {
+    Entry()
+      : _exit( 0 ), _records( 0 )
+    {}
+
+    /** Parse \a file_r; \c false if it is not readable or malformed. */
+    bool read( const Pathname & file_r )
+    {
+      std::ifstream str( file_r.c_str() );
+      if ( ! str )
+	return false;
+
+      std::string line;
+      while ( std::getline( str, line ) )
+      {
+	std::istringstream words( line );
+	std::string tag;
+	words >> tag;
+	bool ok = false;
+	if ( tag == "key" )
+	  ok = bool( std::getline( words >> std::ws, _key ) );
+	else if ( tag == "rpmdb" )
+	  ok = bool( words >> _rpmdb );
+	else if ( tag == "locks" )
+	  ok = bool( words >> _locks );
+	else if ( tag == "config" )
+	  ok = bool( words >> _config );
+	else if ( tag == "repo" )
+	{
+	  std::string alias;
+	  std::string cookie;
+	  if ( ( ok = bool( words >> alias >> cookie ) ) )
+	    _repos[alias] = cookie;
+	}
+	else if ( tag == "exit" )
+	  ok = bool( words >> _exit );
+	else if ( tag == "records" )
+	  ok = bool( words >> _records );
+	else if ( tag == "errors" )
+	{
+	  std::string::size_type size;
+	  if ( ( ok = bool( words >> size ) ) )
+	  {
+	    _errors.resize( size );
+	    ok = size == 0 || str.read( &_errors[0], size );
+	    str.ignore( 1 );	// the newline after the text
+	  }
+	}
+	else if ( tag == "output" )
+	{
+	  std::string::size_type size;
+	  if ( ! ( words >> size ) )
+	    break;
+	  _output.resize( size );
+	  return str.read( &_output[0], size ) && ! _key.empty();
+	}
+	if ( ! ok )
+	  break;
+      }
+      ERR << file_r << ": malformed line '" << line << "'" << endl;
+      return false;
+    }
+
+    bool write( const Pathname & file_r ) const
+    {
+      std::ofstream str( file_r.c_str() );
+      str << "key " << _key << endl;
+      str << "rpmdb " << _rpmdb << endl;
+      str << "locks " << _locks << endl;
+      str << "config " << _config << endl;
+      for ( const auto & repo : _repos )
+	str << "repo " << repo.first << ' ' << repo.second << endl;
+      str << "exit " << _exit << endl;
+      str << "records " << _records << endl;
+      str << "errors " << _errors.size() << endl;
+      str << _errors << endl;
+      str << "output " << _output.size() << endl;
+      str << _output;
+      return bool( str );
+    }
+
+    std::string _key;
+    std::string _rpmdb;
+    std::string _locks;
+    std::string _config;
+    RepoCookies _repos;
+    int _exit;
+    unsigned _records;	//< JSON records in _output
+    std::string _errors;	//< written to stderr
+    std::string _output;
+  };
+
+  /** Entries not used for that long are removed. */
+  const time_t maxEntryAge = 7 * 24 * 60 * 60;
+  /** At most that many entries are kept, the least recently used go first. */
+  const unsigned maxEntries = 64;
+
+  /** Enforce \ref maxEntryAge and \ref maxEntries in \a dir_r. An entry's
+   * mtime is its last use (replay touches it).
+   */
+  void pruneEntries( const Pathname & dir_r )
+  {
+    std::list<std::string> names;
+    if ( filesystem::readdir( names, dir_r, /*dots*/false ) != 0 )
+      return;
+
+    time_t now = ::time( nullptr );
+    std::vector<std::pair<time_t,Pathname> > entries;	// mtime, file
+    for ( const auto & name : names )
+    {
+      PathInfo pi( dir_r / name );
+      if ( ! pi.isFile() )
+	continue;
+      if ( now - pi.mtime() > maxEntryAge )
+	filesystem::unlink( pi.path() );
+      else
+	entries.push_back( std::make_pair( pi.mtime(), pi.path() ) );
+    }
+    if ( entries.size() <= maxEntries )
+      return;
+
+    std::sort( entries.begin(), entries.end() );
+    for ( unsigned idx = 0; idx < entries.size() - maxEntries; ++idx )
+      filesystem::unlink( entries[idx].second );
+    MIL << "Pruned " << entries.size() - maxEntries << " cached results in " << dir_r << endl;
+  }
+
+} // namespace
+///////////////////////////////////////////////////////////////////
+
+std::string file_cookie( const Pathname & file_r )
+{
+  // PathInfo offers whole seconds only; a file rewritten within the same
+  // second (and size) must still get a new cookie.
+  struct stat st;
+  if ( ::stat( file_r.c_str(), &st ) != 0 )
+    return "-";
+  return str::form( "%llu-%lld.%09ld-%lld.%09ld-%llu",
+                    (unsigned long long)st.st_ino,
+                    (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec,
+                    (long long)st.st_ctim.tv_sec, (long)st.st_ctim.tv_nsec,
+                    (unsigned long long)st.st_size );
+}
+
+std::string rpmdb_cookie( Zypper & zypper )
+{
+  return file_cookie( Pathname::assertprefix( zypper.globalOpts().root_dir,
+                                              God->target()->rpmDb().dbPath() / "Packages" ) );
+}
+
+std::string repo_cookie( Zypper & zypper, const RepoInfo & repo_r )
+{
+  std::string cookie( zypper.repoManager().metadataStatus( repo_r ).checksum() );
+  return cookie.empty() ? "-" : cookie;
+}
+
+///////////////////////////////////////////////////////////////////
+/// \class ResultCache::Impl
+///////////////////////////////////////////////////////////////////
+class ResultCache::Impl : private base::NonCopyable
+{
+public:
+  Impl( Zypper & zypper )
+    : _zypper( zypper )
+    , _missed( false )
+    , _cout( nullptr )
+    , _cerr( nullptr )
+    , _records( 0 )
+  {
+    _entry._key = commandKey( zypper );
+    _entry._rpmdb = rpmdb_cookie( zypper );
+    _entry._locks = file_cookie( locksFile( zypper ) );
+    _entry._config = configCookie( zypper );
+    _file = zypper.globalOpts().rm_options.repoCachePath / "results" / sha1( _entry._key );
+  }
+
+  ~Impl()
+  { stopCapture(); }
+
+  bool replay()
+  {
+    // the shell keeps the pool loaded, so there is nothing to gain
+    if ( _zypper.runningShell() )
+      return false;
+
+    Entry cached;
+    if ( ! cached.read( _file ) )
+    {
+      _missed = true;
+      return false;
+    }
+
+    RepoCookies repos;
+    const std::list<RepoInfo> & infos( _zypper.runtimeData().repos );
+    for_( it, infos.begin(), infos.end() )
+    {
+      if ( it->enabled() )
+	repos[it->alias()] = repo_cookie( _zypper, *it );
+    }
+
+    if ( cached._key != _entry._key || cached._rpmdb != _entry._rpmdb
+      || cached._locks != _entry._locks || cached._config != _entry._config
+      || cached._repos != repos )
+    {
+      MIL << "Cached result outdated: " << _file << endl;
+      _missed = true;
+      return false;
+    }
+
+    MIL << "Replaying cached result " << _file << endl;
+    ::utime( _file.c_str(), nullptr );	// used now, see pruneEntries
+    cerr << cached._errors << std::flush;
+    if ( _zypper.out().typeJSON() )
+      jsonout::writeRecords( cached._output, cached._records );
+    else
+      cout << cached._output;
+    cout << std::flush;
+    _zypper.setExitCode( cached._exit );
+    return true;
+  }
+
+  void capture()
+  {
+    if ( ! _missed || _cout )
+      return;
+    cout << std::flush;
+    cerr << std::flush;
+    _cout = cout.rdbuf();
+    _tee.reset( new TeeBuf( _cout ) );
+    cout.rdbuf( _tee.get() );
+    _cerr = cerr.rdbuf();
+    _errtee.reset( new TeeBuf( _cerr ) );
+    cerr.rdbuf( _errtee.get() );
+    _records = jsonout::recordCount();
+  }
+
+  void store()
+  {
+    if ( ! _cout )
+      return;
+    cout << std::flush;
+    cerr << std::flush;
+    std::string output( _tee->data() );
+    std::string errors( _errtee->data() );
+    unsigned records = jsonout::recordCount() - _records;
+    stopCapture();
+
+    int exit = _zypper.exitCode();
+    if ( exit != ZYPPER_EXIT_OK
+      && ( exit < ZYPPER_EXIT_INF_UPDATE_NEEDED || exit > ZYPPER_EXIT_INF_CAP_NOT_FOUND ) )
+      return;
+
+    Entry entry( _entry );
+    entry._exit = exit;
+    entry._records = _zypper.out().typeJSON() ? records : 0;
+    entry._errors.swap( errors );
+    entry._output.swap( output );
+    for_( it, sat::Pool::instance().reposBegin(), sat::Pool::instance().reposEnd() )
+    {
+      if ( ! it->isSystemRepo() )
+	entry._repos[it->alias()] = repo_cookie( _zypper, it->info() );
+    }
+
+    // concurrent zyppers must not write to the same temp file
+    if ( filesystem::assert_dir( _file.dirname() ) != 0 )
+    {
+      WAR << "Cannot store result in " << _file << endl;
+      return;
+    }
+    std::string tmpname( _file.extend( ".XXXXXX" ).asString() );
+    int fd = ::mkstemp( &tmpname[0] );
+    if ( fd < 0 )
+    {
+      WAR << "Cannot store result in " << _file << ": " << str::strerror( errno ) << endl;
+      return;
+    }
+    ::fchmod( fd, 0644 );
+    ::close( fd );
+
+    Pathname tmpfile( tmpname );
+    if ( ! entry.write( tmpfile ) || filesystem::rename( tmpfile, _file ) != 0 )
+    {
+      WAR << "Cannot store result in " << _file << endl;
+      filesystem::unlink( tmpfile );
+      return;
+    }
+    MIL << "Stored result in " << _file << endl;
+    pruneEntries( _file.dirname() );
+  }
+
+private:
+  void stopCapture()
+  {
+    if ( ! _cout )
+      return;
+    cout << std::flush;
+    cerr << std::flush;
+    cout.rdbuf( _cout );
+    cerr.rdbuf( _cerr );
+    _cout = _cerr = nullptr;
+    _tee.reset();
+    _errtee.reset();
+  }
+
+private:
+  Zypper & _zypper;
+  Pathname _file;
+  Entry _entry;			//< cookies taken on construction
+  bool _missed;			//< replay found no usable entry
+  std::streambuf * _cout;	//< original cout buffer while capturing
+  std::streambuf * _cerr;	//< original cerr buffer while capturing
+  std::unique_ptr<TeeBuf> _tee;
+  std::unique_ptr<TeeBuf> _errtee;
+  unsigned _records;		//< JSON records written before capturing
+};
+
+///////////////////////////////////////////////////////////////////
+
+ResultCache::ResultCache( Zypper & zypper )
+  : _pimpl( new Impl( zypper ) )
+{}
+
+ResultCache::~ResultCache()
+{}
+
+bool ResultCache::replay()
+{ return _pimpl->replay(); }
+
+void ResultCache::capture()
+{ _pimpl->capture(); }
+
+void ResultCache::store()
+{ _pimpl->store(); }
+
+void clear_result_cache( Zypper & zypper )
+{
+  Pathname dir( zypper.globalOpts().rm_options.repoCachePath / "results" );
+  if ( PathInfo( dir ).isExist() && filesystem::recursive_rmdir( dir ) != 0 )
+    WAR << "Cannot remove " << dir << endl;
+}
@@ -0,0 +1,113 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/**
+ * Result cache for read-only listing commands (list-updates, list-patches,
+ * search).
+ *
+ * The result such a command writes to stdout and stderr (not the progress
+ * of loading the pool) is stored in <tt>[repoCachePath]/results</tt>, one
+ * file per command line (command, options, arguments and the global options
+ * which change the output). Along with it the exit code and the cookies of the
+ * rpmdb, the repositories, the locks file and the configuration (zypp.conf,
+ * vendors.d, zypper.conf, repos.d and services.d) are stored. As long as the
+ * cookies match, a later run replays the output instead of loading the
+ * pool and computing the result. Entries unused for a week are removed, and
+ * at most 64 are kept; \c zypper \c clean removes all of them.
+ *
+ * File format: header lines, then the output:
+ * \code
+ * key <command line>
+ * rpmdb <cookie>
+ * locks <cookie>
+ * config <cookie>
+ * repo <alias> <cookie>
+ * exit <code>
+ * records <number of JSON records>
+ * errors <size>
+ * <stderr output>
+ * output <size>
+ * <output>
+ * \endcode
+ */
+#ifndef ZYPPER_RESULT_CACHE_H
+#define ZYPPER_RESULT_CACHE_H
+
+#include <memory>
+#include <string>
+
+#include <zypp/base/NonCopyable.h>
+#include <zypp/Pathname.h>
+#include <zypp/RepoInfo.h>
+
+class Zypper;
+
+/** Cookie of a file: inode, times (in ns) and size (\c "-" if it does not exist). */
+std::string file_cookie( const zypp::Pathname & file_r );
+
+/** Cookie of the installed system, taken from the target's rpmdb file (so
+ * it can be checked without reading the installed packages). Needs the
+ * target initialized.
+ */
+std::string rpmdb_cookie( Zypper & zypper );
+
+/** The raw metadata checksum as cookie of \a repo_r (\c "-" if unknown). */
+std::string repo_cookie( Zypper & zypper, const zypp::RepoInfo & repo_r );
+
+///////////////////////////////////////////////////////////////////
+/// \class ResultCache
+/// \brief Replays or captures the output of the current command.
+/// \code
+///   init_repos( zypper );
+///   ResultCache cache( zypper );
+///   if ( cache.replay() )
+///     return;
+///   load_resolvables( zypper );
+///   cache.capture();
+///   ...
+///   cache.store();
+/// \endcode
+/// Capturing ends when the object is destroyed. Nothing is stored unless
+/// \ref store is called, so returning early on errors is fine.
+///////////////////////////////////////////////////////////////////
+class ResultCache : private zypp::base::NonCopyable
+{
+public:
+  /** To be created after the repos were initialized and before the pool
+   * is loaded. The rpmdb cookie is taken here, so a commit running meanwhile
+   * can't get a wrong result stored.
+   */
+  explicit ResultCache( Zypper & zypper );
+
+  ~ResultCache();
+
+  /** Write the cached output and set the exit code if the entry matches
+   * the enabled repos in \ref RuntimeData::repos.
+   * \returns whether the output was replayed.
+   */
+  bool replay();
+
+  /** If \ref replay found no usable entry, start capturing stdout and
+   * stderr. Call it once the pool is loaded, right before the result is
+   * written.
+   */
+  void capture();
+
+  /** Store the captured output for the repos loaded into the pool, unless
+   * the command failed. Failure to store is just logged.
+   */
+  void store();
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> _pimpl;
+};
+
+/** Remove all stored results (\c zypper \c clean). */
+void clear_result_cache( Zypper & zypper );
+
+#endif // ZYPPER_RESULT_CACHE_H
@@ -1,4 +1,12 @@
 #include <iostream>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include <zypp/ZYpp.h> // for zypp::ResPool::instance()
 
@@ -8,6 +16,7 @@
 #include <zypp/Pattern.h>
 #include <zypp/Product.h>
 #include <zypp/sat/Solvable.h>
+#include <zypp/sat/Pool.h>
 
 #include <zypp/PoolItem.h>
 #include <zypp/PoolQuery.h>
@@ -16,6 +25,9 @@
 
 #include "main.h"
 #include "utils/misc.h" // for kind_to_string_localized and string_patch_status
+#include "output/OutJSON.h"
+#include "dep-index.h"
+#include "file-index.h"
 
 #include "search.h"
 
@@ -24,9 +36,109 @@ using namespace std;
 
 extern ZYpp::Ptr God;
 
+///////////////////////////////////////////////////////////////////
+// SearchResultWriter
+///////////////////////////////////////////////////////////////////
+
+SearchResultWriter::SearchResultWriter( Out & out_r, const SolvableFormat * format_r )
+  : _json( out_r.typeJSON() )
+  , _format( format_r )
+  , _count( 0 )
+  , _closed( false )
+{
+  if ( _json || _format )
+    return;
+  cout << "<search-result version=\"0.0\">" << '\n';
+  cout << "<solvable-list>" << '\n';
+}
+
+SearchResultWriter::~SearchResultWriter()
+{ close(); }
+
+void SearchResultWriter::close()
+{
+  if ( _closed )
+    return;
+  if ( ! _json && ! _format )
+  {
+    cout << "</solvable-list>" << '\n';
+    cout << "</search-result>" << '\n';
+  }
+  _closed = true;
+}
+
+const char * SearchResultWriter::statusString( const char * status_r )
+{
+  if ( status_r[0] == 'i' )
+    return "installed";
+  if ( status_r[0] == 'v' )
+    return "other-version";
+  return "not-installed";
+}
+
+void SearchResultWriter::solvable( const char * status_r, const PoolItem & pi_r )
+{
+  ++_count;
+  const std::string & repository( pi_r->isSystem()
+                                  ? string("(") + _("System Packages") + ")"
+                                  : pi_r->repository().asUserString() );
+  if ( _format )
+  {
+    _format->print( cout, pi_r, status_r );
+    return;
+  }
+  if ( _json )
+  {
+    jsonout::Record( "solvable" )
+      ( "status", statusString( status_r ) )
+      ( "name", pi_r->name() )
+      ( "kind", pi_r->kind().asString() )
+      ( "edition", pi_r->edition().asString() )
+      ( "arch", pi_r->arch().asString() )
+      ( "repository", repository );
+    return;
+  }
+
+  cout << "<solvable status=\"" << statusString( status_r ) << "\" name=\"";
+  out::writeXmlEscaped( cout, pi_r->name() );
+  cout << "\" kind=\"" << pi_r->kind() << "\" edition=\"";
+  out::writeXmlEscaped( cout, pi_r->edition().asString() );
+  cout << "\" arch=\"" << pi_r->arch() << "\" repository=\"";
+  out::writeXmlEscaped( cout, repository );
+  cout << "\"/>" << '\n';
+}
+
+void SearchResultWriter::selectable( const char * status_r, const ui::Selectable::constPtr & sel_r )
+{
+  ++_count;
+  if ( _format )
+  {
+    _format->print( cout, sel_r->theObj(), status_r );
+    return;
+  }
+  if ( _json )
+  {
+    jsonout::Record( "solvable" )
+      ( "status", statusString( status_r ) )
+      ( "name", sel_r->name() )
+      ( "summary", sel_r->theObj()->summary() )
+      ( "kind", sel_r->kind().asString() );
+    return;
+  }
+
+  cout << "<solvable status=\"" << statusString( status_r ) << "\" name=\"";
+  out::writeXmlEscaped( cout, sel_r->name() );
+  cout << "\" summary=\"";
+  out::writeXmlEscaped( cout, sel_r->theObj()->summary() );
+  cout << "\" kind=\"" << sel_r->kind() << "\"/>" << '\n';
+}
+
+///////////////////////////////////////////////////////////////////
+
 FillSearchTableSolvable::FillSearchTableSolvable(
-    Table & table, zypp::TriBool inst_notinst)
+    Table & table, zypp::TriBool inst_notinst, SearchResultWriter * writer)
   : _table( &table )
+  , _writer( writer )
   , _gopts(Zypper::instance()->globalOpts())
   , _inst_notinst(inst_notinst)
 {
@@ -38,6 +150,9 @@ FillSearchTableSolvable::FillSearchTableSolvable(
       _repos.insert(it->alias());
   }
 
+  if (_writer)
+    return;	// streamed, no table
+
   TableHeader header;
 
   //
@@ -90,17 +205,17 @@ bool FillSearchTableSolvable::addPicklistItem( const ui::Selectable::constPtr &
   if ( pi->isKind<Pattern>() && ! pi->asKind<Pattern>()->userVisible() )
     return false;
 
-  TableRow row;
   // compute status indicator:
   //   i  - exactly this version installed
   //   v  - installed, but in different version
   //      - not installed at all
+  const char * status = "";
   if ( pi->isSystem() )
   {
     // picklist: ==> not available
     if ( _inst_notinst == false )
       return false;	// show only not installed
-    row << "i";
+    status = "i";
   }
   else
   {
@@ -111,7 +226,6 @@ bool FillSearchTableSolvable::addPicklistItem( const ui::Selectable::constPtr &
     {
       if ( _inst_notinst == true )
 	return false;	// show only installed
-      row << "";
     }
     else
     {
@@ -122,17 +236,26 @@ bool FillSearchTableSolvable::addPicklistItem( const ui::Selectable::constPtr &
       {
 	if ( _inst_notinst == false )
 	  return false;	// show only not installed
-	row << "i";
+	status = "i";
       }
       else
       {
 	if ( _inst_notinst == true )
 	  return false;	// show only installed
-	row << "v";
+	status = "v";
       }
     }
   }
 
+  if ( _writer )
+  {
+    _writer->solvable( status, pi );
+    return true;
+  }
+
+  TableRow row;
+  row << status;
+
   if ( _gopts.is_rug_compatible )
   {
     row
@@ -169,6 +292,9 @@ bool FillSearchTableSolvable::operator()( const zypp::PoolQuery::const_iterator
   if ( ! operator()(*it) )
     return false;	// no row was added due to filter
 
+  if ( _writer )
+    return true;	// no details in XML
+
   // after addPicklistItem( const ui::Selectable::constPtr & sel, const PoolItem & pi ) is
   // done, add the details about matches to last row
   TableRow & lastRow = _table->rows().back();
@@ -229,8 +355,9 @@ bool FillSearchTableSolvable::operator()( const zypp::ui::Selectable::constPtr &
 
 
 FillSearchTableSelectable::FillSearchTableSelectable(
-    Table & table, zypp::TriBool installed_only)
+    Table & table, zypp::TriBool installed_only, SearchResultWriter * writer)
   : _table( &table )
+  , _writer( writer )
   , _gopts(Zypper::instance()->globalOpts())
   , inst_notinst(installed_only)
 {
@@ -242,6 +369,9 @@ FillSearchTableSelectable::FillSearchTableSelectable(
       _repos.insert(it->alias());
   }
 
+  if (_writer)
+    return;	// streamed, no table
+
   TableHeader header;
   //
   // *** CAUTION: It's a mess, but adding/changing colums here requires
@@ -266,8 +396,6 @@ bool FillSearchTableSelectable::operator()(const zypp::ui::Selectable::constPtr
       return true;
   }
 
-  TableRow row;
-
   // whether to show the solvable as 'installed'
   bool installed = false;
 
@@ -291,6 +419,7 @@ bool FillSearchTableSelectable::operator()(const zypp::ui::Selectable::constPtr
     installed = !s->installedEmpty();
 
 
+  const char * status = "";
   if (s->kind() != zypp::ResKind::srcpackage)
   {
     if (installed)
@@ -298,7 +427,7 @@ bool FillSearchTableSelectable::operator()(const zypp::ui::Selectable::constPtr
       // not-installed only
       if (inst_notinst == false)
         return true;
-      row << "i";
+      status = "i";
     }
     // this happens if the solvable has installed objects, but no counterpart
     // of them in specified repos
@@ -307,14 +436,13 @@ bool FillSearchTableSelectable::operator()(const zypp::ui::Selectable::constPtr
       // not-installed only
       if (inst_notinst == true)
         return true;
-      row << "v";
+      status = "v";
     }
     else
     {
       // installed only
       if (inst_notinst == true)
         return true;
-      row << "";
     }
   }
   else
@@ -322,9 +450,16 @@ bool FillSearchTableSelectable::operator()(const zypp::ui::Selectable::constPtr
     // installed only
     if (inst_notinst == true)
       return true;
-    row << "";
   }
 
+  if (_writer)
+  {
+    _writer->selectable(status, s);
+    return true;
+  }
+
+  TableRow row;
+  row << status;
   row << s->name();
   row << s->theObj()->summary();
   row << kind_to_string_localized(s->kind(), 1);
@@ -350,28 +485,37 @@ FillPatchesTable::FillPatchesTable( Table & table, zypp::TriBool inst_notinst )
   *_table << header;
 }
 
-bool FillPatchesTable::operator()(const zypp::PoolItem & pi) const
+bool FillPatchesTable::wanted(const zypp::PoolItem & pi) const
 {
   // only not installed
   if (pi.isSatisfied() && _inst_notinst == false)
-    return true;
+    return false;
   // only installed
   else if (!pi.isSatisfied() && _inst_notinst == true)
-    return true;
+    return false;
+  return true;
+}
 
-  TableRow row;
+TableRow FillPatchesTable::row(const zypp::PoolItem & pi, const std::string & repo) const
+{
+  TableRow row( 5 );
 
   zypp::Patch::constPtr patch = zypp::asKind<zypp::Patch>(pi.resolvable());
 
   row
-    << pi->repository().asUserString()
+    << repo
     << pi->name()
     << patch->category()
     << patch->severity()
     << string_patch_status(pi);
 
-  *_table << row;
+  return row;
+}
 
+bool FillPatchesTable::operator()(const zypp::PoolItem & pi) const
+{
+  if (wanted(pi))
+    *_table << row(pi, pi->repository().asUserString());
   return true;
 }
 
@@ -397,6 +541,310 @@ string selectable_search_repo_str(const ui::Selectable & s)
 }
 */
 
+namespace
+{
+  /** Write all of \a size_r bytes to \a fd_r. */
+  bool writeAll( int fd_r, const char * data_r, size_t size_r )
+  {
+    while ( size_r )
+    {
+      ssize_t ret = ::write( fd_r, data_r, size_r );
+      if ( ret < 0 )
+      {
+	if ( errno == EINTR )
+	  continue;
+	return false;
+      }
+      data_r += ret;
+      size_r -= ret;
+    }
+    return true;
+  }
+
+  /** A forked query job and the ids it sent so far. */
+  struct QueryJob
+  {
+    pid_t _pid;
+    int _fd;
+    std::string _data;
+  };
+
+  /** In the job: evaluate the query on \a repos_r and send the ids, then exit. */
+  void runQueryJob( const PoolQuery & query_r, const std::vector<Repository> & repos_r, int fd_r )
+  {
+    int ret = 0;
+    try
+    {
+      PoolQuery query( query_r );	// this is a forked copy anyway
+      for ( const auto & repo : repos_r )
+	query.addRepo( repo.alias() );
+
+      std::vector<sat::detail::SolvableIdType> ids;
+      ids.reserve( 1024 );
+      for_( it, query.begin(), query.end() )
+      {
+	ids.push_back( it->id() );
+	if ( ids.size() == ids.capacity() )
+	{
+	  if ( ! writeAll( fd_r, (const char *)ids.data(), ids.size() * sizeof(ids[0]) ) )
+	    ::_exit( 1 );
+	  ids.clear();
+	}
+      }
+      if ( ! writeAll( fd_r, (const char *)ids.data(), ids.size() * sizeof(ids[0]) ) )
+	ret = 1;
+    }
+    catch ( const Exception & e )
+    {
+      ZYPP_CAUGHT( e );
+      ret = 1;
+    }
+    catch ( ... )
+    {
+      ret = 1;
+    }
+    ::close( fd_r );
+    ::_exit( ret );	// no cleanup, that's the parents business
+  }
+} // namespace
+
+bool evaluate_query_parallel( const PoolQuery & query_r,
+                              const std::set<std::string> & repos_r,
+                              std::vector<sat::Solvable> & matches_r )
+{
+  // the repos to search, in pool order, i.e. the order the query visits them
+  std::vector<Repository> repos;
+  size_t solvables = 0;
+  for_( it, sat::Pool::instance().reposBegin(), sat::Pool::instance().reposEnd() )
+  {
+    if ( ! repos_r.empty() && repos_r.find( it->alias() ) == repos_r.end() )
+      continue;
+    repos.push_back( *it );
+    solvables += it->solvablesSize();
+  }
+
+  long cpus = ::sysconf( _SC_NPROCESSORS_ONLN );
+  size_t jobs = std::min<size_t>( std::min<size_t>( cpus > 0 ? cpus : 1, 8 ), repos.size() );
+  if ( jobs < 2 || solvables < 4096 )
+    return false;
+
+  // contiguous repo ranges of about the same number of solvables
+  std::vector<std::vector<Repository>> parts( 1 );
+  size_t partSize = 0;
+  for ( const auto & repo : repos )
+  {
+    if ( partSize >= solvables / jobs && parts.size() < jobs )
+    {
+      parts.push_back( std::vector<Repository>() );
+      partSize = 0;
+    }
+    parts.back().push_back( repo );
+    partSize += repo.solvablesSize();
+  }
+  MIL << "Evaluating query in " << parts.size() << " jobs over " << repos.size() << " repos" << endl;
+
+  std::vector<QueryJob> running;
+  bool ok = true;
+  for ( const auto & part : parts )
+  {
+    int fds[2];
+    if ( ::pipe( fds ) == -1 )
+    {
+      ERR << "pipe: " << strerror(errno) << endl;
+      ok = false;
+      break;
+    }
+    pid_t pid = ::fork();
+    if ( pid == 0 )
+    {
+      ::close( fds[0] );
+      for ( const auto & job : running )
+	::close( job._fd );
+      runQueryJob( query_r, part, fds[1] );	// does not return
+    }
+    ::close( fds[1] );
+    if ( pid == -1 )
+    {
+      ERR << "fork: " << strerror(errno) << endl;
+      ::close( fds[0] );
+      ok = false;
+      break;
+    }
+    running.push_back( QueryJob{ pid, fds[0], std::string() } );
+  }
+
+  // collect the ids from all jobs at once, so no job blocks on a full pipe
+  std::vector<struct pollfd> pfds;
+  for ( const auto & job : running )
+    pfds.push_back( { job._fd, POLLIN, 0 } );
+  size_t open = pfds.size();
+  char buf[16384];
+  while ( open )
+  {
+    if ( ::poll( pfds.data(), pfds.size(), -1 ) == -1 )
+    {
+      if ( errno == EINTR )
+	continue;
+      ERR << "poll: " << strerror(errno) << endl;
+      ok = false;
+      break;
+    }
+    for ( size_t i = 0; i < pfds.size(); ++i )
+    {
+      if ( pfds[i].fd < 0 || ! pfds[i].revents )
+	continue;
+      ssize_t got = ::read( pfds[i].fd, buf, sizeof(buf) );
+      if ( got > 0 )
+	running[i]._data.append( buf, got );
+      else if ( got == 0 || errno != EINTR )
+      {
+	::close( pfds[i].fd );
+	pfds[i].fd = -1;	// poll ignores it
+	--open;
+      }
+    }
+  }
+  for ( size_t i = 0; i < pfds.size(); ++i )
+  {
+    if ( pfds[i].fd >= 0 )
+      ::close( pfds[i].fd );
+  }
+
+  for ( const auto & job : running )
+  {
+    int status = 0;
+    while ( ::waitpid( job._pid, &status, 0 ) == -1 && errno == EINTR )
+    {}
+    if ( ! WIFEXITED( status ) || WEXITSTATUS( status ) != 0 )
+    {
+      WAR << "Query job " << job._pid << " failed (" << status << ")" << endl;
+      ok = false;
+    }
+  }
+  if ( ! ok )
+    return false;
+
+  matches_r.clear();
+  for ( const auto & job : running )
+  {
+    sat::detail::SolvableIdType id;
+    for ( size_t pos = 0; pos + sizeof(id) <= job._data.size(); pos += sizeof(id) )
+    {
+      ::memcpy( &id, job._data.data() + pos, sizeof(id) );
+      matches_r.push_back( sat::Solvable( id ) );
+    }
+  }
+  MIL << "Query jobs found " << matches_r.size() << " matches" << endl;
+  return true;
+}
+
+namespace
+{
+  /** Whether \a solv_r has a dependency \a dep_r matching \a spec_r the way
+   * an exact match PoolQuery::addDependency does: same name and, if both
+   * are versioned, overlapping edition ranges.
+   */
+  bool depMatches( sat::Solvable solv_r, const Dep & dep_r, const CapDetail & spec_r, bool caseSensitive_r )
+  {
+    if ( ! spec_r.arch().empty() && solv_r.arch() != Arch( spec_r.arch() ) )
+      return false;
+    for ( const Capability & cap : solv_r.dep( dep_r ) )
+    {
+      CapDetail detail( cap.detail() );
+      if ( ! detail.isSimple() )
+        continue;
+      if ( caseSensitive_r ? detail.name() != spec_r.name()
+                           : str::compareCI( detail.name().c_str(), spec_r.name().c_str() ) != 0 )
+        continue;
+      if ( ! spec_r.isVersioned() || ! detail.isVersioned()
+        || overlaps( Edition::MatchRange( detail.op(), detail.ed() ), Edition::MatchRange( spec_r.op(), spec_r.ed() ) ) )
+        return true;
+    }
+    return false;
+  }
+} // namespace
+
+bool evaluate_query_indexed( Zypper & zypper,
+                             const PoolQuery & query_r,
+                             const std::vector<Capability> & specs_r,
+                             const std::vector<Dep> & deps_r,
+                             const std::vector<std::string> & files_r,
+                             const std::set<std::string> & repos_r,
+                             std::vector<sat::Solvable> & matches_r )
+{
+  unsigned mask = 0;
+  for ( const Dep & dep : deps_r )
+    mask |= DepIndex::bit( dep );
+  bool uninstalledOnly = query_r.statusFilterFlags() == PoolQuery::UNINSTALLED_ONLY;
+
+  std::vector<sat::Solvable> candidates;	// to be checked
+  std::vector<sat::Solvable> files;	// file index hits are exact
+  for_( it, sat::Pool::instance().reposBegin(), sat::Pool::instance().reposEnd() )
+  {
+    if ( ! repos_r.empty() && repos_r.find( it->alias() ) == repos_r.end() )
+      continue;
+    if ( uninstalledOnly && it->isSystemRepo() )
+      continue;
+    if ( ! deps_r.empty() )
+    {
+      std::unique_ptr<DepIndex> index( DepIndex::forRepo( zypper, *it ) );
+      if ( ! index )
+        return false;
+      for ( const auto & spec : specs_r )
+        index->lookup( spec.detail().name().asString(), mask, candidates );
+    }
+    if ( ! files_r.empty() )
+    {
+      std::unique_ptr<FileIndex> index( FileIndex::forRepo( zypper, *it ) );
+      if ( ! index )
+        return false;
+      for ( const auto & path : files_r )
+        index->lookup( path, query_r.caseSensitive(), files );
+    }
+  }
+  std::sort( candidates.begin(), candidates.end() );
+  candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+  std::sort( files.begin(), files.end() );
+  files.erase( std::unique( files.begin(), files.end() ), files.end() );
+
+  matches_r.clear();
+  for ( const auto & solv : candidates )
+  {
+    if ( ! query_r.kinds().empty() && query_r.kinds().find( solv.kind() ) == query_r.kinds().end() )
+      continue;
+    if ( std::binary_search( files.begin(), files.end(), solv ) )
+    {
+      matches_r.push_back( solv );
+      continue;
+    }
+    bool match = false;
+    for ( const auto & spec : specs_r )
+    {
+      CapDetail detail( spec.detail() );
+      for ( const Dep & dep : deps_r )
+      {
+        if ( ( match = depMatches( solv, dep, detail, query_r.caseSensitive() ) ) )
+          break;
+      }
+      if ( match )
+        break;
+    }
+    if ( match )
+      matches_r.push_back( solv );
+  }
+  for ( const auto & solv : files )
+  {
+    if ( ! query_r.kinds().empty() && query_r.kinds().find( solv.kind() ) == query_r.kinds().end() )
+      continue;
+    if ( ! std::binary_search( candidates.begin(), candidates.end(), solv ) )
+      matches_r.push_back( solv );
+  }
+  std::sort( matches_r.begin(), matches_r.end() );
+  MIL << "Repo indexes: " << candidates.size() << " candidates, " << files.size() << " file matches, "
+      << matches_r.size() << " matches" << endl;
+  return true;
+}
+
 static string string_weak_status(const ResStatus & rs)
 {
   if (rs.isRecommended())
@@ -416,10 +864,17 @@ void list_patches(Zypper & zypper)
   Table tbl;
 
   FillPatchesTable callback(tbl);
-  invokeOnEach(
-    God->pool().byKindBegin(ResKind::patch),
-    God->pool().byKindEnd(ResKind::patch),
-    callback);
+  // Repo names are looked up once per repo.
+  std::map<Repository,std::string> repoNames;
+  for_( it, God->pool().byKindBegin(ResKind::patch), God->pool().byKindEnd(ResKind::patch) )
+  {
+    if ( ! callback.wanted( *it ) )
+      continue;
+    std::map<Repository,std::string>::iterator repo( repoNames.find( (*it)->repository() ) );
+    if ( repo == repoNames.end() )
+      repo = repoNames.insert( std::make_pair( (*it)->repository(), (*it)->repository().asUserString() ) ).first;
+    tbl << callback.row( *it, repo->second );
+  }
 
   tbl.sort (1);                 // Name
 
@@ -432,7 +887,7 @@ void list_patches(Zypper & zypper)
 
 static void list_patterns_xml(Zypper & zypper)
 {
-  cout << "<pattern-list>" << endl;
+  cout << "<pattern-list>" << '\n';
 
   bool installed_only = zypper.cOpts().count("installed-only");
   bool notinst_only = zypper.cOpts().count("uninstalled-only");
@@ -446,10 +901,10 @@ static void list_patterns_xml(Zypper & zypper)
       continue;
 
     Pattern::constPtr pattern = asKind<Pattern>(it->resolvable());
-    cout << asXML(*pattern, isInstalled) << endl;
+    cout << asXML(*pattern, isInstalled) << '\n';
   }
 
-  cout << "</pattern-list>" << endl;
+  cout << "</pattern-list>" << '\n';
 }
 
 static void list_pattern_table(Zypper & zypper)
@@ -509,7 +964,7 @@ void list_patterns(Zypper & zypper)
     list_pattern_table(zypper);
 }
 
-void list_packages(Zypper & zypper)
+void list_packages(Zypper & zypper, const SolvableFormat * qformat)
 {
   MIL << "Going to list packages." << std::endl;
   Table tbl;
@@ -536,6 +991,17 @@ void list_packages(Zypper & zypper)
 	  || ( unneeded && status_r.isUnneeded() ) );
   };
 
+  // With --format the hits are sorted and printed after the walk; the
+  // table rows are built right away. Repo names are looked up once per repo.
+  struct Hit
+  {
+    sat::Solvable _solv;
+    const char * _status;
+  };
+  std::vector<Hit> hits;
+  std::map<Repository,std::string> repoNames;
+  bool rug = zypper.globalOpts().is_rug_compatible;
+
   const auto & pproxy( God->pool().proxy() );
   for_( it, pproxy.byKindBegin(ResKind::package), pproxy.byKindEnd(ResKind::package) )
   {
@@ -573,23 +1039,49 @@ void list_packages(Zypper & zypper)
 	}
       }
 
-      TableRow row;
+      const char * status = "";
       if ( s->hasInstalledObj() )
+	status = ( pi.status().isInstalled() || s->identicalInstalled( pi ) ? "i" : "v" );
+      if ( qformat )
       {
-	row << ( pi.status().isInstalled() || s->identicalInstalled( pi ) ? "i" : "v" );
+	hits.push_back( Hit{ pi.satSolvable(), status } );
+	continue;
       }
+
+      TableRow row( 5 );
+      row << status;
+      if ( rug )
+	row << "";
       else
       {
-	row << "";
+	std::map<Repository,std::string>::iterator repo( repoNames.find( pi->repository() ) );
+	if ( repo == repoNames.end() )
+	  repo = repoNames.insert( std::make_pair( pi->repository(), pi->repository().info().name() ) ).first;
+	row << repo->second;
       }
-      row << (zypper.globalOpts().is_rug_compatible ? "" : pi->repository().info().name())
-          << pi->name()
+      row << pi->name()
           << pi->edition().asString()
           << pi->arch().asString();
-      tbl << row;
+      tbl << std::move(row);
     }
   }
 
+  if ( qformat )
+  {
+    bool byRepo = zypper.cOpts().count("sort-by-repo");
+    std::stable_sort( hits.begin(), hits.end(), [&]( const Hit & lhs, const Hit & rhs )
+    {
+      if ( byRepo && lhs._solv.repository() != rhs._solv.repository() )
+	return lhs._solv.repository().alias() < rhs._solv.repository().alias();
+      return lhs._solv.name() < rhs._solv.name();
+    } );
+    for ( const Hit & hit : hits )
+      qformat->print( cout, PoolItem( hit._solv ), hit._status );
+    if ( hits.empty() )
+      cerr << _("No packages found.") << endl;	// keep stdout to the template
+    return;
+  }
+
   if (tbl.empty())
     zypper.out().info(_("No packages found."));
   else
@@ -620,7 +1112,7 @@ static void list_products_xml(Zypper & zypper)
   bool installed_only = zypper.cOpts().count("installed-only");
   bool notinst_only = zypper.cOpts().count("uninstalled-only");
 
-  cout << "<product-list>" << endl;
+  cout << "<product-list>" << '\n';
   ResPool::byKind_iterator
     it = God->pool().byKindBegin(ResKind::product),
     e  = God->pool().byKindEnd(ResKind::product);
@@ -632,9 +1124,9 @@ static void list_products_xml(Zypper & zypper)
       continue;
 
     Product::constPtr product = asKind<Product>(it->resolvable());
-    cout << asXML(*product, it->status().isInstalled()) << endl;
+    cout << asXML(*product, it->status().isInstalled()) << '\n';
   }
-  cout << "</product-list>" << endl;
+  cout << "</product-list>" << '\n';
 }
 
 // common product_table_row data
@@ -8,14 +8,56 @@
 #ifndef ZYPPERSEARCH_H_
 #define ZYPPERSEARCH_H_
 
+#include <set>
+#include <vector>
+
 #include <zypp/TriBool.h>
+#include <zypp/Dep.h>
 #include <zypp/PoolQuery.h>
 
 #include "Zypper.h"
 #include "Table.h"
+#include "misc.h"
 
 //std::string selectable_search_repo_str(const zypp::ui::Selectable & s);
 
+/**
+ * Streams the XML or JSON search result while the query is iterated.
+ *
+ * The opening tags are written on construction, each match is written as
+ * one \c <solvable> element (or JSON record) as soon as it is found, and
+ * the closing tags are written by \ref close (or on destruction).
+ *
+ * With a \a format_r (\c --format) each match is written as one instance
+ * of the template instead, without any tags.
+ */
+class SearchResultWriter : private zypp::base::NonCopyable
+{
+public:
+  explicit SearchResultWriter( Out & out_r, const SolvableFormat * format_r = nullptr );
+  ~SearchResultWriter();
+
+  /** Write \a pi_r (status indicator \a status_r as in the search table). */
+  void solvable( const char * status_r, const zypp::PoolItem & pi_r );
+  /** Write \a sel_r (status indicator \a status_r as in the search table). */
+  void selectable( const char * status_r, const zypp::ui::Selectable::constPtr & sel_r );
+
+  /** Write the closing tags. */
+  void close();
+
+  /** Number of elements written. */
+  unsigned count() const
+  { return _count; }
+
+private:
+  static const char * statusString( const char * status_r );
+
+  bool _json;
+  const SolvableFormat * _format;
+  unsigned _count;
+  bool _closed;
+};
+
 /**
  * Functor for filling search output table in rug style.
  */
@@ -23,6 +65,8 @@ struct FillSearchTableSolvable
 {
   // the table used for output
   Table * _table;
+  /** If set, results are streamed here instead of added to the table */
+  SearchResultWriter * _writer;
   const GlobalOptions & _gopts;
   /** Aliases of repos specified as --repo */
   std::set<std::string> _repos;
@@ -30,7 +74,8 @@ struct FillSearchTableSolvable
 
   FillSearchTableSolvable(
       Table & table,
-      zypp::TriBool inst_notinst = zypp::indeterminate );
+      zypp::TriBool inst_notinst = zypp::indeterminate,
+      SearchResultWriter * writer = nullptr );
 
   /** Add all items within this Selectable */
   bool operator()( const zypp::ui::Selectable::constPtr & sel ) const;
@@ -54,13 +99,16 @@ struct FillSearchTableSelectable
 {
   // the table used for output
   Table * _table;
+  /** If set, results are streamed here instead of added to the table */
+  SearchResultWriter * _writer;
   const GlobalOptions & _gopts;
   /** Aliases of repos specified as --repo */
   std::set<std::string> _repos;
   zypp::TriBool inst_notinst;
 
   FillSearchTableSelectable(
-      Table & table, zypp::TriBool installed_only = zypp::indeterminate);
+      Table & table, zypp::TriBool installed_only = zypp::indeterminate,
+      SearchResultWriter * writer = nullptr);
 
   bool operator()(const zypp::ui::Selectable::constPtr & s) const;
 };
@@ -79,10 +127,75 @@ struct FillPatchesTable
   FillPatchesTable( Table & table,
       zypp::TriBool inst_notinst = zypp::indeterminate );
 
+  /** Whether \a pi passes the installed/not installed filter. */
+  bool wanted(const zypp::PoolItem & pi) const;
+
+  /** The row for \a pi, \a repo is the repos user string. */
+  TableRow row(const zypp::PoolItem & pi, const std::string & repo) const;
+
   bool operator()(const zypp::PoolItem & pi) const;
 };
 
 
+/**
+ * Evaluate \a query_r in forked jobs, each one searching a range of repos.
+ *
+ * Meant for CPU bound queries (substring or regex match in summaries and
+ * descriptions). libzypp/libsolv are not thread safe, so jobs are forked
+ * processes sharing the loaded pool copy-on-write; they send back the ids
+ * of the matching solvables. \a query_r must not be restricted to repos
+ * yet, the repos to search are passed in \a repos_r (empty: all).
+ *
+ * \return \c false if not worth splitting or a job failed; \a matches_r is
+ * then undefined and the query should be evaluated the usual way. On
+ * success \a matches_r contains the matches in the same order as iterating
+ * the query restricted to \a repos_r would yield them.
+ */
+bool evaluate_query_parallel( const zypp::PoolQuery & query_r,
+                              const std::set<std::string> & repos_r,
+                              std::vector<zypp::sat::Solvable> & matches_r );
+
+/**
+ * Evaluate an exact match search in dependencies and file lists using the
+ * reverse dependency and file path index of each repo (see dep-index.h and
+ * file-index.h) instead of scanning all solvables.
+ *
+ * \a specs_r are the searched capabilities (name and optional edition
+ * range and arch), \a deps_r the dependencies to search them in. \a files_r
+ * are the paths to search in the file lists. Kinds, case sensitivity and
+ * the uninstalled-only filter are taken from \a query_r; the repos to
+ * search are passed in \a repos_r (empty: all).
+ *
+ * \return \c false if a repo can't be indexed; the query should then be
+ * evaluated the usual way. Otherwise \a matches_r is set like in
+ * \ref evaluate_query_parallel.
+ */
+bool evaluate_query_indexed( Zypper & zypper,
+                             const zypp::PoolQuery & query_r,
+                             const std::vector<zypp::Capability> & specs_r,
+                             const std::vector<zypp::Dep> & deps_r,
+                             const std::vector<std::string> & files_r,
+                             const std::set<std::string> & repos_r,
+                             std::vector<zypp::sat::Solvable> & matches_r );
+
+/** Call \a fnc_r for the selectable of each solvable in \a matches_r,
+ * once per selectable in order of the first match (like iterating
+ * \c PoolQuery::selectableBegin()). Stops if \a fnc_r returns \c false.
+ */
+template <class _Function>
+void invokeOnEachSelectable( const std::vector<zypp::sat::Solvable> & matches_r, _Function fnc_r )
+{
+  std::set<zypp::ui::Selectable::constPtr> seen;
+  for ( const auto & solv : matches_r )
+  {
+    zypp::ui::Selectable::constPtr sel( zypp::ui::Selectable::get( solv ) );
+    if ( ! sel || ! seen.insert( sel ).second )
+      continue;
+    if ( ! fnc_r( sel ) )
+      break;
+  }
+}
+
 /** List all patches with specific info in specified repos */
 void list_patches(Zypper & zypper);
 
@@ -90,8 +203,10 @@ void list_patches(Zypper & zypper);
 void list_patterns(Zypper & zypper);
 
 /** List all packages with specific info in specified repos
- *  - currently looks like zypper search -t package -r foorepo */
-void list_packages(Zypper & zypper);
+ *  - currently looks like zypper search -t package -r foorepo
+ *  - with \a qformat (\c --format) each package is printed using the
+ *    template, sorted like the table */
+void list_packages(Zypper & zypper, const SolvableFormat * qformat = nullptr);
 
 /** List all products with specific info in specified repos */
 void list_products(Zypper & zypper);
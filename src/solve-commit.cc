@@ -24,6 +24,9 @@
 #include "utils/prompt.h"      // Continue? and solver problem prompt
 #include "utils/pager.h"       // to view the summary
 #include "Summary.h"
+#include "transaction-plan.h"
+#include "install-roots.h"
+#include "completion.h"
 
 #include "solve-commit.h"
 
@@ -454,6 +457,15 @@ static void notify_processes_using_deleted_files(Zypper & zypper)
   }
 }
 
+/** Show the summary again after a view option was toggled in the prompt.
+ * XML and JSON carry all attributes already, plain text would break them.
+ */
+static void redump_summary(Zypper & zypper, Summary & summary)
+{
+  if (zypper.out().typeNORMAL())
+    summary.dumpTo(cout);
+}
+
 static void show_update_messages(Zypper & zypper, const UpdateNotifications & messages)
 {
   if (messages.empty())
@@ -462,7 +474,6 @@ static void show_update_messages(Zypper & zypper, const UpdateNotifications & me
   zypper.out().info(_("Update notifications were received from the following packages:"));
   MIL << "Received " << messages.size() << " update notification(s):" << endl;
 
-  std::ostringstream msg;
   for_(it, messages.begin(), messages.end())
   {
     MIL << "- From " << it->solvable().asString()
@@ -470,12 +481,6 @@ static void show_update_messages(Zypper & zypper, const UpdateNotifications & me
     zypper.out().info(
         it->solvable().asString() + " (" +
         Pathname::showRootIf(zypper.globalOpts().root_dir, it->file()) + ")");
-    {
-      msg << str::form(_("Message from package %s:"), it->solvable().name().c_str()) << endl << endl;
-      InputStream istr(Pathname::assertprefix(zypper.globalOpts().root_dir, it->file()));
-      iostr::copy(istr, msg);
-      msg << endl << "-----------------------------------------------------------------------------" << endl;
-    }
   }
 
   PromptOptions popts;
@@ -489,7 +494,19 @@ static void show_update_messages(Zypper & zypper, const UpdateNotifications & me
   reply = get_prompt_reply(zypper, PROMPT_YN_INST_REMOVE_CONTINUE, popts);
 
   if (reply == 0)
-    show_text_in_pager(msg.str());
+  {
+    // the files are copied into the pager one after another
+    Pager pager;
+    std::ostream & msg( pager.stream() );
+    for_(it, messages.begin(), messages.end())
+    {
+      msg << str::form(_("Message from package %s:"), it->solvable().name().c_str()) << endl << endl;
+      InputStream istr(Pathname::assertprefix(zypper.globalOpts().root_dir, it->file()));
+      iostr::copy(istr, msg);
+      msg << endl << "-----------------------------------------------------------------------------" << endl;
+    }
+    pager.close();
+  }
 }
 
 
@@ -508,6 +525,9 @@ static void show_update_messages(Zypper & zypper, const UpdateNotifications & me
  */
 void solve_and_commit (Zypper & zypper)
 {
+  // multi-root mode: one job at a time solves and downloads
+  InstallRootPrepareLock prepare_lock(zypper);
+
   bool need_another_solver_run = true;
   do
   {
@@ -555,6 +575,16 @@ void solve_and_commit (Zypper & zypper)
 
     MIL << "got solution, showing summary" << endl;
 
+    {
+      parsed_opts::const_iterator it( zypper.cOpts().find("plan-out") );
+      if (it != zypper.cOpts().end() && !write_transaction_plan(zypper, it->second.back()))
+      {
+        zypper.setExitCode(ZYPPER_EXIT_ERR_BUG);
+        return;
+      }
+    }
+    prepare_lock.publish();
+
     // SHOW SUMMARY
 
     Summary summary(God->pool());
@@ -592,6 +622,8 @@ void solve_and_commit (Zypper & zypper)
     // show the summary
     if (zypper.out().type() == Out::TYPE_XML)
       summary.dumpAsXmlTo(cout);
+    else if (zypper.out().typeJSON())
+      summary.dumpAsJson();
     else
       summary.dumpTo(cout);
 
@@ -690,40 +722,40 @@ void solve_and_commit (Zypper & zypper)
         case 3: // v - show version
         {
           summary.toggleViewOption(Summary::SHOW_VERSION);
-          summary.dumpTo(cout);
+          redump_summary(zypper, summary);
           break;
         }
         case 4: // a - show arch
         {
           summary.toggleViewOption(Summary::SHOW_ARCH);
-          summary.dumpTo(cout);
+          redump_summary(zypper, summary);
           break;
         }
         case 5: // r - show repos
         {
           summary.toggleViewOption(Summary::SHOW_REPO);
-          summary.dumpTo(cout);
+          redump_summary(zypper, summary);
           break;
         }
         case 6: // m - show vendor
         {
           summary.toggleViewOption(Summary::SHOW_VENDOR);
-          summary.dumpTo(cout);
+          redump_summary(zypper, summary);
           break;
         }
         case 7: // d - show details (all attributes)
         {
           summary.toggleViewOption(Summary::DETAILS);
-          summary.dumpTo(cout);
+          redump_summary(zypper, summary);
           break;
         }
         case 8: // g - view in pager
         {
-          ostringstream s;
+          Pager pager;
           summary.setForceNoColor(true);
-          summary.dumpTo(s);
+          summary.dumpTo(pager.stream());
           summary.setForceNoColor(false);
-          show_text_in_pager(s.str());
+          pager.close();
           break;
         }
         default: // n - no
@@ -760,7 +792,13 @@ void solve_and_commit (Zypper & zypper)
             s << " " << _("(dry run)") << endl;
           zypper.out().info(s.str(), Out::HIGH);
 
-          ZYppCommitResult result = God->commit(get_commit_policy(zypper));
+          ZYppCommitPolicy policy(get_commit_policy(zypper));
+          prepare_lock.downloadAndRelease(policy);
+          // taken now, the commit unloads @System from the pool
+          std::set<std::string> installed;
+          if (!policy.dryRun())
+            installed = package_names_after_commit();
+          ZYppCommitResult result = God->commit(policy);
 
           MIL << endl << "DONE" << endl;
 
@@ -773,6 +811,9 @@ void solve_and_commit (Zypper & zypper)
           zypper.out().info(s.str(), Out::HIGH);
 
           show_update_messages(zypper, result.updateMessages());
+
+          if (!policy.dryRun())
+            update_completion_index(zypper, result.noError() ? &installed : nullptr);
         }
         catch ( const media::MediaException & e )
         {
@@ -6,6 +6,10 @@
 \*---------------------------------------------------------------------------*/
 
 #include <iostream>
+#include <fstream>
+#include <unordered_map>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include <zypp/base/LogTools.h>
 #include <zypp/ResPool.h>
@@ -28,10 +32,11 @@ const std::string SourceDownloadOptions::_manifestName( "MANIFEST" );
 
 inline std::ostream & operator<<( std::ostream & str, const SourceDownloadOptions & obj )
 {
-  return str << boost::format( "{%1%|%2%%3%}" )
+  return str << boost::format( "{%1%|%2%|j%3%%4%}" )
 	      % obj._directory
 // 	      % (obj._manifest ? 'M' : 'm' )
 	      % (obj._delete ? 'D' : 'd' )
+	      % obj._jobs
 	      % (obj._dryrun ? "(dry-run)" : "" );
 }
 
@@ -105,9 +110,23 @@ namespace
 
       std::string _longname;	//< Key: name-version-release.type
       std::string _localFile;	//< name of srpm if downloaded
+      off_t _localSize = 0;	//< size of _localFile
+      time_t _localMtime = 0;	//< mtime of _localFile
       PoolItem _srcPackage;	//< available SrcPackage providning the srpm
       std::vector<PoolItem> _packages;	//< installed Packages built from this srpm
 
+      /** Name of the srpm in the download directory */
+      std::string makeFileName() const
+      { return _longname + ".rpm"; }
+
+      /** Remember the srpm in the download directory and its stat data (for the MANIFEST index) */
+      void setLocalFile( const std::string & file_r, const PathInfo & pi_r )
+      {
+	_localFile = file_r;
+	_localSize = pi_r.size();
+	_localMtime = pi_r.mtime();
+      }
+
       static std::string makeLongname( const std::string & name_r, Edition edition_r, bool nosrc_r )
       { return str::Str() << name_r << '-' << edition_r << '.' << (nosrc_r ? "nosrc" : "src"); }
    };
@@ -143,6 +162,56 @@ namespace
     };
     ///////////////////////////////////////////////////////////////////
 
+    ///////////////////////////////////////////////////////////////////
+    /// \class SourceDownloadImpl::ManifestIndex
+    /// \brief The srpms recorded in a previous runs MANIFEST.
+    ///
+    /// Each MANIFEST line reads <tt>longname file size mtime</tt>. A srpm
+    /// whose name, size and mtime still match its entry need not be read
+    /// again to learn its longname.
+    ///////////////////////////////////////////////////////////////////
+    struct ManifestIndex
+    {
+      struct Entry
+      {
+	std::string _longname;
+	off_t _size;
+	time_t _mtime;
+      };
+
+      /** Read the index from \a file_r (a missing or malformed MANIFEST just results in an empty index). */
+      void read( const Pathname & file_r )
+      {
+	std::ifstream str( file_r.c_str() );
+	std::string line;
+	while ( std::getline( str, line ) )
+	{
+	  std::istringstream words( line );
+	  std::string longname;
+	  std::string file;
+	  Entry entry;
+	  if ( words >> longname >> file >> entry._size >> entry._mtime )
+	  {
+	    entry._longname.swap( longname );
+	    _entries[file] = std::move(entry);	// later lines (journal) win
+	  }
+	}
+	DBG << "MANIFEST index: " << _entries.size() << " entries" << endl;
+      }
+
+      /** The longname recorded for \a file_r if the index entry is still valid, else \c nullptr. */
+      const std::string * lookup( const std::string & file_r, const PathInfo & pi_r ) const
+      {
+	auto it( _entries.find( file_r ) );
+	if ( it == _entries.end() || it->second._size != pi_r.size() || it->second._mtime != pi_r.mtime() )
+	  return nullptr;
+	return &it->second._longname;
+      }
+
+      std::unordered_map<std::string,Entry> _entries;
+    };
+    ///////////////////////////////////////////////////////////////////
+
   public:
     void sourceDownload();
 
@@ -153,6 +222,27 @@ namespace
     std::ostream & dumpManifestSumary( std::ostream & str, Manifest::StatusMap & status );
     std::ostream & dumpManifestTable( std::ostream & str );
 
+    /** Download missing srpms one by one. */
+    void downloadSequential( unsigned total_r );
+    /** Download missing srpms using up to \c _options->_jobs forked jobs. */
+    void downloadParallel( unsigned total_r );
+    /** Forked job downloading a single srpm; error messages are written to \a fd_r.
+     * \returns the job's exit code.
+     */
+    int downloadJob( SourcePkg & spkg_r, int fd_r );
+    /** Print the status row of a finished parallel download. */
+    void reportJob( const SourcePkg & spkg_r, unsigned current_r, unsigned total_r, const std::string & error_r );
+
+    /** Move a provided srpm into the download directory (via a \c .part file, so
+     * an interrupted run never leaves a truncated srpm behind).
+     */
+    void storeSrcPackage( SourcePkg & spkg_r, const Pathname & localfile_r );
+
+    /** Append a downloaded srpm to the MANIFEST, so progress survives an interrupted run. */
+    void recordDownloaded( const SourcePkg & spkg_r );
+    /** Rewrite the MANIFEST listing all srpms in the download directory. */
+    void writeManifest();
+
   private:
     Zypper & _zypper;				//< my Zypper
     shared_ptr<SourceDownloadOptions> _options;	//< my Options
@@ -160,9 +250,14 @@ namespace
     Pathname _dnlDir;	//< download directory (incl. root prefix)
     Manifest _manifest;
     DefaultIntegral<unsigned,0U> _installedPkgCount;
+    std::ofstream _manifestJournal;	//< MANIFEST opened for appending during download
+    static const std::string _partSuffix;
   };
   ///////////////////////////////////////////////////////////////////
 
+  const std::string SourceDownloadImpl::_partSuffix( ".part" );
+  ///////////////////////////////////////////////////////////////////
+
   /** \relates SourceDownloadImpl::SourcePkg::Status String representation */
   inline std::string asString( SourceDownloadImpl::SourcePkg::Status obj )
   {
@@ -189,6 +284,10 @@ namespace
     return str;
   }
 
+  /** \relates SourceDownloadImpl::SourcePkg Write its MANIFEST line (no NL) */
+  inline std::ostream & writeManifestLine( std::ostream & str, const SourceDownloadImpl::SourcePkg & obj )
+  { return str << obj._longname << ' ' << obj._localFile << ' ' << obj._localSize << ' ' << obj._localMtime; }
+
   ///////////////////////////////////////////////////////////////////
   /// class SourceDownloadImpl
   ///////////////////////////////////////////////////////////////////
@@ -238,6 +337,10 @@ namespace
 	return;
       }
 
+      ManifestIndex index;
+      index.read( pi.path() / _options->_manifestName );
+      unsigned reread = 0;
+
       Out::ProgressBar report( _zypper.out(), _("Scanning download directory") );
       report->range( todolist.size() );
       for ( const auto & file : todolist )
@@ -247,16 +350,36 @@ namespace
 	if ( file == _options->_manifestName )
 	  continue;
 
+	if ( str::endsWith( file, _partSuffix ) )
+	{
+	  // leftover of an interrupted download
+	  if ( ! _options->_dryrun )
+	    filesystem::unlink( pi.path() / file );
+	  continue;
+	}
+
+	PathInfo fpi( pi.path() / file );
+	if ( ! fpi.isFile() )
+	  continue;
+
+	const std::string * longname( index.lookup( file, fpi ) );
+	if ( longname )
+	{
+	  _manifest.get( *longname ).setLocalFile( file, fpi );
+	  continue;
+	}
+
 	using target::rpm::RpmHeader;
-	Pathname path( pi.path() / file );
-	RpmHeader::constPtr pkg( RpmHeader::readPackage( path, RpmHeader::NOVERIFY ) );
+	++reread;
+	RpmHeader::constPtr pkg( RpmHeader::readPackage( fpi.path(), RpmHeader::NOVERIFY ) );
 
 	if ( ! ( pkg && pkg->isSrc() ) )
 	  continue;
 
 	SourcePkg & spkg( _manifest.get( SourcePkg::makeLongname( pkg->tag_name(), pkg->tag_edition(), pkg->isNosrc() ) ) );
-	spkg._localFile = file;
+	spkg.setLocalFile( file, fpi );
       }
+      MIL << "Read " << reread << " of " << todolist.size() << " files not in MANIFEST index" << endl;
     }
 
     // scan installed packages to manifest
@@ -355,6 +478,276 @@ namespace
   }
 
 
+  void SourceDownloadImpl::storeSrcPackage( SourcePkg & spkg_r, const Pathname & localfile_r )
+  {
+    std::string file( spkg_r.makeFileName() );
+    Pathname part( _dnlDir / (file+_partSuffix) );
+
+    if ( filesystem::hardlinkCopy( localfile_r, part ) != 0 || filesystem::rename( part, _dnlDir / file ) != 0 )
+    {
+      Errno err;
+      ERR << "Can't hardlink/copy " << localfile_r << " to " << (_dnlDir / file) << endl;
+      filesystem::unlink( part );
+      throw( Out::Error( ZYPPER_EXIT_ERR_BUG,
+			 boost::format(_("Error downloading source package '%s'.") ) % spkg_r._longname,
+			 err.asString() ) );
+    }
+    spkg_r.setLocalFile( file, PathInfo( _dnlDir / file ) );
+  }
+
+  void SourceDownloadImpl::recordDownloaded( const SourcePkg & spkg_r )
+  {
+    if ( _manifestJournal.is_open() )
+      writeManifestLine( _manifestJournal, spkg_r ) << endl;	// flush: progress must survive an interrupt
+  }
+
+  void SourceDownloadImpl::writeManifest()
+  {
+    Pathname manifest( _dnlDir / _options->_manifestName );
+    Pathname tmp( _dnlDir / (_options->_manifestName+_partSuffix) );
+    {
+      std::ofstream str( tmp.c_str() );
+      for ( const auto & item : _manifest )
+      {
+	const SourcePkg & spkg( item.second );
+	if ( spkg.downloaded() )
+	  writeManifestLine( str, spkg ) << endl;
+      }
+      if ( ! str )
+      {
+	WAR << "Failed to write " << tmp << endl;
+	filesystem::unlink( tmp );
+	return;
+      }
+    }
+    if ( filesystem::rename( tmp, manifest ) != 0 )
+      WAR << "Failed to update " << manifest << endl;
+  }
+
+  void SourceDownloadImpl::downloadSequential( unsigned total_r )
+  {
+    repo::RepoMediaAccess access;
+    repo::SrcPackageProvider prov( access );
+    unsigned current = 0;
+    for ( auto & item : _manifest )
+    {
+      SourcePkg & spkg( item.second );
+      if ( spkg.status() != SourcePkg::S_MISSING )
+	continue;
+      ++current;
+
+      try
+      {
+	Out::ProgressBar report( _zypper.out(), spkg._longname, current, total_r );
+
+	if ( ! spkg.lookupSrcPackage() )
+	{
+	  report.error();
+	  throw( Out::Error( ZYPPER_EXIT_ERR_BUG,
+			     boost::format(_("Source package '%s' is not provided by any repository.") ) % spkg._longname ) );
+	}
+	report.print( str::form( "%s (%s)",  spkg._longname.c_str(), spkg._srcPackage->repository().name().c_str() ) );
+	MIL << spkg._srcPackage << endl;
+
+	ManagedFile localfile;
+	{
+	  report.error(); // error if provideSrcPackage throws
+	  Out::DownloadProgress redirect( report );
+	  localfile = prov.provideSrcPackage( spkg._srcPackage->asKind<SrcPackage>() );
+	  DBG << localfile << endl;
+	  report.error( false );
+	}
+
+	report.error(); // error if storeSrcPackage throws
+	storeSrcPackage( spkg, localfile );
+	report.error( false );
+	recordDownloaded( spkg );
+      }
+      catch ( const Out::Error & error_r )
+      {
+	error_r.report( _zypper );
+      }
+      catch ( const Exception & exp )
+      {
+	// TODO: Need class Out::Error support for exceptions
+	ERR << exp << endl;
+	_zypper.out().error( exp,
+			     boost::str( boost::format(_("Error downloading source package '%s'.") ) % spkg._longname ) );
+
+	//throw( Out::Error( ZYPPER_EXIT_ERR_BUG ) );
+      }
+
+      if ( _zypper.exitRequested() )
+	throw( Out::Error( ZYPPER_EXIT_ON_SIGNAL ) );
+    }
+  }
+
+  void SourceDownloadImpl::downloadParallel( unsigned total_r )
+  {
+    struct Job
+    {
+      SourcePkg * _spkg;
+      int _fd;	//< read end of the pipe receiving the jobs error message
+    };
+    std::map<pid_t,Job> running;
+
+    std::vector<SourcePkg*> todo;
+    for ( auto & item : _manifest )
+    {
+      if ( item.second.status() == SourcePkg::S_MISSING )
+	todo.push_back( &item.second );
+    }
+
+    MIL << "Downloading " << todo.size() << " srpms using " << _options->_jobs << " jobs" << endl;
+    unsigned current = 0;
+    auto next( todo.begin() );
+    while ( true )
+    {
+      // fill the free job slots
+      while ( next != todo.end() && running.size() < _options->_jobs && ! _zypper.exitRequested() )
+      {
+	SourcePkg & spkg( **next );
+
+	if ( ! spkg.lookupSrcPackage() )
+	{
+	  ++next;
+	  reportJob( spkg, ++current, total_r,
+		     boost::str( boost::format(_("Source package '%s' is not provided by any repository.") ) % spkg._longname ) );
+	  continue;
+	}
+	MIL << spkg._srcPackage << endl;
+
+	int fds[2];
+	pid_t pid = -1;
+	if ( ::pipe( fds ) == 0 )
+	{
+	  pid = ::fork();
+	  if ( pid == 0 )
+	  {
+	    ::close( fds[0] );
+	    ::_exit( downloadJob( spkg, fds[1] ) );	// no atexit handlers in the job
+	  }
+	  ::close( fds[1] );
+	  if ( pid == -1 )
+	    ::close( fds[0] );
+	}
+
+	if ( pid == -1 )
+	{
+	  Errno err;
+	  WAR << "Failed to start download job: " << err << endl;
+	  if ( running.empty() )
+	    throw( Out::Error( ZYPPER_EXIT_ERR_BUG, _("Failed to start download job."), err.asString() ) );
+	  break;	// wait for a running job to finish
+	}
+
+	DBG << "Job " << pid << ": " << spkg._longname << endl;
+	running[pid] = Job{ &spkg, fds[0] };
+	++next;
+      }
+
+      if ( running.empty() )
+	break;
+
+      int status = 0;
+      pid_t pid = ::waitpid( -1, &status, 0 );
+      if ( pid == -1 )
+      {
+	if ( errno == EINTR )
+	  continue;
+	ERR << "waitpid: " << Errno() << endl;
+	throw( Out::Error( ZYPPER_EXIT_ERR_BUG, _("Lost track of the download jobs."), Errno().asString() ) );
+      }
+
+      auto it( running.find( pid ) );
+      if ( it == running.end() )
+	continue;
+      Job job( it->second );
+      running.erase( it );
+
+      std::string error;
+      {
+	char buf[512];
+	ssize_t cnt;
+	while ( ( cnt = ::read( job._fd, buf, sizeof(buf) ) ) > 0 || ( cnt == -1 && errno == EINTR ) )
+	{
+	  if ( cnt > 0 )
+	    error.append( buf, cnt );
+	}
+	::close( job._fd );
+      }
+
+      if ( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 )
+      {
+	std::string file( job._spkg->makeFileName() );
+	job._spkg->setLocalFile( file, PathInfo( _dnlDir / file ) );
+	recordDownloaded( *job._spkg );
+      }
+      else if ( error.empty() )
+      {
+	WAR << "Job " << pid << " terminated abnormally (" << status << ")" << endl;
+	error = boost::str( boost::format(_("Error downloading source package '%s'.") ) % job._spkg->_longname );
+      }
+      reportJob( *job._spkg, ++current, total_r, error );
+    }
+
+    if ( _zypper.exitRequested() )
+      throw( Out::Error( ZYPPER_EXIT_ON_SIGNAL ) );
+  }
+
+  int SourceDownloadImpl::downloadJob( SourcePkg & spkg_r, int fd_r )
+  {
+    // A job must neither prompt nor draw; the parent reports the result.
+    _zypper.globalOptsNoConst().non_interactive = true;
+    _zypper.out().setVerbosity( Out::QUIET );
+
+    std::string error;
+    try
+    {
+      repo::RepoMediaAccess access;
+      repo::SrcPackageProvider prov( access );
+      ManagedFile localfile( prov.provideSrcPackage( spkg_r._srcPackage->asKind<SrcPackage>() ) );
+      DBG << localfile << endl;
+      storeSrcPackage( spkg_r, localfile );
+    }
+    catch ( const Out::Error & error_r )
+    {
+      error = error_r._msg;
+      if ( ! error_r._hint.empty() )
+	error += "\n" + error_r._hint;
+    }
+    catch ( const Exception & exp )
+    {
+      ERR << exp << endl;
+      error = boost::str( boost::format(_("Error downloading source package '%s'.") ) % spkg_r._longname );
+      error += "\n" + exp.asUserHistory();
+    }
+
+    if ( error.empty() )
+      return ZYPPER_EXIT_OK;
+
+    // keep it below the pipe capacity, the parent reads after we exited
+    if ( error.size() > 4096 )
+      error.resize( 4096 );
+    if ( ::write( fd_r, error.c_str(), error.size() ) == -1 )
+      ERR << "Failed to report: " << error << endl;
+    ::close( fd_r );
+    return ZYPPER_EXIT_ERR_BUG;
+  }
+
+  void SourceDownloadImpl::reportJob( const SourcePkg & spkg_r, unsigned current_r, unsigned total_r, const std::string & error_r )
+  {
+    {
+      std::string label( spkg_r._srcPackage
+                       ? str::form( "%s (%s)",  spkg_r._longname.c_str(), spkg_r._srcPackage->repository().name().c_str() )
+		       : spkg_r._longname );
+      Out::ProgressBar report( _zypper.out(), Out::ProgressBar::noStartBar, label, current_r, total_r );
+      report.error( ! error_r.empty() );
+    }
+    if ( ! error_r.empty() )
+      Out::Error( ZYPPER_EXIT_ERR_BUG, error_r ).report( _zypper );
+  }
+
   void SourceDownloadImpl::sourceDownload()
   {
     buildManifest();
@@ -414,70 +807,18 @@ namespace
     if ( status[SourcePkg::S_MISSING] )
     {
       _zypper.out().info(_("Downloading required source packages...") );
-      repo::RepoMediaAccess access;
-      repo::SrcPackageProvider prov( access );
-      unsigned current = 0;
-      for ( auto & item : _manifest )
-      {
-	SourcePkg & spkg( item.second );
-	if ( spkg.status() != SourcePkg::S_MISSING )
-	  continue;
-	++current;
-
-	try
-	{
-	  Out::ProgressBar report( _zypper.out(), spkg._longname, current, status[SourcePkg::S_MISSING] );
-
-	  if ( ! spkg.lookupSrcPackage() )
-	  {
-	    report.error();
-	    throw( Out::Error( ZYPPER_EXIT_ERR_BUG,
-			       boost::format(_("Source package '%s' is not provided by any repository.") ) % spkg._longname ) );
-	  }
-	  report.print( str::form( "%s (%s)",  spkg._longname.c_str(), spkg._srcPackage->repository().name().c_str() ) );
-	  MIL << spkg._srcPackage << endl;
-
-	  ManagedFile localfile;
-	  {
-	    report.error(); // error if provideSrcPackage throws
-	    Out::DownloadProgress redirect( report );
-	    localfile = prov.provideSrcPackage( spkg._srcPackage->asKind<SrcPackage>() );
-	    DBG << localfile << endl;
-	    report.error( false );
-	  }
-
-	  if ( filesystem::hardlinkCopy( localfile, _dnlDir / (spkg._longname+".rpm") ) != 0 )
-	  {
-	    ERR << "Can't hardlink/copy " << localfile << " to " <<  (_dnlDir / spkg._longname) << endl;
-	    report.error();
-	    throw( Out::Error( ZYPPER_EXIT_ERR_BUG,
-			       boost::format(_("Error downloading source package '%s'.") ) % spkg._longname ),
-			       Errno().asString() );
-	  }
-	  spkg._localFile = spkg._longname;
-	}
-	catch ( const Out::Error & error_r )
-	{
-	  error_r.report( _zypper );
-	}
-	catch ( const Exception & exp )
-	{
-	  // TODO: Need class Out::Error support for exceptions
-	  ERR << exp << endl;
-	  _zypper.out().error( exp,
-			       boost::str( boost::format(_("Error downloading source package '%s'.") ) % spkg._longname ) );
-
-	  //throw( Out::Error( ZYPPER_EXIT_ERR_BUG ) );
-	}
-
-	if ( _zypper.exitRequested() )
-	  throw( Out::Error( ZYPPER_EXIT_ON_SIGNAL ) );
-      }
+      _manifestJournal.open( (_dnlDir / _options->_manifestName).c_str(), std::ios_base::app );
+      if ( _options->_jobs > 1 )
+	downloadParallel( status[SourcePkg::S_MISSING] );
+      else
+	downloadSequential( status[SourcePkg::S_MISSING] );
+      _manifestJournal.close();
     }
     else
     {
       _zypper.out().info(_("No source packages to download.") );
     }
+    writeManifest();
 
     // finished
     cout << endl;
@@ -27,6 +27,7 @@ class Zypper;
       "--no-delete          Do not delete extraneous source rpms.\n"
       "--dry-run            Don't download any source rpms nor write a MANIFEST,\n"
       "                     but show which source rpms are missing or extraneous.\n"
+      "-j, --jobs <N>       Number of source rpms to download in parallel.\n"
 
       TBD: maybe write manifest file to download directory.
 */
@@ -42,12 +43,14 @@ struct SourceDownloadOptions : public Options
 //     , _manifest( true )
     , _delete( true )
     , _dryrun( false )
+    , _jobs( 1 )
   {}
 
   Pathname _directory;	//< Download all source rpms to this directory.
 //   int _manifest;	//< Whether to write a MANIFEST file.
   int _delete;		//< Whether to delete extranous source rpms.
   int _dryrun;		//< Dryrun mode.
+  unsigned _jobs;	//< Number of parallel downloads.
 };
 
 /** Download source rpms for all installed packages to a local directory.
@@ -0,0 +1,328 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include <zypp/ZYpp.h>
+#include <zypp/base/LogTools.h>
+#include <zypp/base/String.h>
+#include <zypp/Digest.h>
+#include <zypp/ResPool.h>
+#include <zypp/Package.h>
+#include <zypp/sat/Pool.h>
+
+#include "Zypper.h"
+#include "transaction-plan.h"
+
+extern ZYpp::Ptr God;
+
+///////////////////////////////////////////////////////////////////
+namespace
+{
+  typedef std::map<std::string,std::string> RepoCookies;
+
+  /** Plan file names of the ResStatus::TransactByValue values. */
+  const char * causerNames[] = { "solver", "appl_low", "appl_high", "user" };
+
+  std::string causerName( ResStatus::TransactByValue causer_r )
+  { return causerNames[causer_r]; }
+
+  /** \c false if \a name_r is not a known causer name. */
+  bool causerValue( const std::string & name_r, ResStatus::TransactByValue & causer_r )
+  {
+    for ( unsigned i = 0; i < sizeof(causerNames)/sizeof(*causerNames); ++i )
+    {
+      if ( name_r == causerNames[i] )
+      {
+	causer_r = ResStatus::TransactByValue( i );
+	return true;
+      }
+    }
+    return false;
+  }
+
+  /** \c false if \a action_r is not a known step action. */
+  inline bool validAction( const std::string & action_r )
+  { return action_r == "install" || action_r == "remove" || action_r == "replace"; }
+
+  /** Cookie of the installed system: digest over the sorted NEVRAs in the rpmdb. */
+  std::string rpmdbCookie()
+  {
+    std::vector<std::string> nevras;
+    Repository system( sat::Pool::instance().findSystemRepo() );
+    for_( it, system.solvablesBegin(), system.solvablesEnd() )
+      nevras.push_back( it->asString() );
+    std::sort( nevras.begin(), nevras.end() );
+
+    Digest digest;
+    digest.create( Digest::sha1() );
+    for ( const auto & nevra : nevras )
+      digest.update( nevra.c_str(), nevra.size()+1 );	// incl. NUL as separator
+    return digest.digest();
+  }
+
+  /** Cookies of the repos loaded into the pool: the raw metadata checksum. */
+  RepoCookies repoCookies( Zypper & zypper )
+  {
+    RepoCookies ret;
+    for_( it, sat::Pool::instance().reposBegin(), sat::Pool::instance().reposEnd() )
+    {
+      if ( it->isSystemRepo() )
+	continue;
+      std::string cookie( zypper.repoManager().metadataStatus( it->info() ).checksum() );
+      ret[it->alias()] = cookie.empty() ? "-" : cookie;
+    }
+    return ret;
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class PlanStep
+  /// \brief One transaction step of a plan.
+  ///////////////////////////////////////////////////////////////////
+  struct PlanStep
+  {
+    std::string _action;	//< install, remove or replace (removal due to upgrade)
+    ResStatus::TransactByValue _causer = ResStatus::USER;
+    std::string _kind;
+    std::string _name;
+    std::string _edition;
+    std::string _arch;
+    std::string _repo;
+    std::string _checksum;	//< type:value or "-"
+
+    /** Build the step for a transacting \a pi_r. */
+    static PlanStep fromPoolItem( const PoolItem & pi_r )
+    {
+      PlanStep ret;
+      if ( pi_r.status().isToBeUninstalledDueToUpgrade() )
+	ret._action = "replace";
+      else if ( pi_r.status().isToBeUninstalled() )
+	ret._action = "remove";
+      else
+	ret._action = "install";
+      ret._causer = pi_r.status().getTransactByValue();
+      ret._kind = pi_r->kind().asString();
+      ret._name = pi_r->name();
+      ret._edition = pi_r->edition().asString();
+      ret._arch = pi_r->arch().asString();
+      ret._repo = pi_r->repository().alias();
+      ret._checksum = "-";
+      if ( ret._action == "install" && isKind<Package>( pi_r.resolvable() ) )
+      {
+	CheckSum checksum( asKind<Package>( pi_r.resolvable() )->checksum() );
+	if ( ! checksum.empty() )
+	  ret._checksum = checksum.type() + ":" + checksum.checksum();
+      }
+      return ret;
+    }
+
+    /** The pool item this step refers to (or \c noItem). */
+    PoolItem lookup() const
+    {
+      ResPool pool( ResPool::instance() );
+      for_( it, pool.byIdentBegin( ResKind( _kind ), _name ), pool.byIdentEnd( ResKind( _kind ), _name ) )
+      {
+	PoolItem pi( *it );
+	if ( pi->edition().asString() != _edition
+	  || pi->arch().asString() != _arch
+	  || pi->repository().alias() != _repo )
+	  continue;
+	if ( _checksum != "-" && fromPoolItem( pi )._checksum != _checksum )
+	  continue;
+	return pi;
+      }
+      return PoolItem();
+    }
+  };
+
+  /** \relates PlanStep Stream output (the plans file format) */
+  inline std::ostream & operator<<( std::ostream & str, const PlanStep & obj )
+  {
+    return str << obj._action << ' ' << causerName( obj._causer ) << ' ' << obj._kind << ' ' << obj._name << ' ' << obj._edition
+               << ' ' << obj._arch << ' ' << obj._repo << ' ' << obj._checksum;
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class Plan
+  /// \brief A parsed plan file.
+  ///////////////////////////////////////////////////////////////////
+  struct Plan
+  {
+    /** Parse \a file_r; \c false if it is not readable or malformed. */
+    bool read( const Pathname & file_r )
+    {
+      std::ifstream str( file_r.c_str() );
+      if ( ! str )
+	return false;
+
+      std::string line;
+      unsigned lineno = 0;
+      while ( std::getline( str, line ) )
+      {
+	++lineno;
+	line = str::trim( line );
+	if ( line.empty() || line[0] == '#' )
+	  continue;
+
+	std::istringstream words( line );
+	std::string tag;
+	words >> tag;
+	bool ok = false;
+	if ( tag == "rpmdb" )
+	  ok = bool( words >> _rpmdb );
+	else if ( tag == "repo" )
+	{
+	  std::string alias;
+	  std::string cookie;
+	  if ( ( ok = bool( words >> alias >> cookie ) ) )
+	    _repos[alias] = cookie;
+	}
+	else if ( tag == "step" )
+	{
+	  PlanStep step;
+	  std::string causer;
+	  if ( ( ok = bool( words >> step._action >> causer >> step._kind >> step._name >> step._edition
+	                          >> step._arch >> step._repo >> step._checksum )
+	           && validAction( step._action )
+	           && causerValue( causer, step._causer ) ) )
+	    _steps.push_back( std::move(step) );
+	}
+	if ( ! ok )
+	{
+	  ERR << file_r << ":" << lineno << ": malformed line '" << line << "'" << endl;
+	  return false;
+	}
+      }
+      return ! _rpmdb.empty();
+    }
+
+    std::string _rpmdb;
+    RepoCookies _repos;
+    std::vector<PlanStep> _steps;
+  };
+
+} // namespace
+///////////////////////////////////////////////////////////////////
+
+bool write_transaction_plan( Zypper & zypper, const Pathname & file_r )
+{
+  std::ofstream str( file_r.c_str() );
+  if ( ! str )
+  {
+    zypper.out().error( boost::format(_("Cannot write transaction plan '%s'.")) % file_r );
+    return false;
+  }
+
+  str << "# zypper transaction plan" << endl;
+  str << "rpmdb " << rpmdbCookie() << endl;
+  for ( const auto & repo : repoCookies( zypper ) )
+    str << "repo " << repo.first << ' ' << repo.second << endl;
+
+  unsigned steps = 0;
+  for_( it, God->pool().begin(), God->pool().end() )
+  {
+    if ( ! it->status().transacts() )
+      continue;
+    str << "step " << PlanStep::fromPoolItem( *it ) << endl;
+    ++steps;
+  }
+
+  if ( ! str )
+  {
+    zypper.out().error( boost::format(_("Cannot write transaction plan '%s'.")) % file_r );
+    return false;
+  }
+  MIL << "Wrote plan with " << steps << " steps to " << file_r << endl;
+  zypper.out().info( boost::format(_("Transaction plan written to '%s'.")) % file_r, Out::HIGH );
+  return true;
+}
+
+bool apply_transaction_plan( Zypper & zypper, const Pathname & file_r )
+{
+  Plan plan;
+  if ( ! plan.read( file_r ) )
+  {
+    zypper.out().warning( boost::format(_("Cannot read transaction plan '%s'.")) % file_r );
+    return false;
+  }
+
+  if ( plan._rpmdb != rpmdbCookie() )
+  {
+    MIL << "Plan rejected: rpmdb differs" << endl;
+    return false;
+  }
+  if ( plan._repos != repoCookies( zypper ) )
+  {
+    MIL << "Plan rejected: repos differ" << endl;
+    return false;
+  }
+
+  // Map all steps before touching the pool.
+  std::vector<PoolItem> items;
+  items.reserve( plan._steps.size() );
+  for ( const auto & step : plan._steps )
+  {
+    PoolItem pi( step.lookup() );
+    if ( ! pi )
+    {
+      MIL << "Plan rejected: no match for step " << step << endl;
+      return false;
+    }
+    items.push_back( pi );
+  }
+
+  for_( it, God->pool().begin(), God->pool().end() )
+    it->status().resetTransact( ResStatus::USER );
+
+  for ( unsigned i = 0; i < items.size(); ++i )
+  {
+    ResStatus & status( items[i].status() );
+    const PlanStep & step( plan._steps[i] );
+    bool ok;
+    if ( step._action == "replace" )
+      ok = status.setToBeUninstalledDueToUpgrade( step._causer );
+    else if ( step._action == "remove" )
+      ok = status.setToBeUninstalled( step._causer );
+    else
+      ok = status.setToBeInstalled( step._causer );
+
+    if ( ! ok )
+    {
+      ERR << "Plan rejected: cannot set up step " << step << " for " << items[i] << endl;
+      zypper.out().warning( boost::format(_("Cannot apply step '%s' of transaction plan '%s'.")) % step % file_r );
+      // drop the partial setup
+      for_( it, God->pool().begin(), God->pool().end() )
+	it->status().resetTransact( ResStatus::USER );
+      return false;
+    }
+  }
+  MIL << "Applied plan with " << items.size() << " steps from " << file_r << endl;
+  return true;
+}
+
+bool apply_transaction_plan_if_requested( Zypper & zypper )
+{
+  parsed_opts::const_iterator it( zypper.cOpts().find( "plan-in" ) );
+  if ( it == zypper.cOpts().end() )
+    return false;
+
+  Pathname file( it->second.back() );
+  if ( apply_transaction_plan( zypper, file ) )
+  {
+    zypper.out().info( boost::format(_("Using transaction plan '%s'.")) % file );
+    zypper.runtimeData().solve_before_commit = false;
+    return true;
+  }
+
+  zypper.out().info( boost::format(_("Transaction plan '%s' does not match this system. Resolving package dependencies instead.")) % file );
+  return false;
+}
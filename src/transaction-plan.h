@@ -0,0 +1,54 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/**
+ * Transaction plans (--plan-out/--plan-in).
+ *
+ * A plan is the resolved transaction (exact NEVRA, repo and checksum per
+ * step) together with the cookies of the rpmdb and the repositories it was
+ * computed from. A plan computed on one host can be committed on any other
+ * host in the very same state, without running the solver there.
+ *
+ * File format (one record per line, '#' starts a comment):
+ * \code
+ * rpmdb <cookie>
+ * repo <alias> <cookie>
+ * step <install|remove|replace> <causer> <kind> <name> <edition> <arch> <repo> <checksum|->
+ * \endcode
+ * where \c causer is the ResStatus::TransactByValue of the step (\c solver,
+ * \c appl_low, \c appl_high or \c user).
+ */
+#ifndef ZYPPER_TRANSACTION_PLAN_H
+#define ZYPPER_TRANSACTION_PLAN_H
+
+#include "zypp/Pathname.h"
+
+class Zypper;
+
+/** Write the transaction currently set up in the pool to \a file_r.
+ * \returns whether the plan was written.
+ */
+bool write_transaction_plan( Zypper & zypper, const zypp::Pathname & file_r );
+
+/** Set up the pool according to the plan stored in \a file_r.
+ *
+ * The plan is applied only if the rpmdb and repository cookies match and
+ * every step can be mapped to a solvable in the pool; otherwise the pool
+ * is left untouched.
+ *
+ * \returns whether the plan was applied.
+ */
+bool apply_transaction_plan( Zypper & zypper, const zypp::Pathname & file_r );
+
+/** If \c --plan-in was given, try to apply the plan. On success the solver
+ * run in \ref solve_and_commit is disabled and \c true is returned. If the
+ * plan does not match this system, the user is told that dependencies are
+ * resolved as usual and \c false is returned.
+ */
+bool apply_transaction_plan_if_requested( Zypper & zypper );
+
+#endif // ZYPPER_TRANSACTION_PLAN_H
@@ -1,18 +1,25 @@
 #include <iostream> // for xml and table output
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <tuple>
 #include <boost/format.hpp>
 
 #include <zypp/base/Logger.h>
 #include <zypp/ZYppFactory.h>
 #include <zypp/base/Algorithm.h>
 #include <zypp/PoolQuery.h>
+#include <zypp/sat/LookupAttr.h>
 
 #include <zypp/Patch.h>
 
 #include "SolverRequester.h"
 #include "Table.h"
 #include "update.h"
+#include "utils/multimatch.h"
+#include "patch-status.h"
 #include "main.h"
+#include "output/OutJSON.h"
 
 using namespace std;
 using namespace zypp;
@@ -43,28 +50,13 @@ find_updates( const ResKindSet & kinds, Candidates & candidates );
 // update summary must correspond to list-updates and patch-check
 // ----------------------------------------------------------------------------
 
-void patch_check ()
+void patch_check( const PatchStatus & status_r )
 {
   Out & out = Zypper::instance()->out();
   RuntimeData & gData = Zypper::instance()->runtimeData();
   DBG << "patch check" << endl;
-  gData.patches_count = gData.security_patches_count = 0;
-
-  ResPool::byKind_iterator
-    it = God->pool().byKindBegin(ResKind::patch),
-    e = God->pool().byKindEnd(ResKind::patch);
-  for (; it != e; ++it )
-  {
-    ResObject::constPtr res = it->resolvable();
-    Patch::constPtr patch = asKind<Patch>(res);
-
-    if (it->isRelevant() && !it->isSatisfied())
-    {
-      gData.patches_count++;
-      if (patch->categoryEnum() == Patch::CAT_SECURITY)
-        gData.security_patches_count++;
-    }
-  }
+  gData.patches_count = status_r._needed;
+  gData.security_patches_count = status_r._security;
 
   ostringstream s;
   // translators: %d is the number of needed patches
@@ -76,6 +68,23 @@ void patch_check ()
       % gData.security_patches_count
     << ")";
   out.info(s.str(), Out::QUIET);
+
+  if (status_r._needed)
+  {
+    ostringstream b;
+    // translators: followed by a list of patch categories with the number of needed patches
+    b << _("Needed patches by category:");
+    for (const auto & cat : status_r._categories)
+      b << ' ' << cat.first << '=' << cat.second;
+    out.info(b.str(), Out::HIGH);
+
+    ostringstream v;
+    // translators: followed by a list of patch severities with the number of needed patches
+    v << _("Needed patches by severity:");
+    for (const auto & sev : status_r._severities)
+      v << ' ' << sev.first << '=' << sev.second;
+    out.info(v.str(), Out::HIGH);
+  }
 }
 
 // ----------------------------------------------------------------------------
@@ -96,7 +105,7 @@ inline const char *const patchStatusAsString( const PoolItem & pi_r )
 }
 
 // returns true if restartSuggested() patches are availble
-static bool xml_list_patches (Zypper & zypper)
+static bool machine_list_patches (Zypper & zypper)
 {
   const zypp::ResPool& pool = God->pool();
 
@@ -130,6 +139,34 @@ static bool xml_list_patches (Zypper & zypper)
       // if updates stack patches are available, show only those
       if ((pkg_mgr_available && patch->restartSuggested()) || !pkg_mgr_available)
       {
+        Patch::InteractiveFlags ignoreFlags = Patch::NoFlags;
+        if (zypper.globalOpts().reboot_req_non_interactive)
+          ignoreFlags |= Patch::Reboot;
+	if ( zypper.cOpts().count("auto-agree-with-licenses") || zypper.cOpts().count("agree-to-third-party-licenses") )
+	  ignoreFlags |= Patch::License;
+
+        if (zypper.out().typeJSON())
+        {
+          jsonout::Record rec("update");
+          rec("kind", "patch")
+             ("name", res->name())
+             ("edition", res->edition().asString())
+             ("arch", res->arch().asString())
+             ("status", patchStatusAsString( *it ))
+             ("category", patch->category())
+             ("severity", patch->severity())
+             ("pkgmanager", patch->restartSuggested())
+             ("restart", patch->rebootSuggested())
+             ("interactive", patch->interactiveWhenIgnoring(ignoreFlags))
+             ("summary", patch->summary())
+             ("description", patch->description())
+             ("license", patch->licenseToConfirm());
+          if ( !patch->repoInfo().alias().empty() )
+            rec("source-url", patch->repoInfo().url().asString())
+               ("source-alias", patch->repoInfo().alias());
+          continue;
+        }
+
         cout << " <update ";
         cout << "name=\"" << res->name () << "\" ";
         cout << "edition=\""  << res->edition ().asString() << "\" ";
@@ -139,13 +176,6 @@ static bool xml_list_patches (Zypper & zypper)
         cout << "severity=\"" <<  patch->severity() << "\" ";
         cout << "pkgmanager=\"" << (patch->restartSuggested() ? "true" : "false") << "\" ";
         cout << "restart=\"" << (patch->rebootSuggested() ? "true" : "false") << "\" ";
-
-        Patch::InteractiveFlags ignoreFlags = Patch::NoFlags;
-        if (zypper.globalOpts().reboot_req_non_interactive)
-          ignoreFlags |= Patch::Reboot;
-	if ( zypper.cOpts().count("auto-agree-with-licenses") || zypper.cOpts().count("agree-to-third-party-licenses") )
-	  ignoreFlags |= Patch::License;
-
         cout << "interactive=\"" << (patch->interactiveWhenIgnoring(ignoreFlags) ? "true" : "false") << "\" ";
         cout << "kind=\"patch\"";
         cout << ">" << endl;
@@ -166,14 +196,19 @@ static bool xml_list_patches (Zypper & zypper)
 
   //! \todo change this from appletinfo to something general, define in xmlout.rnc
   if (patchcount == 0)
-    cout << "<appletinfo status=\"no-update-repositories\"/>" << endl;
+  {
+    if (zypper.out().typeJSON())
+      jsonout::Record("appletinfo")("status", "no-update-repositories");
+    else
+      cout << "<appletinfo status=\"no-update-repositories\"/>" << endl;
+  }
 
   return pkg_mgr_available;
 }
 
 // ----------------------------------------------------------------------------
 
-static void xml_list_updates(const ResKindSet & kinds)
+static void machine_list_updates(const ResKindSet & kinds)
 {
   Candidates candidates;
   find_updates (kinds, candidates);
@@ -182,6 +217,22 @@ static void xml_list_updates(const ResKindSet & kinds)
   for (ci = cb; ci != ce; ++ci) {
     ResObject::constPtr res = ci->resolvable();
 
+    if (Zypper::instance()->out().typeJSON())
+    {
+      jsonout::Record rec("update");
+      rec("kind", res->kind().asString())
+         ("name", res->name())
+         ("edition", res->edition().asString())
+         ("arch", res->arch().asString())
+         ("summary", res->summary())
+         ("description", res->description())
+         ("license", res->licenseToConfirm());
+      if ( !res->repoInfo().alias().empty() )
+        rec("source-url", res->repoInfo().url().asString())
+           ("source-alias", res->repoInfo().alias());
+      continue;
+    }
+
     cout << " <update ";
     cout << "name=\"" << res->name () << "\" " ;
     cout << "edition=\""  << res->edition ().asString() << "\" ";
@@ -204,7 +255,13 @@ static void xml_list_updates(const ResKindSet & kinds)
 
 // ----------------------------------------------------------------------------
 
-static bool list_patch_updates(Zypper & zypper)
+/**
+ * List the needed patches as tables, or with \a qformat if given. Either
+ * way the patches affecting the package manager come first.
+ *
+ * \return whether some patch affects the package manager
+ */
+static bool list_patch_updates(Zypper & zypper, const SolvableFormat * qformat = nullptr)
 {
   bool all = zypper.cOpts().count("all");
   // if --date is specified
@@ -249,20 +306,8 @@ static bool list_patch_updates(Zypper & zypper)
     }
   }
 
-  Table tbl;
-  if (!Zypper::instance()->globalOpts().no_abbrev)
-    tbl.allowAbbrev(5);
-  Table pm_tbl; // only those that affect packagemanager (restartSuggested()), they have priority
-  if (!Zypper::instance()->globalOpts().no_abbrev)
-    pm_tbl.allowAbbrev(5);
-  TableHeader th;
-  unsigned cols;
-
-  th << _("Repository")
-     << _("Name") << _("Category") << _("Severity") << _("Status") << _("Summary");
-  cols = 6;
-  tbl << th;
-  pm_tbl << th;
+  std::vector<PoolItem> items;
+  std::vector<PoolItem> pm_items; // only those that affect packagemanager (restartSuggested()), they have priority
   const zypp::ResPool& pool = God->pool();
   ResPool::byKind_iterator
     it = pool.byKindBegin(ResKind::patch),
@@ -286,21 +331,58 @@ static bool list_patch_updates(Zypper & zypper)
         continue;
       }
 
-      // table
-      {
-        TableRow tr (cols);
-        tr << patch->repoInfo().asUserString();
-        tr << res->name ();
-        tr << patch->category();
-        tr << patch->severity();
-        tr << (it->isBroken() ? _("needed") : _("not needed"));
-        tr << patch->summary();
-
-        if (!all && patch->restartSuggested ())
-          pm_tbl << tr;
-        else
-          tbl << tr;
-      }
+      if (!all && patch->restartSuggested ())
+        pm_items.push_back(*it);
+      else
+        items.push_back(*it);
+    }
+  }
+
+  if (qformat)
+  {
+    // same order as the tables below: by name, package manager ones first
+    auto byName = []( const PoolItem & lhs, const PoolItem & rhs )
+    { return lhs->name() < rhs->name(); };
+    std::stable_sort(pm_items.begin(), pm_items.end(), byName);
+    std::stable_sort(items.begin(), items.end(), byName);
+    for_(pit, pm_items.begin(), pm_items.end())
+      qformat->print(cout, *pit, "v");
+    for_(pit, items.begin(), items.end())
+      qformat->print(cout, *pit, "v");
+    return !pm_items.empty();
+  }
+
+  Table tbl;
+  if (!Zypper::instance()->globalOpts().no_abbrev)
+    tbl.allowAbbrev(5);
+  Table pm_tbl;
+  if (!Zypper::instance()->globalOpts().no_abbrev)
+    pm_tbl.allowAbbrev(5);
+  TableHeader th;
+  unsigned cols;
+
+  th << _("Repository")
+     << _("Name") << _("Category") << _("Severity") << _("Status") << _("Summary");
+  cols = 6;
+  tbl << th;
+  pm_tbl << th;
+  for (const std::vector<PoolItem> * list : { &pm_items, &items })
+  {
+    for_(pit, list->begin(), list->end())
+    {
+      Patch::constPtr patch = asKind<Patch>(pit->resolvable());
+      TableRow tr (cols);
+      tr << patch->repoInfo().asUserString();
+      tr << patch->name ();
+      tr << patch->category();
+      tr << patch->severity();
+      tr << (pit->isBroken() ? _("needed") : _("not needed"));
+      tr << patch->summary();
+
+      if (list == &pm_items)
+        pm_tbl << tr;
+      else
+        tbl << tr;
     }
   }
 
@@ -427,8 +509,27 @@ string i18n_kind_updates(const ResKind & kind)
 
 // FIXME rewrite this function so that first the list of updates is collected and later correctly presented (bnc #523573)
 
-void list_updates(Zypper & zypper, const ResKindSet & kinds, bool best_effort)
+void list_updates(Zypper & zypper, const ResKindSet & kinds, bool best_effort, const SolvableFormat * qformat)
 {
+  // --format: the same selection as the tables, in place of the tables
+  // and the machine output
+  if (qformat)
+  {
+    // patches affecting the package manager suppress the other kinds
+    if (kinds.count(ResKind::patch) && list_patch_updates(zypper, qformat))
+      return;
+    for_(kit, kinds.begin(), kinds.end())
+    {
+      if (*kit == ResKind::patch)
+        continue;
+      Candidates candidates;
+      find_updates(*kit, candidates);
+      for_(ci, candidates.begin(), candidates.end())
+        qformat->print(cout, *ci, "v");
+    }
+    return;
+  }
+
   if (zypper.out().type() == Out::TYPE_XML)
   {
     cout << "<update-status version=\"0.6\">" << endl;
@@ -449,8 +550,8 @@ void list_updates(Zypper & zypper, const ResKindSet & kinds, bool best_effort)
   it = localkinds.find(ResKind::patch);
   if(it != localkinds.end())
   {
-    if (zypper.out().type() == Out::TYPE_XML)
-      affects_pkgmgr = xml_list_patches(zypper);
+    if (!zypper.out().typeNORMAL())
+      affects_pkgmgr = machine_list_patches(zypper);
     else
     {
       if (kinds.size() > 1)
@@ -465,13 +566,16 @@ void list_updates(Zypper & zypper, const ResKindSet & kinds, bool best_effort)
 
   // list other kinds (only if there are no _patches_ affecting the package manager)
 
-  // XML output here
-  if (zypper.out().type() == Out::TYPE_XML)
+  // XML and JSON output here
+  if (!zypper.out().typeNORMAL())
   {
     if (!affects_pkgmgr)
-      xml_list_updates(localkinds);
-    cout << "</update-list>" << endl;
-    cout << "</update-status>" << endl;
+      machine_list_updates(localkinds);
+    if (zypper.out().type() == Out::TYPE_XML)
+    {
+      cout << "</update-list>" << endl;
+      cout << "</update-status>" << endl;
+    }
     return;
   }
 
@@ -563,6 +667,22 @@ void list_updates(Zypper & zypper, const ResKindSet & kinds, bool best_effort)
 
 // ----------------------------------------------------------------------------
 
+bool read_issue_numbers(const string & file_r, list<string> & cves_r, list<string> & bugs_r)
+{
+  list<string> numbers;
+  if (!read_list_file(file_r, numbers))
+    return false;
+
+  for_(it, numbers.begin(), numbers.end())
+  {
+    if (str::toLower(it->substr(0, 4)) == "cve-")
+      cves_r.push_back(*it);
+    else
+      bugs_r.push_back(*it);
+  }
+  return true;
+}
+
 void list_patches_by_issue(Zypper & zypper)
 {
   // lp --issues               - list all issues which need to be fixed
@@ -619,68 +739,82 @@ void list_patches_by_issue(Zypper & zypper)
         ++i;
     }
 
-  // construct a PoolQuery for each argument separately and add the results
-  // to the Table.
+  // Compile all issue numbers into one matcher and look at the references
+  // of each patch just once. The rows are ordered as if the issues were
+  // queried one after another.
+  vector<string> patterns;
+  vector<string> ptypes;	// "issues" matches any reference type
   string issuesstr;
   for_(issue, issues.begin(), issues.end())
   {
     DBG << "querying: " << issue->first << " = " << issue->second << endl;
-    PoolQuery q;
-    q.setMatchSubstring();
-    q.setCaseSensitive(false);
-    q.addKind(ResKind::patch); // is this unnecessary? only patches should have updateReference* attributes
-
-    // specific bugzilla or CVE
-    if (specific)
-    {
-      if (issue->first == "bugzilla" || issue->first == "cve")
-        q.addAttribute(sat::SolvAttr::updateReferenceId, issue->second);
-    }
-    // all bugzillas or CVEs
-    else
-    {
-      if (issue->first == "bugzilla")
-        q.addAttribute(sat::SolvAttr::updateReferenceType, "bugzilla");
-      else if (issue->first == "cve")
-        q.addAttribute(sat::SolvAttr::updateReferenceType, "cve");
-    }
-    // look for substring in description and reference ID (issue number)
+    // without specific numbers the empty pattern matches all references
+    patterns.push_back(specific ? issue->second : string());
+    ptypes.push_back(issue->first);
+    // look for substring in description, too
     if (issue->first == "issues")
-    {
-      // whether argument was given or not, it does not matter; without
-      // argument, all issues will be found
-      q.addAttribute(sat::SolvAttr::updateReferenceId, issue->second);
       issuesstr = issue->second;
-    }
+  }
+  SubstringMatcher matcher(patterns);
 
-    for_(it, q.begin(), q.end())
+  // (query index, reference type, reference id, patch)
+  typedef std::tuple<unsigned, string, string, PoolItem> IssueMatch;
+  vector<IssueMatch> matches;
+  vector<unsigned> hits;
+  for_(it, God->pool().byKindBegin(ResKind::patch), God->pool().byKindEnd(ResKind::patch))
+  {
+    const PoolItem & pi(*it);
+    if (only_needed && (!pi.isBroken() || pi.isUnwanted()))
+      continue;
+
+    sat::LookupAttr refs(sat::SolvAttr::updateReference, pi.satSolvable());
+    for_(ref, refs.begin(), refs.end())
     {
-      PoolItem pi(*it);
-      if (only_needed && (!pi.isBroken() || pi.isUnwanted()))
+      string id = ref.subFind(sat::SolvAttr::updateReferenceId).asString();
+      matcher.match(id, hits);
+      if (hits.empty())
         continue;
 
-      Patch::constPtr patch = asKind<Patch>(pi.resolvable());
-      DBG << "got: " << patch << endl;
-
-      // Print details about each match in that solvable:
-      for_( d, it.matchesBegin(), it.matchesEnd() )
+      string itype = ref.subFind(sat::SolvAttr::updateReferenceType).asString();
+      for (unsigned idx : hits)
       {
-        string itype =
-          d->subFind(sat::SolvAttr::updateReferenceType).asString();
-        if (issue->first != "issues" && itype != issue->first)
+        if (ptypes[idx] != "issues" && ptypes[idx] != itype)
           continue;
-
-        TableRow tr;
-        tr << itype;
-        tr << d->subFind(sat::SolvAttr::updateReferenceId).asString();
-        tr << patch->name();
-        tr << patch->category();
-        tr << patch->severity();
-        tr << (pi.isBroken() ? _("needed") : _("not needed"));
-        t << tr;
+        DBG << "got: " << pi << endl;
+        matches.push_back(IssueMatch(idx, itype, id, pi));
       }
     }
   }
+  stable_sort(matches.begin(), matches.end(),
+              [](const IssueMatch & lhs, const IssueMatch & rhs)
+              { return std::get<0>(lhs) < std::get<0>(rhs); });
+
+  bool json = zypper.out().typeJSON();
+  for (const auto & match : matches)
+  {
+    const PoolItem & pi(std::get<3>(match));
+    Patch::constPtr patch = asKind<Patch>(pi.resolvable());
+    if (json)
+    {
+      jsonout::Record("issue")
+        ("issue-type", std::get<1>(match))
+        ("issue-id", std::get<2>(match))
+        ("patch", patch->name())
+        ("edition", patch->edition().asString())
+        ("category", patch->category())
+        ("severity", patch->severity())
+        ("needed", pi.isBroken());
+      continue;
+    }
+    TableRow tr;
+    tr << std::get<1>(match);
+    tr << std::get<2>(match);
+    tr << patch->name();
+    tr << patch->category();
+    tr << patch->severity();
+    tr << (pi.isBroken() ? _("needed") : _("not needed"));
+    t << std::move(tr);
+  }
 
   // look for matches in patch descriptions
   Table t1;
@@ -703,6 +837,18 @@ void list_patches_by_issue(Zypper & zypper)
         continue;
       Patch::constPtr patch = asKind<Patch>(pi.resolvable());
 
+      if (json)
+      {
+        jsonout::Record("patch-match")
+          ("patch", patch->name())
+          ("edition", patch->edition().asString())
+          ("category", patch->category())
+          ("severity", patch->severity())
+          ("needed", pi.isBroken())
+          ("summary", patch->summary());
+        continue;
+      }
+
       TableRow tr;
       tr << patch->name() << patch->category() << patch->severity();
       //! \todo could show a highlighted match with a portion of surrounding
@@ -712,6 +858,9 @@ void list_patches_by_issue(Zypper & zypper)
     }
   }
 
+  if (json)
+    return;
+
   if (!zypper.globalOpts().no_abbrev)
     t1.allowAbbrev(3);
   t.sort(3);
@@ -4,10 +4,14 @@
 
 #include "utils/misc.h"
 
+struct PatchStatus;
+class SolvableFormat;
+
 /**
- * Are there applicable patches?
+ * Are there applicable patches? Prints the counts of \a status_r and
+ * sets the counters in \ref RuntimeData accordingly.
  */
-void patch_check();
+void patch_check( const PatchStatus & status_r );
 
 /**
  * Lists available updates of installed resolvables of specified \a kind.
@@ -17,10 +21,23 @@ void patch_check();
  *
  * \param kind  resolvable type
  * \param best_effort
+ * \param qformat  print each update using this template (\c --format)
  */
 void list_updates(Zypper & zypper,
                   const ResKindSet & kinds,
-                  bool best_effort);
+                  bool best_effort,
+                  const SolvableFormat * qformat = nullptr);
+
+/**
+ * Read issue numbers from \a file_r ('-' for stdin), one per line. Numbers
+ * starting with 'CVE-' are added to \a cves_r, the others to \a bugs_r.
+ * Empty lines and lines starting with '#' are ignored.
+ *
+ * \return false if the file could not be read
+ */
+bool read_issue_numbers(const std::string & file_r,
+                        std::list<std::string> & cves_r,
+                        std::list<std::string> & bugs_r);
 
 /**
  * List available fixes to all issues or issues specified in --bugzilla
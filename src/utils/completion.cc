@@ -0,0 +1,221 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <sstream>
+
+#include "utils/completion.h"
+
+namespace
+{
+  const char * magic = "zypper-completion\t1";
+
+  std::vector<std::string> split( const std::string & str_r, char sep_r )
+  {
+    std::vector<std::string> ret;
+    std::string::size_type pos = 0;
+    while ( pos <= str_r.size() )
+    {
+      std::string::size_type end = str_r.find( sep_r, pos );
+      if ( end == std::string::npos )
+	end = str_r.size();
+      if ( end > pos )
+	ret.push_back( str_r.substr( pos, end - pos ) );
+      pos = end + 1;
+    }
+    return ret;
+  }
+
+  std::string join( const std::vector<std::string> & words_r )
+  {
+    std::string ret;
+    for ( const std::string & word : words_r )
+    {
+      if ( ! ret.empty() )
+	ret += ' ';
+      ret += word;
+    }
+    return ret;
+  }
+
+  inline bool startsWith( const std::string & str_r, const std::string & prefix_r )
+  { return str_r.compare( 0, prefix_r.size(), prefix_r ) == 0; }
+
+  inline bool contains( const std::vector<std::string> & words_r, const std::string & word_r )
+  { return std::find( words_r.begin(), words_r.end(), word_r ) != words_r.end(); }
+
+  /** Add the \a words_r starting with \a prefix_r to \a result_r (without
+   * the \c '=' marking options with argument).
+   */
+  void addMatching( std::vector<std::string> & result_r, const std::vector<std::string> & words_r, const std::string & prefix_r )
+  {
+    for ( const std::string & word : words_r )
+    {
+      if ( startsWith( word, prefix_r ) )
+	result_r.push_back( word.back() == '=' ? word.substr( 0, word.size() - 1 ) : word );
+    }
+  }
+
+  /** Like \ref addMatching for the space separated \a names_r. */
+  void addMatchingNames( std::vector<std::string> & result_r, const std::string & names_r, const std::string & prefix_r )
+  {
+    std::string::size_type pos = 0;
+    while ( pos < names_r.size() )
+    {
+      std::string::size_type end = names_r.find( ' ', pos );
+      if ( end == std::string::npos )
+	end = names_r.size();
+      if ( end - pos >= prefix_r.size() && names_r.compare( pos, prefix_r.size(), prefix_r ) == 0 )
+	result_r.push_back( names_r.substr( pos, end - pos ) );
+      pos = end + 1;
+    }
+  }
+}
+
+bool CompletionIndex::parse( const std::string & data_r )
+{
+  *this = CompletionIndex();
+  std::istringstream str( data_r );
+  std::string line;
+  if ( ! std::getline( str, line ) || line != magic )
+    return false;
+
+  while ( std::getline( str, line ) )
+  {
+    std::string::size_type tab = line.find( '\t' );
+    if ( tab == std::string::npos )
+      continue;
+    std::string tag( line.substr( 0, tab ) );
+    std::string value( line.substr( tab + 1 ) );
+    if ( tag == "global" )
+      global_options = split( value, ' ' );
+    else if ( tag == "command" )
+    {
+      std::string::size_type sep = value.find( '\t' );
+      Command command;
+      command.names = split( value.substr( 0, sep ), ' ' );
+      if ( sep != std::string::npos )
+	command.options = split( value.substr( sep + 1 ), ' ' );
+      if ( ! command.names.empty() )
+	commands.push_back( command );
+    }
+    else if ( tag == "repo" )
+      repos.push_back( value );
+    else if ( tag == "service" )
+      services.push_back( value );
+    else if ( tag == "packages" )
+    {
+      std::string::size_type sep = value.find( '\t' );
+      if ( sep != std::string::npos )
+	packages[value.substr( 0, sep )] = value.substr( sep + 1 );
+    }
+  }
+  return true;
+}
+
+std::string CompletionIndex::asString() const
+{
+  std::ostringstream str;
+  str << magic << '\n';
+  str << "global\t" << join( global_options ) << '\n';
+  for ( const Command & command : commands )
+    str << "command\t" << join( command.names ) << '\t' << join( command.options ) << '\n';
+  for ( const std::string & repo : repos )
+    str << "repo\t" << repo << '\n';
+  for ( const std::string & service : services )
+    str << "service\t" << service << '\n';
+  for ( const auto & names : packages )
+    str << "packages\t" << names.first << '\t' << names.second << '\n';
+  return str.str();
+}
+
+std::vector<std::string> CompletionIndex::complete( const std::vector<std::string> & words_r ) const
+{
+  std::vector<std::string> ret;
+  if ( words_r.empty() )
+    return ret;
+  const std::string & cur( words_r.back() );
+
+  // find the command and whether the current word is an option argument
+  const Command * command = nullptr;
+  std::string argOf;	// option the current word is the argument of
+  for ( unsigned i = 0; i + 1 < words_r.size(); ++i )
+  {
+    const std::string & word( words_r[i] );
+    if ( ! argOf.empty() )
+    {
+      argOf.clear();
+      continue;
+    }
+    if ( word.size() > 1 && word[0] == '-' )
+    {
+      if ( ( command && contains( command->options, word + "=" ) ) || contains( global_options, word + "=" ) )
+	argOf = word;
+      continue;
+    }
+    if ( command )
+      continue;	// an argument
+    for ( const Command & cmd : commands )
+    {
+      if ( contains( cmd.names, word ) )
+      {
+	command = &cmd;
+	break;
+      }
+    }
+    if ( ! command )
+      return ret;	// unknown command
+  }
+
+  if ( ! argOf.empty() )
+  {
+    if ( argOf == "--repo" || argOf == "-r" || argOf == "--from" || argOf == "--catalog" )
+      addMatching( ret, repos, cur );
+    else if ( argOf == "--type" || argOf == "-t" )
+      addMatching( ret, { "package", "patch", "pattern", "product", "srcpackage" }, cur );
+  }
+  else if ( ! cur.empty() && cur[0] == '-' )
+    addMatching( ret, command ? command->options : global_options, cur );
+  else if ( ! command )
+  {
+    for ( const Command & cmd : commands )
+      addMatching( ret, cmd.names, cur );
+  }
+  else
+  {
+    const std::string & name( command->names.front() );
+    if ( name == "help" )
+    {
+      for ( const Command & cmd : commands )
+	addMatching( ret, cmd.names, cur );
+    }
+    else if ( name == "removerepo" || name == "modifyrepo" || name == "renamerepo" || name == "refresh" )
+      addMatching( ret, repos, cur );
+    else if ( name == "removeservice" || name == "modifyservice" || name == "refresh-services" )
+      addMatching( ret, services, cur );
+    else if ( name == "remove" || name == "update" )
+    {
+      auto it = packages.find( "@System" );
+      if ( it != packages.end() )
+	addMatchingNames( ret, it->second, cur );
+    }
+    else if ( name == "install" || name == "info" || name == "search" || name == "what-provides"
+           || name == "addlock" || name == "download" || name == "source-install" || name == "source-download" )
+    {
+      bool installed = ( name == "info" || name == "search" || name == "what-provides" || name == "addlock" );
+      for ( const auto & names : packages )
+      {
+	if ( installed || names.first != "@System" )
+	  addMatchingNames( ret, names.second, cur );
+      }
+    }
+  }
+
+  std::sort( ret.begin(), ret.end() );
+  ret.erase( std::unique( ret.begin(), ret.end() ), ret.end() );
+  return ret;
+}
@@ -0,0 +1,66 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_UTILS_COMPLETION_H
+#define ZYPPER_UTILS_COMPLETION_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////
+/// \class CompletionIndex
+/// \brief What the shell completion needs to know, so completing a
+/// word needs neither the full zypper startup nor the pool.
+///
+/// Options taking an argument are stored with a trailing \c '='.
+///
+/// File format, one record per line, fields separated by tabs:
+/// \code
+/// zypper-completion	1
+/// global	<options>
+/// command	<names>	<options>
+/// repo	<alias>
+/// service	<alias>
+/// packages	<repo alias>	<package names>
+/// \endcode
+/// Names and options are separated by spaces, the primary name of a
+/// command comes first.
+/// \code
+///   CompletionIndex index;
+///   if ( index.parse( data ) )
+///     for ( const std::string & word : index.complete( { "in", "--fr" } ) )
+///       cout << word << endl;
+/// \endcode
+///////////////////////////////////////////////////////////////////
+struct CompletionIndex
+{
+  struct Command
+  {
+    std::vector<std::string> names;
+    std::vector<std::string> options;
+  };
+
+  /** Read the index from \a data_r; \c false if it is no index. */
+  bool parse( const std::string & data_r );
+
+  /** The index in file format. */
+  std::string asString() const;
+
+  /** Sorted candidates for the last word in \a words_r, which are the
+   * words of the command line after \c zypper up to the one completed.
+   */
+  std::vector<std::string> complete( const std::vector<std::string> & words_r ) const;
+
+  std::vector<std::string> global_options;
+  std::vector<Command> commands;
+  std::vector<std::string> repos;
+  std::vector<std::string> services;
+  std::map<std::string,std::string> packages;	//< repo alias: names
+};
+
+#endif // ZYPPER_UTILS_COMPLETION_H
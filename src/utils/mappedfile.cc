@@ -0,0 +1,40 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "utils/mappedfile.h"
+
+MappedFile::MappedFile( const std::string & path_r )
+  : _data( nullptr )
+  , _size( 0 )
+{
+  int fd = ::open( path_r.c_str(), O_RDONLY | O_CLOEXEC );
+  if ( fd == -1 )
+    return;
+
+  struct stat st;
+  if ( ::fstat( fd, &st ) == 0 && st.st_size > 0 )
+  {
+    void * addr = ::mmap( nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    if ( addr != MAP_FAILED )
+    {
+      _data = static_cast<const char *>( addr );
+      _size = st.st_size;
+    }
+  }
+  ::close( fd );	// the mapping stays
+}
+
+MappedFile::~MappedFile()
+{
+  if ( _data )
+    ::munmap( const_cast<char *>( _data ), _size );
+}
@@ -0,0 +1,53 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_UTILS_MAPPEDFILE_H
+#define ZYPPER_UTILS_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+///////////////////////////////////////////////////////////////////
+/// \class MappedFile
+/// \brief A file mapped read-only into memory, unmapped on destruction.
+///
+/// Pages are read on first access only, so looking up a few entries of a
+/// big sorted table costs no more than the pages the lookup touches.
+/// \code
+///   MappedFile file( "/var/cache/zypp/solv/repo/index" );
+///   if ( file.valid() )
+///     parse( file.data(), file.size() );
+/// \endcode
+///////////////////////////////////////////////////////////////////
+class MappedFile
+{
+public:
+  /** Map \a path_r; \ref valid tells whether this worked. Empty files
+   * can't be mapped.
+   */
+  explicit MappedFile( const std::string & path_r );
+
+  ~MappedFile();
+
+  MappedFile( const MappedFile & ) = delete;
+  MappedFile & operator=( const MappedFile & ) = delete;
+
+  bool valid() const
+  { return _data != nullptr; }
+
+  const char * data() const
+  { return _data; }
+
+  std::size_t size() const
+  { return _size; }
+
+private:
+  const char * _data;
+  std::size_t _size;
+};
+
+#endif // ZYPPER_UTILS_MAPPEDFILE_H
@@ -6,6 +6,7 @@
 \*---------------------------------------------------------------------------*/
 
 #include <sstream>
+#include <fstream>
 #include <iostream>
 #include <unistd.h>          // for getcwd()
 
@@ -16,6 +17,7 @@
 #include <zypp/media/MediaManager.h>
 #include <zypp/misc/CheckAccessDeleted.h>
 #include <zypp/ExternalProgram.h>
+#include <zypp/PathInfo.h>
 
 #include <zypp/PoolItem.h>
 #include <zypp/Product.h>
@@ -263,6 +265,29 @@ Url make_obs_url( const string & obsuri, const Url & base_url, const string & de
 
 // ----------------------------------------------------------------------------
 
+bool read_list_file(const string & file_r, list<string> & lines_r)
+{
+  ifstream file;
+  if (file_r != "-")
+  {
+    file.open(file_r.c_str());
+    if (!file)
+      return false;
+  }
+  istream & in(file_r == "-" ? cin : file);
+
+  string line;
+  while (getline(in, line))
+  {
+    line = str::trim(line);
+    if (!line.empty() && line[0] != '#')
+      lines_r.push_back(line);
+  }
+  return !in.bad();
+}
+
+// ----------------------------------------------------------------------------
+
 bool looks_like_rpm_file(const string & s)
 {
   // don't even bother to check strings shorter than 4 chars.
@@ -279,6 +304,13 @@ bool looks_like_rpm_file(const string & s)
 
 // ----------------------------------------------------------------------------
 
+/** Whether \a lhs and \a rhs have the same sha1sum (\c false if unreadable). */
+static bool sameContent(const Pathname & lhs, const Pathname & rhs)
+{
+  std::string sum(filesystem::sha1sum(lhs));
+  return !sum.empty() && sum == filesystem::sha1sum(rhs);
+}
+
 Pathname cache_rpm(const string & rpm_uri_str, const string & cache_dir)
 {
   Url rpmurl = make_url(rpm_uri_str);
@@ -296,8 +328,21 @@ Pathname cache_rpm(const string & rpm_uri_str, const string & cache_dir)
     Pathname localrpmpath = mm.localPath(mid, rpmpath.basename());
     Pathname cachedrpmpath = cache_dir;
     filesystem::assert_dir(cachedrpmpath);
-    bool error =
-      filesystem::copy(localrpmpath, cachedrpmpath / localrpmpath.basename());
+
+    // don't copy again if the cache already holds this very file: the
+    // same inode (hardlinked before) or the same content
+    bool error = false;
+    PathInfo src(localrpmpath);
+    PathInfo dst(cachedrpmpath / localrpmpath.basename());
+    if (dst.isFile() && dst.size() == src.size()
+        && ((dst.dev() == src.dev() && dst.ino() == src.ino())
+            || sameContent(src.path(), dst.path())))
+      DBG << "Reusing cached " << dst << endl;
+    else
+    {
+      filesystem::unlink(dst.path());
+      error = filesystem::hardlinkCopy(localrpmpath, dst.path());
+    }
 
     mm.release(mid);
     mm.close(mid);
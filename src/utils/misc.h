@@ -77,7 +77,8 @@ bool looks_like_rpm_file(const std::string & s);
 
 /**
  * Download the RPM file specified by \a rpm_uri_str and copy it into
- * \a cache_dir.
+ * \a cache_dir. A cached file of the same name is reused only if it has
+ * the same content (same inode or sha1sum).
  *
  * \return The local Pathname of the file in the cache on success, empty
  *      Pathname if a problem occurs.
@@ -85,6 +86,14 @@ bool looks_like_rpm_file(const std::string & s);
 zypp::Pathname cache_rpm(const std::string & rpm_uri_str,
                          const std::string & cache_dir);
 
+/**
+ * Read the lines of \a file_r ('-' for standard input) into \a lines_r,
+ * trimmed. Empty lines and lines starting with '#' are skipped.
+ *
+ * \return false if the file could not be read
+ */
+bool read_list_file(const std::string & file_r, std::list<std::string> & lines_r);
+
 std::string & indent(std::string & text, int columns);
 
 // comparator for RepoInfo set
@@ -0,0 +1,112 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <deque>
+
+#include "utils/multimatch.h"
+
+namespace
+{
+  inline unsigned char fold( unsigned char ch )
+  { return ( ch >= 'A' && ch <= 'Z' ) ? ch - 'A' + 'a' : ch; }
+
+  inline bool charLess( const std::pair<unsigned char,unsigned> & lhs, unsigned char rhs )
+  { return lhs.first < rhs; }
+
+  const unsigned noState = unsigned(-1);
+}
+
+SubstringMatcher::SubstringMatcher( const std::vector<std::string> & patterns_r )
+  : _states( 1 )
+  , _patterns( patterns_r.size() )
+{
+  // the trie
+  for ( unsigned idx = 0; idx < patterns_r.size(); ++idx )
+  {
+    unsigned state = 0;
+    for ( unsigned char ch : patterns_r[idx] )
+    {
+      ch = fold( ch );
+      std::vector<std::pair<unsigned char,unsigned> > & trans( _states[state]._next );
+      auto it = std::lower_bound( trans.begin(), trans.end(), ch, charLess );
+      if ( it != trans.end() && it->first == ch )
+        state = it->second;
+      else
+      {
+        trans.insert( it, std::make_pair( ch, unsigned(_states.size()) ) );
+        state = _states.size();
+        _states.push_back( State() );	// invalidates trans
+      }
+    }
+    _states[state]._out.push_back( idx );
+  }
+
+  // fail links, breadth first so the fail state is always done before
+  std::deque<unsigned> todo;
+  for ( const auto & tr : _states[0]._next )
+    todo.push_back( tr.second );
+  while ( ! todo.empty() )
+  {
+    unsigned state = todo.front();
+    todo.pop_front();
+    State & st( _states[state] );
+    if ( st._fail != 0 )	// the root's (empty patterns) are reported anyway
+    {
+      const std::vector<unsigned> & inherited( _states[st._fail]._out );
+      st._out.insert( st._out.end(), inherited.begin(), inherited.end() );
+    }
+    for ( const auto & tr : st._next )
+    {
+      unsigned fail = st._fail;
+      unsigned target = noState;
+      while ( state != 0 )
+      {
+        target = next( fail, tr.first );
+        if ( target != noState || fail == 0 )
+          break;
+        fail = _states[fail]._fail;
+      }
+      _states[tr.second]._fail = ( state == 0 || target == noState ) ? 0 : target;
+      todo.push_back( tr.second );
+    }
+  }
+}
+
+unsigned SubstringMatcher::next( unsigned state_r, unsigned char ch_r ) const
+{
+  const std::vector<std::pair<unsigned char,unsigned> > & trans( _states[state_r]._next );
+  auto it = std::lower_bound( trans.begin(), trans.end(), ch_r, charLess );
+  return ( it != trans.end() && it->first == ch_r ) ? it->second : noState;
+}
+
+void SubstringMatcher::match( const std::string & text_r, std::vector<unsigned> & hits_r ) const
+{
+  hits_r.clear();
+  const std::vector<unsigned> & always( _states[0]._out );
+  hits_r.insert( hits_r.end(), always.begin(), always.end() );
+
+  unsigned state = 0;
+  for ( unsigned char ch : text_r )
+  {
+    ch = fold( ch );
+    unsigned target;
+    while ( ( target = next( state, ch ) ) == noState && state != 0 )
+      state = _states[state]._fail;
+    if ( target == noState )
+      state = 0;
+    else
+    {
+      state = target;
+      const std::vector<unsigned> & out( _states[state]._out );
+      hits_r.insert( hits_r.end(), out.begin(), out.end() );
+    }
+  }
+
+  std::sort( hits_r.begin(), hits_r.end() );
+  hits_r.erase( std::unique( hits_r.begin(), hits_r.end() ), hits_r.end() );
+}
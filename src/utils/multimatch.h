@@ -0,0 +1,57 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_UTILS_MULTIMATCH_H
+#define ZYPPER_UTILS_MULTIMATCH_H
+
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////
+/// \class SubstringMatcher
+/// \brief Looks for many substrings at once (Aho-Corasick automaton).
+///
+/// Matching a text costs one pass over it, no matter how many patterns
+/// there are. Patterns are matched case insensitively (ASCII only, like
+/// a case insensitive substring PoolQuery). An empty pattern matches any
+/// text.
+/// \code
+///   SubstringMatcher matcher( ids );
+///   std::vector<unsigned> hits;
+///   matcher.match( text, hits );	// indices into ids
+/// \endcode
+///////////////////////////////////////////////////////////////////
+class SubstringMatcher
+{
+public:
+  explicit SubstringMatcher( const std::vector<std::string> & patterns_r );
+
+  /** Number of patterns. */
+  unsigned size() const
+  { return _patterns; }
+
+  /** Set \a hits_r to the indices of all patterns occurring in \a text_r,
+   * ascending and each just once.
+   */
+  void match( const std::string & text_r, std::vector<unsigned> & hits_r ) const;
+
+private:
+  struct State
+  {
+    State() : _fail( 0 ) {}
+    std::vector<std::pair<unsigned char,unsigned> > _next;	//< sorted by char
+    unsigned _fail;			//< longest proper suffix which is a state too
+    std::vector<unsigned> _out;		//< patterns ending here (incl. via _fail)
+  };
+
+  unsigned next( unsigned state_r, unsigned char ch_r ) const;
+
+  std::vector<State> _states;
+  unsigned _patterns;
+};
+
+#endif // ZYPPER_UTILS_MULTIMATCH_H
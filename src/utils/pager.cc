@@ -6,15 +6,16 @@
 \*---------------------------------------------------------------------------*/
 
 #include <iostream>
-#include <sstream>
 #include <fstream>
 #include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/wait.h> //for wait()
 #include <iterator>
 
 #include <zypp/base/Logger.h>
 #include <zypp/base/String.h>
-#include <zypp/TmpPath.h>
 #include <zypp/Pathname.h>
 #include <zypp/PathInfo.h>
 
@@ -51,38 +52,157 @@ static string pager_help_navigation(const string & pager)
 
 // ---------------------------------------------------------------------------
 
-static bool show_in_pager(const string & pager, const Pathname & file)
+static string pager_command()
 {
-  if (Zypper::instance()->globalOpts().non_interactive)
-    return true;
+  const char* envpager = ::getenv("PAGER");
+  if (!envpager || ::strlen(envpager) == 0)
+    envpager = "more"; // basic posix default, must be in PATH
+  return envpager;
+}
 
-  ostringstream cmdline;
-  cmdline << "'" << pager << "' '" << file << "'";
+// ---------------------------------------------------------------------------
 
-  string errmsg;
-  pid_t pid;
-  switch(pid = fork())
+namespace
+{
+  ///////////////////////////////////////////////////////////////////
+  /// \class PipeBuf
+  /// \brief Buffered streambuf writing to a file descriptor.
+  ///
+  /// Once a write fails (e.g. EPIPE because the pager was quit) the
+  /// buffer reports EOF, so the stream turns bad and further output is
+  /// dropped cheaply.
+  ///////////////////////////////////////////////////////////////////
+  class PipeBuf : public std::streambuf
   {
-  case -1:
-    WAR << "fork failed" << endl;
-    return false;
+  public:
+    PipeBuf( int fd_r = -1 )
+      : _fd( fd_r )
+    { setp( _buf, _buf + sizeof(_buf) ); }
+
+    void setFd( int fd_r )
+    { _fd = fd_r; }
+
+  protected:
+    virtual int overflow( int ch )
+    {
+      if ( ! flushBuf() )
+        return traits_type::eof();
+      if ( ! traits_type::eq_int_type( ch, traits_type::eof() ) )
+        sputc( traits_type::to_char_type( ch ) );
+      return traits_type::not_eof( ch );
+    }
+
+    virtual int sync()
+    { return flushBuf() ? 0 : -1; }
+
+  private:
+    bool flushBuf()
+    {
+      const char * data = pbase();
+      size_t size = pptr() - pbase();
+      setp( _buf, _buf + sizeof(_buf) );	// drop the data on error, too
+      if ( _fd < 0 )
+        return false;
+
+      while ( size )
+      {
+        ssize_t ret = ::write( _fd, data, size );
+        if ( ret < 0 )
+        {
+          if ( errno == EINTR )
+            continue;
+          if ( errno != EPIPE )
+            WAR << "write to pager failed: " << strerror(errno) << endl;
+          _fd = -1;
+          return false;
+        }
+        data += ret;
+        size -= ret;
+      }
+      return true;
+    }
+
+  private:
+    int _fd;
+    char _buf[4096];
+  };
+} // namespace
+
+///////////////////////////////////////////////////////////////////
+/// \class Pager::Impl
+///////////////////////////////////////////////////////////////////
+class Pager::Impl
+{
+public:
+  Impl()
+    : _pid( -1 )
+    , _fd( -1 )
+    , _str( &_buf )
+    , _oldSigPipe( SIG_DFL )
+    , _closed( false )
+    , _result( true )
+  {}
+
+  /** Fork the pager reading from a pipe; \c false on error. */
+  bool start( const string & pager )
+  {
+    int fds[2];
+    if ( ::pipe( fds ) == -1 )
+    {
+      WAR << "pipe failed: " << strerror(errno) << endl;
+      return false;
+    }
 
-  case 0:
-    execlp("sh","sh","-c",cmdline.str().c_str(),(char *)0);
-    WAR << "exec failed with " << strerror(errno) << endl;
-    // exit, cannot return false here, because this is another process
-    //! \todo FIXME different exit code + message
-    exit(ZYPPER_EXIT_ERR_BUG);
+    string cmdline( "'" + pager + "'" );
+    cout << std::flush;	// don't let the pager overtake pending output
 
-  default:
-    DBG << "Executed pager process (pid: " << pid << ")" << endl;
+    switch( _pid = fork() )
+    {
+    case -1:
+      WAR << "fork failed" << endl;
+      ::close( fds[0] );
+      ::close( fds[1] );
+      return false;
+
+    case 0:
+      ::close( fds[1] );
+      if ( fds[0] != STDIN_FILENO )
+      {
+        ::dup2( fds[0], STDIN_FILENO );
+        ::close( fds[0] );
+      }
+      execlp("sh","sh","-c",cmdline.c_str(),(char *)0);
+      WAR << "exec failed with " << strerror(errno) << endl;
+      // exit, cannot return false here, because this is another process
+      //! \todo FIXME different exit code + message
+      ::_exit(ZYPPER_EXIT_ERR_BUG);
+
+    default:
+      DBG << "Executed pager process (pid: " << _pid << ")" << endl;
+      ::close( fds[0] );
+      _fd = fds[1];
+      ::fcntl( _fd, F_SETFD, FD_CLOEXEC );
+      // a pager quit early must not kill us
+      _oldSigPipe = ::signal( SIGPIPE, SIG_IGN );
+      _buf.setFd( _fd );
+    }
+    return true;
+  }
+
+  /** Close the pipe and wait for the pager. */
+  bool finish()
+  {
+    _closed = true;
+    _str << std::flush;
+    ::close( _fd );
+    ::signal( SIGPIPE, _oldSigPipe );
 
     // wait until pager exits
     int status = 0;
     int ret;
     do
     {
-      ret = waitpid(pid, &status, 0);
+      ret = waitpid(_pid, &status, 0);
     }
     while (ret == -1 && errno == EINTR);
 
@@ -91,16 +211,16 @@ static bool show_in_pager(const string & pager, const Pathname & file)
       status = WEXITSTATUS (status);
       if (status)
       {
-        DBG << "Pid " << pid << " exited with status " << status << endl;
+        DBG << "Pid " << _pid << " exited with status " << status << endl;
         return false;
       }
       else
-        DBG << "Pid " << pid << " successfully completed" << endl;
+        DBG << "Pid " << _pid << " successfully completed" << endl;
     }
     else if (WIFSIGNALED (status))
     {
       status = WTERMSIG (status);
-      WAR << "Pid " << pid << " was killed by signal " << status
+      WAR << "Pid " << _pid << " was killed by signal " << status
           << " (" << strsignal(status);
       if (WCOREDUMP (status))
         WAR << ", core dumped";
@@ -109,89 +229,94 @@ static bool show_in_pager(const string & pager, const Pathname & file)
     }
     else
     {
-      ERR << "Pid " << pid << " exited with unknown error" << endl;
+      ERR << "Pid " << _pid << " exited with unknown error" << endl;
       return false;
     }
+    return true;
   }
 
-  return true;
-}
+public:
+  string _pager;
+  pid_t _pid;
+  int _fd;
+  PipeBuf _buf;
+  std::ostream _str;
+  sighandler_t _oldSigPipe;
+  bool _closed;	//< pipe closed or pager never started
+  bool _result;	//< what close() returns
+};
 
 // ---------------------------------------------------------------------------
 
-bool show_text_in_pager(const string & text, const string & intro)
+Pager::Pager( const string & intro )
+  : _pimpl( new Impl )
 {
-  const char* envpager = ::getenv("PAGER");
-  if (!envpager || ::strlen(envpager) == 0)
-    envpager = "more"; // basic posix default, must be in PATH
-  string pager(envpager);
+  _pimpl->_pager = pager_command();
 
-  filesystem::TmpFile tfile;
-  string tpath = tfile.path().absolutename().asString();
-  ofstream os(tpath.c_str());
+  if ( Zypper::instance()->globalOpts().non_interactive
+    || ! ( _pimpl->_result = _pimpl->start( _pimpl->_pager ) ) )
+  {
+    _pimpl->_str.setstate( std::ios::badbit );	// discard the text
+    _pimpl->_closed = true;
+    return;
+  }
 
+  std::ostream & os( _pimpl->_str );
   // intro
   if (!intro.empty())
     os << intro << endl;
 
   // navigaion hint
-  string help = pager_help_navigation(pager);
+  string help = pager_help_navigation(_pimpl->_pager);
   if (!help.empty())
     os << "(" << help << ")" << endl << endl;
+}
 
-  // the text
-  os << text;
+Pager::~Pager()
+{
+  if ( ! _pimpl->_closed )
+    close();
+}
+
+std::ostream & Pager::stream()
+{ return _pimpl->_str; }
+
+bool Pager::close()
+{
+  if ( _pimpl->_closed )
+    return _pimpl->_result;
 
   // exit hint
-  help = pager_help_exit(pager);
+  string help = pager_help_exit(_pimpl->_pager);
   if (!help.empty())
-    os << endl << endl << "(" << help << ")";
-  os.close();
+    _pimpl->_str << endl << endl << "(" << help << ")";
 
-  return show_in_pager(pager, tfile);
+  return _pimpl->_result = _pimpl->finish();
 }
 
 // ---------------------------------------------------------------------------
 
-bool show_file_in_pager(const Pathname & file, const string & intro)
+bool show_text_in_pager(const string & text, const string & intro)
 {
-  const char* envpager = ::getenv("PAGER");
-  if (!envpager || ::strlen(envpager) == 0)
-    envpager = "more"; // basic posix default, must be in PATH
-  string pager(envpager);
-
-  filesystem::TmpFile tfile;
-  string tpath = tfile.path().absolutename().asString();
-  ofstream os(tpath.c_str());
-
-  // intro
-  if (!intro.empty())
-    os << intro << endl;
+  Pager pager( intro );
+  pager.stream() << text;
+  return pager.close();
+}
 
-  // navigaion hint
-  string help = pager_help_navigation(pager);
-  if (!help.empty())
-    os << "(" << help << ")" << endl << endl;
+// ---------------------------------------------------------------------------
 
-  // the text
+bool show_file_in_pager(const Pathname & file, const string & intro)
+{
   ifstream is(file.asString().c_str());
-  if (is.good())
-    os << is.rdbuf();
-  else
+  if (!is.good())
   {
     cerr << "ERR reading the file" << endl;
-    is.close();
     return false;
   }
-  is.close();
-
-  // exit hint
-  help = pager_help_exit(pager);
-  if (!help.empty())
-    os << endl << endl << "(" << help << ")";
-  os.close();
 
-  return show_in_pager(pager, tfile);
+  Pager pager( intro );
+  pager.stream() << is.rdbuf();
+  return pager.close();
 }
 
 // vim: set ts=2 sts=2 sw=2 et ai:
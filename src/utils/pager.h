@@ -9,12 +9,53 @@
 #define PAGER_H_
 
 #include <string>
+#include <iosfwd>
+#include <memory>
+
+#include <zypp/base/NonCopyable.h>
 
 namespace zypp
 {
   class Pathname;
 }
 
+///////////////////////////////////////////////////////////////////
+/// \class Pager
+/// \brief $PAGER fed through a pipe while the text is being produced.
+///
+/// The pager is started on construction, so the first screen shows up
+/// while the rest of the text is still being written to \ref stream.
+/// If $PAGER is not set, 'more' is used as a fallback. In non-interactive
+/// mode, or after the user quit the pager, writes to \ref stream are
+/// silently discarded.
+/// \code
+///   Pager pager( intro );
+///   summary.dumpTo( pager.stream() );
+///   pager.close();
+/// \endcode
+///////////////////////////////////////////////////////////////////
+class Pager : private zypp::base::NonCopyable
+{
+public:
+  /** Start the pager and write \a intro and the navigation hint. */
+  Pager( const std::string & intro = "" );
+
+  /** Calls \ref close unless already done. */
+  ~Pager();
+
+  /** Where to write the text to. */
+  std::ostream & stream();
+
+  /** Write the exit hint, close the pipe and wait for the pager to exit.
+   * \return true if there was no problem running the pager
+   */
+  bool close();
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> _pimpl;
+};
+
 /**
  * Opens $PAGER with given \a text. If $PAGER is not set, uses 'more' as
  * a fallback.
@@ -222,7 +222,7 @@ read_action_ari_with_timeout(PromptId pid, unsigned timeout, int default_action)
       % poptions.options()[default_action] % timeout
     );
 
-    if (zypper.out().type() == Out::TYPE_XML)
+    if (!zypper.out().typeNORMAL())
       zypper.out().info(msg); // maybe progress??
     else
     {
@@ -234,7 +234,7 @@ read_action_ari_with_timeout(PromptId pid, unsigned timeout, int default_action)
     --timeout;
   }
 
-  if (zypper.out().type() != Out::TYPE_XML)
+  if (zypper.out().typeNORMAL())
     cout << CLEARLN << _("Trying again...") << endl;
 
   return default_action;
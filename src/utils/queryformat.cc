@@ -0,0 +1,116 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+#include <zypp/base/String.h>
+
+#include "main.h"
+#include "utils/text.h"
+#include "utils/queryformat.h"
+
+QueryFormat::QueryFormat( const std::string & template_r, const std::vector<std::string> & tags_r )
+{
+  std::string text;	// literal text collected so far
+  auto flush = [&]()
+  {
+    if ( text.empty() )
+      return;
+    Op op = { noTag, std::string(), 0, false };
+    op._text.swap( text );
+    _ops.push_back( std::move(op) );
+  };
+
+  for ( std::string::size_type pos = 0; pos < template_r.size(); ++pos )
+  {
+    char ch = template_r[pos];
+    if ( ch == '\\' && pos + 1 < template_r.size() )
+    {
+      switch ( template_r[++pos] )
+      {
+        case 'n':  text += '\n'; break;
+        case 't':  text += '\t'; break;
+        case '\\': text += '\\'; break;
+        default:   text += '\\'; text += template_r[pos]; break;
+      }
+      continue;
+    }
+    if ( ch != '%' )
+    {
+      text += ch;
+      continue;
+    }
+    if ( pos + 1 < template_r.size() && template_r[pos+1] == '%' )
+    {
+      text += '%';
+      ++pos;
+      continue;
+    }
+
+    // %[-][width]{tag}
+    std::string::size_type open = template_r.find( '{', pos );
+    std::string::size_type close = template_r.find( '}', pos );
+    if ( open == std::string::npos || close == std::string::npos || close < open )
+    {
+      // translators: %u is the position of the '%' in the template
+      _error = zypp::str::form( _("missing '{tag}' after '%%' at position %u"), unsigned(pos) );
+      _ops.clear();
+      return;
+    }
+    std::string spec( template_r.substr( pos + 1, open - pos - 1 ) );
+    Op op = { noTag, std::string(), 0, false };
+    if ( ! spec.empty() && spec[0] == '-' )
+    {
+      op._left = true;
+      spec.erase( 0, 1 );
+    }
+    if ( spec.find_first_not_of( "0123456789" ) != std::string::npos )
+    {
+      // translators: %s is the width as given, %u its position in the template
+      _error = zypp::str::form( _("invalid width '%s' at position %u"), spec.c_str(), unsigned(pos) );
+      _ops.clear();
+      return;
+    }
+    // checking the digits first keeps strtoul from overflowing
+    if ( spec.size() > 4 || ( ! spec.empty() && std::strtoul( spec.c_str(), nullptr, 10 ) > maxWidth ) )
+    {
+      // translators: %s is the width as given, %u its position in the template, the last %u the largest width
+      _error = zypp::str::form( _("width '%s' at position %u exceeds %u"), spec.c_str(), unsigned(pos), maxWidth );
+      _ops.clear();
+      return;
+    }
+    op._width = spec.empty() ? 0 : std::strtoul( spec.c_str(), nullptr, 10 );
+
+    std::string tag( template_r.substr( open + 1, close - open - 1 ) );
+    auto it = std::find( tags_r.begin(), tags_r.end(), tag );
+    if ( it == tags_r.end() )
+    {
+      // translators: %s is the tag name
+      _error = zypp::str::form( _("unknown tag '%s'"), tag.c_str() );
+      _ops.clear();
+      return;
+    }
+    op._tag = it - tags_r.begin();
+
+    flush();
+    _ops.push_back( std::move(op) );
+    pos = close;
+  }
+  flush();
+}
+
+void QueryFormat::printPadded( std::ostream & str_r, const Op & op_r, const std::string & value_r ) const
+{
+  unsigned width = mbs_width( value_r );
+  std::string pad( width < op_r._width ? op_r._width - width : 0, ' ' );
+  if ( op_r._left )
+    str_r << value_r << pad;
+  else
+    str_r << pad << value_r;
+}
@@ -0,0 +1,87 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_UTILS_QUERYFORMAT_H
+#define ZYPPER_UTILS_QUERYFORMAT_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////
+/// \class QueryFormat
+/// \brief An output template like rpm's --queryformat, parsed once.
+///
+/// The template is literal text with tags: \c %{tag} is replaced by the
+/// value of the tag, \c %20{tag} pads it to the right and \c %-20{tag}
+/// to the left to 20 screen columns (at most \ref maxWidth). \c %% is a
+/// literal \c %, and
+/// \c \\n, \c \\t and \c \\\\ are a newline, a tab and a backslash.
+///
+/// Parsing turns the template into a list of literal strings and tag
+/// indices, so writing a line is a single walk over that list.
+/// \code
+///   QueryFormat fmt( "%-30{name} %{version}\n", { "name", "version" } );
+///   if ( ! fmt.valid() )
+///     error( fmt.error() );
+///   fmt.print( cout, []( unsigned tag_r ) { return value( tag_r ); } );
+/// \endcode
+///////////////////////////////////////////////////////////////////
+class QueryFormat
+{
+public:
+  /** Largest accepted field width; larger ones make the template invalid. */
+  static const unsigned maxWidth = 1024;
+
+  /** Parse \a template_r; tags are looked up in \a tags_r and passed to
+   * \ref print as index into it.
+   */
+  QueryFormat( const std::string & template_r, const std::vector<std::string> & tags_r );
+
+  /** Whether the template could be parsed. */
+  bool valid() const
+  { return _error.empty(); }
+
+  /** What's wrong with the template. */
+  const std::string & error() const
+  { return _error; }
+
+  /** Write the template to \a str_r, asking \a values_r (a functor taking
+   * the tag index and returning a \c std::string) for the tag values.
+   */
+  template <class TValues>
+  void print( std::ostream & str_r, TValues && values_r ) const
+  {
+    for ( const Op & op : _ops )
+    {
+      if ( op._tag == noTag )
+        str_r << op._text;
+      else if ( ! op._width )
+        str_r << values_r( op._tag );
+      else
+        printPadded( str_r, op, values_r( op._tag ) );
+    }
+  }
+
+private:
+  static const unsigned noTag = unsigned(-1);
+
+  struct Op
+  {
+    unsigned _tag;	//< index of the tag or noTag
+    std::string _text;	//< literal text
+    unsigned _width;	//< columns to pad the value to
+    bool _left;		//< pad on the right side
+  };
+
+  void printPadded( std::ostream & str_r, const Op & op_r, const std::string & value_r ) const;
+
+  std::vector<Op> _ops;
+  std::string _error;
+};
+
+#endif // ZYPPER_UTILS_QUERYFORMAT_H
@@ -1,260 +1,504 @@
-#include <sstream>
-#include <map>
+
+#include <iostream>
 #include <vector>
 #include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
 
 #include <zypp/base/Logger.h>
 #include <zypp/base/String.h>
 
+#include "richtext.h"
+
 using namespace std;
 
-enum tags {
-  PARAGRAPH,
-  PRE,
-  BLOCKQUOTE,
-  BOLD,
-  UNDERLINED,
-  ANCHOR,
-  HEADER1,
-  HEADER2,
-  HEADER3,
-  BREAK_LINE,
-  EM,
-  ITALIC,
-  HR,
-  LI,
-  OL,
-  UL,
-  TT,
-  QT,
-  BIG,
-  CODE,
-  CENTER,
-  //special for unknown tags
-  UNKNOWN
-};
-
-std::map<string,tags> _RTtagmap;
-
-bool pre;
-bool ordered;
-unsigned count_list_items;
-
-void fillTagmap()
+namespace
 {
-  _RTtagmap["p"] = PARAGRAPH;
-  _RTtagmap["a"] = ANCHOR;
-  _RTtagmap["b"] = BOLD;
-  _RTtagmap["u"] = UNDERLINED;
-  _RTtagmap["i"] = ITALIC;
-  _RTtagmap["br"] = BREAK_LINE;
-  _RTtagmap["em"] = EM;
-  _RTtagmap["h1"] = HEADER1;
-  _RTtagmap["h2"] = HEADER2;
-  _RTtagmap["h3"] = HEADER3;
-  _RTtagmap["hr"] = HR;
-  _RTtagmap["li"] = LI;
-  _RTtagmap["ol"] = OL;
-  _RTtagmap["ul"] = UL;
-  _RTtagmap["qt"] = QT;
-  _RTtagmap["tt"] = TT;
-  _RTtagmap["big"] = BIG;
-  _RTtagmap["pre"] = PRE;
-  _RTtagmap["bold"] = BOLD;
-  _RTtagmap["code"] = CODE;
-  _RTtagmap["font"] = UNKNOWN; //not parsed in parser
-  _RTtagmap["large"] = UNKNOWN; //same as ncurses
-  _RTtagmap["small"] = UNKNOWN; // same as necurses
-  _RTtagmap["center"] = CENTER;
-  _RTtagmap["strong"] = BOLD; // same as necurses
-  _RTtagmap["blockquote"] = BLOCKQUOTE; // same as necurses
+  enum tags {
+    PARAGRAPH,
+    PRE,
+    BLOCKQUOTE,
+    BOLD,
+    UNDERLINED,
+    ANCHOR,
+    HEADER1,
+    HEADER2,
+    HEADER3,
+    BREAK_LINE,
+    EM,
+    ITALIC,
+    HR,
+    LI,
+    OL,
+    UL,
+    TT,
+    QT,
+    BIG,
+    CODE,
+    CENTER,
+    //special for unknown tags
+    UNKNOWN
+  };
 
-}
+  inline bool eq( const char * name_r, const char * lit_r, size_t len_r )
+  { return ::memcmp( name_r, lit_r, len_r ) == 0; }
 
-string closeTag(vector<tags>& tagStack)
-{
-  if(tagStack.empty())
+  /** Map a tag name to its \ref tags value.
+   * A perfect hash over (length, first char) narrows each name down to
+   * at most one candidate, which is then compared.
+   */
+  tags lookupTag( const char * name_r, size_t len_r )
   {
-    WAR << "closing tag before any opening" << endl;;
-    return "";
-  }
-  tags t = tagStack.back();
-  tagStack.pop_back();
-  switch(t)
-  {
-    case PARAGRAPH:
-      return "\n\n";
-    case LI:
-      return "\n";
-    case PRE:
-      pre = false; //fall thrue
-    default:
-      return "";
+    switch ( len_r )
+    {
+      case 1:
+        switch ( *name_r )
+        {
+          case 'p': return PARAGRAPH;
+          case 'a': return ANCHOR;
+          case 'b': return BOLD;
+          case 'u': return UNDERLINED;
+          case 'i': return ITALIC;
+        }
+        break;
+      case 2:
+        switch ( *name_r )
+        {
+          case 'b': if ( name_r[1] == 'r' ) return BREAK_LINE; break;
+          case 'e': if ( name_r[1] == 'm' ) return EM; break;
+          case 'h':
+            switch ( name_r[1] )
+            {
+              case '1': return HEADER1;
+              case '2': return HEADER2;
+              case '3': return HEADER3;
+              case 'r': return HR;
+            }
+            break;
+          case 'l': if ( name_r[1] == 'i' ) return LI; break;
+          case 'o': if ( name_r[1] == 'l' ) return OL; break;
+          case 'u': if ( name_r[1] == 'l' ) return UL; break;
+          case 'q': if ( name_r[1] == 't' ) return QT; break;
+          case 't': if ( name_r[1] == 't' ) return TT; break;
+        }
+        break;
+      case 3:
+        switch ( *name_r )
+        {
+          case 'b': if ( eq( name_r, "big", 3 ) ) return BIG; break;
+          case 'p': if ( eq( name_r, "pre", 3 ) ) return PRE; break;
+        }
+        break;
+      case 4:
+        switch ( *name_r )
+        {
+          case 'b': if ( eq( name_r, "bold", 4 ) ) return BOLD; break;
+          case 'c': if ( eq( name_r, "code", 4 ) ) return CODE; break;
+          // "font" is not parsed in parser
+        }
+        break;
+      case 6:
+        switch ( *name_r )
+        {
+          case 'c': if ( eq( name_r, "center", 6 ) ) return CENTER; break;
+          case 's': if ( eq( name_r, "strong", 6 ) ) return BOLD; break;	// same as ncurses
+        }
+        break;
+      case 10:
+        if ( eq( name_r, "blockquote", 10 ) ) return BLOCKQUOTE;	// same as ncurses
+        break;
+    }
+    // "font", "large", "small": UNKNOWN, same as ncurses
+    return UNKNOWN;
   }
-}
 
-string openTag(vector<tags>& tagStack, string& tag)
-{
-  tag = zypp::str::trim(tag);
-  std::map<string,tags>::const_iterator it = _RTtagmap.find(tag);
-  tags t;
-  if (it == _RTtagmap.end())
-  {
-    if (tag.size()>3 && tag[0]=='!' && tag[1]=='-' && tag[2]=='-')
-      return ""; //comment
-    WAR << "unknown rich text tag "<<tag << endl;
-    t = UNKNOWN;
-  }
-  else
+  /** Append the UTF-8 encoding of \a cp_r. */
+  template <class _Sink>
+  void putCodepoint( _Sink & sink_r, unsigned long cp_r )
   {
-    t = it->second;
+    if ( cp_r < 0x80 )
+      sink_r.put( char(cp_r) );
+    else if ( cp_r < 0x800 )
+    {
+      sink_r.put( char(0xc0 | (cp_r >> 6)) );
+      sink_r.put( char(0x80 | (cp_r & 0x3f)) );
+    }
+    else if ( cp_r < 0x10000 )
+    {
+      sink_r.put( char(0xe0 | (cp_r >> 12)) );
+      sink_r.put( char(0x80 | ((cp_r >> 6) & 0x3f)) );
+      sink_r.put( char(0x80 | (cp_r & 0x3f)) );
+    }
+    else
+    {
+      sink_r.put( char(0xf0 | ((cp_r >> 18) & 0x07)) );
+      sink_r.put( char(0x80 | ((cp_r >> 12) & 0x3f)) );
+      sink_r.put( char(0x80 | ((cp_r >> 6) & 0x3f)) );
+      sink_r.put( char(0x80 | (cp_r & 0x3f)) );
+    }
   }
-  tagStack.push_back(t);
-  switch(t)
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class RichTextConverter
+  /// \brief Single pass rich text to plain text conversion.
+  ///
+  /// The text is scanned once; plain runs, tag replacements and entities
+  /// are handed to the \a _Sink (\c put(char), \c write(const char*,size_t))
+  /// as they are found.
+  ///////////////////////////////////////////////////////////////////
+  template <class _Sink>
+  class RichTextConverter
   {
-    case HR:
-      tagStack.pop_back(); //hr haven't closing tag
-      return "--------------------";
-
-    case PARAGRAPH:
-      return "";
-    case BREAK_LINE:
-      tagStack.pop_back(); //br haven't closing tag
-      return "\n";
-    case OL:
-      ordered = true;
-      count_list_items = 0;
-      return "\n";
-    case UL:
-      ordered = false;
-      return "\n";
-    case LI:
-      if (ordered)
+  public:
+    RichTextConverter( _Sink & sink_r )
+      : _sink( sink_r )
+      , _pre( false )
+      , _ordered( false )
+      , _count_list_items( 0 )
+    { _tagStack.reserve( 16 ); }
+
+    void convert( const char * b, const char * e )
+    {
+      const char * run = b;	// start of pending plain text
+      for ( const char * p = b; p != e; ++p )
       {
-        ostringstream res;
-        res << ++count_list_items << ") ";
-        res.flush();
-        return res.str();
+        switch ( *p )
+        {
+          case ' ':
+            continue;
+
+          case '\n':
+          case '\t':
+          case '\v':
+          case '\r':
+            if ( _pre )
+              continue;
+            flush( run, p );	// dropped outside <pre>
+            run = p + 1;
+            continue;
+
+          case '<':
+          {
+            flush( run, p );
+            const char * tagEnd = static_cast<const char *>( ::memchr( p, '>', e - p ) );
+            if ( ! tagEnd )
+            {
+              WAR << "ended with non-closed tag " << endl;
+              return;
+            }
+            if ( p+1 != tagEnd && p[1] == '/' )
+              closeTag();
+            else
+              openTag( p+1, tagEnd );
+            p = tagEnd;
+            run = p + 1;
+            continue;
+          }
+
+          case '&':
+          {
+            const char * semi = p + 1;
+            while ( semi != e && *semi != ';' && *semi != '&' && *semi != '<' && *semi != ' ' && *semi != '\n' )
+              ++semi;
+            if ( semi == e || *semi != ';' )
+            {
+              WAR << "unterminated entity" << endl;
+              continue;	// keep '&' as plain text
+            }
+            flush( run, p );
+            entity( p+1, semi );
+            p = semi;
+            run = p + 1;
+            continue;
+          }
+        }
       }
-      else
+      flush( run, e );
+    }
+
+  private:
+    void flush( const char * b, const char * e )
+    {
+      if ( b != e )
+        _sink.write( b, e - b );
+    }
+
+    void closeTag()
+    {
+      if ( _tagStack.empty() )
       {
-        return "- ";
+        WAR << "closing tag before any opening" << endl;
+        return;
       }
-    case PRE:
-      pre = true; //fall thrue
-    default:
-      return "";
-  }
-}
+      tags t = _tagStack.back();
+      _tagStack.pop_back();
+      switch ( t )
+      {
+        case PARAGRAPH:
+          _sink.write( "\n\n", 2 );
+          break;
+        case LI:
+          _sink.put( '\n' );
+          break;
+        case PRE:
+          _pre = false;
+          break;
+        default:
+          break;
+      }
+    }
 
-std::map<string,string> ampersmap;
+    void openTag( const char * b, const char * e )
+    {
+      // the name; attributes and a trailing '/' (<br/>) are ignored
+      while ( b != e && ::isspace( (unsigned char)*b ) )
+        ++b;
+      const char * n = b;
+      while ( n != e && *n != '/' && ! ::isspace( (unsigned char)*n ) )
+        ++n;
 
-void fillAmpersmap()
-{
-  ampersmap["gt"]=">";
-  ampersmap["lt"]="<";
-  ampersmap["amp"]="&";
-  ampersmap["quot"]="\"";
-  ampersmap["nbsp"]=" "; //TODO REAL NBSP
-  ampersmap["product"]="product"; //TODO replace with real name
-}
+      tags t = lookupTag( b, n - b );
+      if ( t == UNKNOWN )
+      {
+        if ( e - b > 3 && b[0] == '!' && b[1] == '-' && b[2] == '-' )
+          return; //comment
+        WAR << "unknown rich text tag " << string( b, n ) << endl;
+      }
 
-string getStringFromAmpr(const string& str)
-{
-  if (ampersmap.empty())
-    fillAmpersmap();
+      switch ( t )
+      {
+        case HR:	// hr haven't closing tag
+          _sink.write( "--------------------", 20 );
+          return;
+        case BREAK_LINE:	// br haven't closing tag
+          _sink.put( '\n' );
+          return;
+        case OL:
+          _ordered = true;
+          _count_list_items = 0;
+          _sink.put( '\n' );
+          break;
+        case UL:
+          _ordered = false;
+          _sink.put( '\n' );
+          break;
+        case LI:
+          if ( _ordered )
+          {
+            char buf[16];
+            int len = ::snprintf( buf, sizeof(buf), "%u) ", ++_count_list_items );
+            _sink.write( buf, len );
+          }
+          else
+            _sink.write( "- ", 2 );
+          break;
+        case PRE:
+          _pre = true;
+          break;
+        default:
+          break;
+      }
+      _tagStack.push_back( t );
+    }
 
-  string::size_type end = str.find(';');
-  DBG << "val ampr is: " << str << endl;
-  if (str[0] == '#') //first is value
-  {
-    int res = 0;
-    istringstream sstr(str.substr(1,end));
-    sstr >> res;
-    DBG << res << endl;
-    if (res!=0)
+    void entity( const char * b, const char * e )
     {
-      return string(1,(char)res); //return char
+      size_t len = e - b;
+      if ( len && *b == '#' )	// numeric: &#NNN; or &#xHH;
+      {
+        unsigned long cp = 0;
+        if ( len > 1 && ( b[1] == 'x' || b[1] == 'X' ) )
+          cp = ::strtoul( string( b+2, e ).c_str(), 0, 16 );
+        else
+          cp = ::strtoul( string( b+1, e ).c_str(), 0, 10 );
+        if ( cp && cp <= 0x10ffff )
+          putCodepoint( _sink, cp );
+        else
+          WAR << "unknown number " << string( b, e ) << endl;
+        return;
+      }
+
+      switch ( len )
+      {
+        case 2:
+          if ( eq( b, "gt", 2 ) ) { _sink.put( '>' ); return; }
+          if ( eq( b, "lt", 2 ) ) { _sink.put( '<' ); return; }
+          break;
+        case 3:
+          if ( eq( b, "amp", 3 ) ) { _sink.put( '&' ); return; }
+          break;
+        case 4:
+          if ( eq( b, "quot", 4 ) ) { _sink.put( '"' ); return; }
+          if ( eq( b, "nbsp", 4 ) ) { _sink.put( ' ' ); return; }	//TODO REAL NBSP
+          break;
+        case 7:
+          if ( eq( b, "product", 7 ) ) { _sink.write( "product", 7 ); return; }	//TODO replace with real name
+          break;
+      }
+      WAR << "unknown entity " << string( b, e ) << endl;
     }
-    else
+
+  private:
+    _Sink & _sink;
+    vector<tags> _tagStack;
+    bool _pre;
+    bool _ordered;
+    unsigned _count_list_items;
+  };
+
+  /** Sink appending to a string. */
+  struct StringSink
+  {
+    StringSink( string & str_r ) : _str( str_r ) {}
+    void put( char ch_r ) { _str.push_back( ch_r ); }
+    void write( const char * s_r, size_t n_r ) { _str.append( s_r, n_r ); }
+    string & _str;
+  };
+
+  ///////////////////////////////////////////////////////////////////
+  /// \class IndentedSink
+  /// \brief Sink printing indented and wrapped lines.
+  ///
+  /// Lines are wrapped exactly like \c zypp::str::printIndented does
+  /// (at the last ' ' within the width, or hard cut), but the text is
+  /// consumed piecewise. Only the current line is buffered.
+  ///////////////////////////////////////////////////////////////////
+  class IndentedSink
+  {
+  public:
+    IndentedSink( ostream & str_r, unsigned indent_r, unsigned width_r )
+      : _str( str_r )
+      , _indent( indent_r )
+      , _width( width_r )
     {
-      WAR << "unknown number " << str << endl;
-      return "";
+      if ( _width )
+      {
+        if ( _indent >= _width )
+          _width = 0;
+        else
+          _width -= _indent;
+      }
+      _line.reserve( _width ? _width + 1 : 256 );
     }
-  }
 
-  DBG << end <<" "<<str.substr(0,end) << endl;
-  return ampersmap[str.substr(0,end)];
-
-}
+    void put( char ch_r )
+    {
+      if ( ch_r == '\n' )
+        endLine();
+      else
+      {
+        _line.push_back( ch_r );
+        wrap();
+      }
+    }
 
-std::string processRichText(const std::string& text)
-{
-  if (_RTtagmap.empty())
-    fillTagmap();
-  //state machine vars
-  pre = false;
-
-  vector<tags> tagStack;
-
-  string res("");
-  res.reserve(text.size());
-  string::size_type pos = 0;
-  do {
-    switch( text[pos] )
+    void write( const char * s_r, size_t n_r )
     {
-      case ' ':
-      case '\n':
-      case '\t':
-      case '\v':
-      case '\r':
-        if (pre)
-          res.push_back(text[pos]);
+      const char * e = s_r + n_r;
+      while ( s_r != e )
+      {
+        const char * nl = static_cast<const char *>( ::memchr( s_r, '\n', e - s_r ) );
+        const char * stop = nl ? nl : e;
+        if ( _width )
+        {
+          // append no more than fits before the next break decision
+          while ( s_r != stop )
+          {
+            size_t room = _width + 1 - _line.size();
+            size_t take = std::min( room, size_t(stop - s_r) );
+            _line.append( s_r, take );
+            s_r += take;
+            wrap();
+          }
+        }
         else
         {
-          if (text[pos]==' ')
-            res.push_back(' ');
+          _line.append( s_r, stop );
+          s_r = stop;
         }
-        break;
-      case '<':
-        if (pos+1==text.npos)
+        if ( nl )
         {
-          WAR << "ended with nonclosed tag."<< endl;
-          return res; //chyba, tohle by se nemelo stavat
+          endLine();
+          ++s_r;
         }
-        if (text[pos+1]=='/') //close tag
+      }
+    }
+
+    /** Print a pending last line. */
+    void finish()
+    {
+      if ( ! _line.empty() )
+        endLine();
+    }
+
+  private:
+    /** Break while the line is longer than the width. */
+    void wrap()
+    {
+      while ( _width && _line.size() > _width )
+      {
+        size_t pos = _width;
+        while ( pos > 0 && _line[pos] != ' ' )
+          --pos;
+        if ( pos > 0 )
         {
-          pos = text.find('>',pos);
-          res.append(closeTag(tagStack));
+          printLine( pos );	// on a ' ', replaced by '\n'
+          _line.erase( 0, pos + 1 );
         }
         else
         {
-          string::size_type tagEndPos = text.find('>',pos);
-          if(tagEndPos==text.npos)
-          {
-            WAR << "ended with non-closed tag " << endl;
-            return res;
-          }
-          string tagname = text.substr(pos+1,tagEndPos-pos-1);
-          pos = tagEndPos;
-          res.append(openTag(tagStack,tagname));
+          printLine( _width );	// cut line
+          _line.erase( 0, _width );
         }
-        break;
-      case '&':
-      {
-        string::size_type semipos = text.find(';',pos);
-        string tmp = getStringFromAmpr(text.substr(pos+1,pos-semipos-1));
-        DBG << "tmp is: " << tmp << endl;
-        res.append(tmp);
-        pos = semipos;
-        break;
       }
-      default:
-        res.push_back(text[pos]);
     }
 
-    ++pos;
-  } while (pos!=text.size());
+    void endLine()
+    {
+      wrap();
+      printLine( _line.size() );
+      _line.clear();
+    }
+
+    void printLine( size_t len_r )
+    {
+      for ( unsigned i = 0; i < _indent; ++i )
+        _str << ' ';
+      _str.write( _line.data(), len_r );
+      _str << '\n';
+    }
+
+  private:
+    ostream & _str;
+    unsigned _indent;
+    unsigned _width;
+    string _line;
+  };
+
+} // namespace
+
+std::string processRichText( const std::string & text )
+{
+  string res;
+  res.reserve( text.size() );
+  StringSink sink( res );
+  RichTextConverter<StringSink>( sink ).convert( text.data(), text.data() + text.size() );
   return res;
 }
 
+std::ostream & printRichText( std::ostream & str, const std::string & text, unsigned indent_r, unsigned width_r )
+{
+  if ( text.empty() )
+    return str;
+
+  IndentedSink sink( str, indent_r, width_r );
+  if ( text.find("DT:Rich") != std::string::npos )
+    RichTextConverter<IndentedSink>( sink ).convert( text.data(), text.data() + text.size() );
+  else
+    sink.write( text.data(), text.size() );
+  sink.finish();
+  return str;
+}
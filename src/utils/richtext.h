@@ -2,21 +2,16 @@
 #define ZYPPERRICHTEXT_H_
 
 #include <iosfwd>
-#include <zypp/base/String.h>
+#include <string>
 
-/** Print [Rich]Text optionally indented. */
-inline std::ostream & printRichText( std::ostream & str, std::string text, unsigned indent_r = 0U, unsigned width_r = 0U )
-{
-  std::string processRichText( const std::string& text );
+/** Convert [Rich]Text tags and entities to plain text. */
+std::string processRichText( const std::string & text );
 
-  if ( text.empty() )
-    return str;
-
-  if ( text.find("DT:Rich") != std::string::npos )
-    text = processRichText( text );
-
-  return zypp::str::printIndented( str, text, indent_r, width_r );	// even unindented as it also asserts a trailing '/n'
-}
+/** Print [Rich]Text optionally indented.
+ *
+ * Rich text is converted on the fly and wrapped like \c zypp::str::printIndented
+ * does, without building the plain text first. Always asserts a trailing '\n'.
+ */
+std::ostream & printRichText( std::ostream & str, const std::string & text, unsigned indent_r = 0U, unsigned width_r = 0U );
 
 #endif
-
@@ -0,0 +1,120 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+
+#include "utils/suggest.h"
+
+namespace
+{
+  inline unsigned char fold( unsigned char ch )
+  { return ( ch >= 'A' && ch <= 'Z' ) ? ch - 'A' + 'a' : ch; }
+
+  /** FNV-1a hash of \a str_r without the character at \a skip_r (npos: none). */
+  unsigned variantHash( const std::string & str_r, std::string::size_type skip_r )
+  {
+    unsigned hash = 2166136261U;
+    for ( std::string::size_type pos = 0; pos < str_r.size(); ++pos )
+    {
+      if ( pos == skip_r )
+        continue;
+      hash ^= fold( str_r[pos] );
+      hash *= 16777619U;
+    }
+    return hash;
+  }
+
+  /** Hashes of \a str_r and of its one character deletions, unique. */
+  std::vector<unsigned> variantHashes( const std::string & str_r )
+  {
+    std::vector<unsigned> ret;
+    ret.reserve( str_r.size() + 1 );
+    ret.push_back( variantHash( str_r, std::string::npos ) );
+    for ( std::string::size_type pos = 0; pos < str_r.size(); ++pos )
+    {
+      // deleting any char of a run gives the same variant
+      if ( pos && fold( str_r[pos] ) == fold( str_r[pos-1] ) )
+        continue;
+      ret.push_back( variantHash( str_r, pos ) );
+    }
+    std::sort( ret.begin(), ret.end() );
+    ret.erase( std::unique( ret.begin(), ret.end() ), ret.end() );
+    return ret;
+  }
+
+  inline bool hashLess( const std::pair<unsigned,unsigned> & lhs, const std::pair<unsigned,unsigned> & rhs )
+  { return lhs.first < rhs.first; }
+}
+
+unsigned edit_distance( const std::string & lhs, const std::string & rhs )
+{
+  // three rows of the usual dynamic programming matrix
+  std::vector<unsigned> prev2( rhs.size() + 1 );
+  std::vector<unsigned> prev( rhs.size() + 1 );
+  std::vector<unsigned> row( rhs.size() + 1 );
+  for ( unsigned j = 0; j <= rhs.size(); ++j )
+    prev[j] = j;
+
+  for ( unsigned i = 1; i <= lhs.size(); ++i )
+  {
+    row[0] = i;
+    for ( unsigned j = 1; j <= rhs.size(); ++j )
+    {
+      unsigned cost = fold( lhs[i-1] ) == fold( rhs[j-1] ) ? 0 : 1;
+      row[j] = std::min( std::min( prev[j] + 1, row[j-1] + 1 ), prev[j-1] + cost );
+      if ( i > 1 && j > 1
+        && fold( lhs[i-1] ) == fold( rhs[j-2] ) && fold( lhs[i-2] ) == fold( rhs[j-1] ) )
+        row[j] = std::min( row[j], prev2[j-2] + 1 );
+    }
+    prev2.swap( prev );
+    prev.swap( row );
+  }
+  return prev[rhs.size()];
+}
+
+NameSuggester::NameSuggester( const std::vector<std::string> & names_r )
+  : _names( names_r )
+{
+  std::sort( _names.begin(), _names.end() );
+  _names.erase( std::unique( _names.begin(), _names.end() ), _names.end() );
+
+  for ( unsigned idx = 0; idx < _names.size(); ++idx )
+  {
+    for ( unsigned hash : variantHashes( _names[idx] ) )
+      _variants.push_back( Variant( hash, idx ) );
+  }
+  std::sort( _variants.begin(), _variants.end() );
+}
+
+std::vector<std::string> NameSuggester::suggest( const std::string & name_r, unsigned max_r ) const
+{
+  unsigned maxDistance = name_r.size() < 5 ? 1 : 2;
+
+  std::vector<unsigned> candidates;
+  for ( unsigned hash : variantHashes( name_r ) )
+  {
+    auto range = std::equal_range( _variants.begin(), _variants.end(), Variant( hash, 0 ), hashLess );
+    for ( auto it = range.first; it != range.second; ++it )
+      candidates.push_back( it->second );
+  }
+  std::sort( candidates.begin(), candidates.end() );
+  candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+
+  std::vector<std::pair<unsigned,unsigned> > hits;	// distance, index (= alphabetical)
+  for ( unsigned idx : candidates )
+  {
+    unsigned distance = edit_distance( name_r, _names[idx] );
+    if ( distance && distance <= maxDistance )
+      hits.push_back( std::make_pair( distance, idx ) );
+  }
+  std::sort( hits.begin(), hits.end() );
+
+  std::vector<std::string> ret;
+  for ( unsigned i = 0; i < hits.size() && i < max_r; ++i )
+    ret.push_back( _names[hits[i].second] );
+  return ret;
+}
@@ -0,0 +1,61 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#ifndef ZYPPER_UTILS_SUGGEST_H
+#define ZYPPER_UTILS_SUGGEST_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+/** Edit distance of \a lhs and \a rhs counting insertions, deletions,
+ * substitutions and transpositions of adjacent characters (optimal string
+ * alignment), ASCII case insensitive.
+ */
+unsigned edit_distance( const std::string & lhs, const std::string & rhs );
+
+///////////////////////////////////////////////////////////////////
+/// \class NameSuggester
+/// \brief Finds the names closest to a misspelled one ("did you mean").
+///
+/// Symmetric delete index: each name is stored along with all variants
+/// of it missing one character. A query looks up itself and its own
+/// one character deletions, so finding the candidates costs some binary
+/// searches instead of comparing the query to every name. Candidates are
+/// verified with \ref edit_distance.
+///
+/// This finds all names within distance 1 and those within distance 2
+/// which share a one character deletion with the query (like a
+/// substitution plus an insertion). Two substitutions are not found.
+/// \code
+///   NameSuggester suggester( names );
+///   std::vector<std::string> similar( suggester.suggest( "vmi", 3 ) );
+/// \endcode
+///////////////////////////////////////////////////////////////////
+class NameSuggester
+{
+public:
+  explicit NameSuggester( const std::vector<std::string> & names_r );
+
+  /** Number of (distinct) names. */
+  unsigned size() const
+  { return _names.size(); }
+
+  /** Up to \a max_r names closest to \a name_r, closest first (names at the
+   * same distance in alphabetical order). A name equal to \a name_r is not
+   * suggested. Names shorter than 5 characters allow only one edit.
+   */
+  std::vector<std::string> suggest( const std::string & name_r, unsigned max_r ) const;
+
+private:
+  typedef std::pair<unsigned,unsigned> Variant;	//< hash, index into _names
+
+  std::vector<std::string> _names;	//< sorted, unique
+  std::vector<Variant> _variants;	//< sorted
+};
+
+#endif // ZYPPER_UTILS_SUGGEST_H
@@ -142,106 +142,190 @@ std::string mbs_substr_by_width(
 
 // ---------------------------------------------------------------------------
 
-void mbs_write_wrapped(ostream & out, const string & text,
+namespace
+{
+  inline void write_spaces(ostream & out, unsigned n)
+  {
+    static const char spaces[] = "                                ";
+    while (n)
+    {
+      unsigned chunk = n < sizeof(spaces) - 1 ? n : sizeof(spaces) - 1;
+      out.write(spaces, chunk);
+      n -= chunk;
+    }
+  }
+
+  inline const char * rtrim_blanks(const char * b, const char * e)
+  {
+    while (e > b && (e[-1] == ' ' || e[-1] == '\t'))
+      --e;
+    return e;
+  }
+}
+
+void mbs_write_wrapped_range(ostream & out, const char * begin, const char * end,
     unsigned indent, unsigned wrap_width, int initial)
 {
-  const char * s = text.c_str();
-  size_t s_bytes = text.length();
-  const char * prevwp = s;
-  const char * linep = s;
-  wchar_t wc;
-  size_t bytes_read;
+  mbstate_t shift_state;
+  memset (&shift_state, 0, sizeof (shift_state));
+
+  // Each character is decoded and measured exactly once. The pending part
+  // of the line [linep,p) is written when the line gets full, so the
+  // columns of the last word [wordp,p) are known without re-measuring.
+  const char * linep = begin;   // start of the text not written yet
+  const char * wordp = begin;   // start of the current (or last) word
+  const char * prevp = begin;   // start of the previous visible char
+  unsigned col = initial < 0 ? indent : initial;
+  unsigned wordcol = col;       // column at wordp
+  unsigned prevcol = col;       // column at prevp
+  bool need_indent = true;
+  unsigned toindent = col;
   bool in_word = false;
   bool in_ctrlseq = false;
 
-  mbstate_t shift_state;
-  memset (&shift_state, 0, sizeof (shift_state));
+  // write [b,e) to the current line, indent first if at the line start
+  auto emit = [&]( const char * b, const char * e )
+  {
+    if (b == e)
+      return;
+    if (need_indent)
+    {
+      write_spaces(out, toindent);
+      need_indent = false;
+    }
+    out.write(b, e - b);
+  };
+  auto newline = [&]()
+  {
+    out << '\n';
+    need_indent = true;
+    toindent = indent;
+  };
 
-  unsigned col = 0;
-  unsigned toindent = initial < 0 ? indent : initial;
-  do
+  for (const char * p = begin; p != end; )
   {
-    // indentation
-    if (!col)
+    if (*p == '\n')
     {
-      out << string(toindent, ' ');
-      col = toindent;
+      emit(linep, p);
+      newline();
+      linep = wordp = prevp = ++p;
+      col = wordcol = prevcol = indent;
+      in_word = false;
+      continue;
     }
 
-    bytes_read = mbrtowc (&wc, s, s_bytes, &shift_state);
-    if (bytes_read > 0)
+    wchar_t wc;
+    size_t bytes_read = mbrtowc (&wc, p, end - p, &shift_state);
+    int w = 0;
+    if (bytes_read >= (size_t) -2) // incomplete (-2) or invalid (-1) sequence
+    {
+      // count the byte as one column and go on
+      memset (&shift_state, 0, sizeof (shift_state));
+      bytes_read = 1;
+      wc = L'?';
+      w = 1;
+    }
+    else if (bytes_read == 0)   // embedded NUL
+      bytes_read = 1;
+    // ignore the length of terminal control sequences in order
+    // to wrap colored text correctly
+    else if (!in_ctrlseq && wc == L'\033')
+      in_ctrlseq = true;
+    else if (in_ctrlseq)
     {
-      // ignore the length of terminal control sequences in order
-      // to wrap colored text correctly
-      if (!in_ctrlseq && ::wcsncmp(&wc, L"\033", 1) == 0)
-        in_ctrlseq = true;
-      else if (in_ctrlseq && ::wcsncmp(&wc, L"m", 1) == 0)
+      if (wc == L'm')
         in_ctrlseq = false;
-      else if (!in_ctrlseq)
-        col += ::wcwidth(wc);
-
-      if (::iswspace(wc))
-        in_word = false;
-      //else if (::wcscmp(wc, L"\n"))
-      //{
-      //  if (!in_word)
-      //    prevwp = s;
-      //  in_word = true;
-      //}
-      else
+    }
+    else
+    {
+      w = ::wcwidth(wc);
+      if (w < 0)
+        w = 0;
+    }
+
+    bool space = w > 0 && ::iswspace(wc);
+    if (space)
+      in_word = false;
+    else if (!in_word)
+    {
+      wordp = p;
+      wordcol = col;
+      in_word = true;
+    }
+
+    // current wc would exceed the wrap width
+    bool skip = false;
+    while (wrap_width && w > 0 && col + w > wrap_width)
+    {
+      if (space)
       {
-        if (!in_word)
-          prevwp = s;
-        in_word = true;
+        // break on the space, drop it
+        if (p != linep)
+        {
+          emit(linep, rtrim_blanks(linep, p));
+          newline();
+        }
+        linep = wordp = prevp = p + bytes_read;
+        col = wordcol = prevcol = indent;
+        skip = true;
+        break;
       }
 
-      // current wc exceeded the wrap width
-      if (col > wrap_width)
+      if (wordp > linep)
       {
-        bool wanthyphen = false;
-        // A single word is longer than the wrap width. Split the word and
-        // append a hyphen at the end of the line. This won't normally happen,
-        // but it can eventually happen e.g. with paths or too low screen widths.
-        //! \todo make word-splitting more intelligent, e.g. if the word already
-        //!       contains a hyphen, split there; do not split because
-        //!       of a non-alphabet character; do not leave orphans, etc...
-        if (linep == prevwp)
+        // move the current word to the next line
+        emit(linep, rtrim_blanks(linep, wordp));
+        newline();
+        col = indent + (col - wordcol);
+        if (prevp < wordp)
         {
-          prevwp = s - 2;
-          wanthyphen = true;
+          prevp = wordp;
+          prevcol = wordcol;
         }
+        prevcol = indent + (prevcol - wordcol);
+        linep = wordp;
+        wordcol = indent;
+        continue;
+      }
 
-        // update the size of the string to read
-        s_bytes -= (prevwp - linep);
-        // print the line, leave linep point to the start of the last word.
-        for (; linep < prevwp; ++linep)
-          out << *linep;
-        if (wanthyphen)
-          out << "-";
-        out << endl;
-        // reset column counter
-        col = 0;
-        toindent = indent;
-        // reset original text pointer (points to current wc, not the start of the word)
-        s = linep;
-        // reset shift state
-        ::memset (&shift_state, 0, sizeof (shift_state));
+      // A single word is longer than the wrap width. Split the word and
+      // append a hyphen at the end of the line. This won't normally happen,
+      // but it can eventually happen e.g. with paths or too low screen widths.
+      //! \todo make word-splitting more intelligent, e.g. if the word already
+      //!       contains a hyphen, split there; do not split because
+      //!       of a non-alphabet character; do not leave orphans, etc...
+      const char * cut = p;
+      unsigned cutcol = col;
+      if (cutcol + 1 > wrap_width)  // no room for the hyphen
+      {
+        cut = prevp;
+        cutcol = prevcol;
       }
-      else
-        s += bytes_read;
-    }
-    // we're at the end of the string
-    else if (bytes_read == 0)
-    {
-      // print the rest of the text
-      for(; *linep; ++linep)
-        out << *linep;
+      if (cut <= linep)
+        break;  // nothing left to split; let it overflow
+      emit(linep, cut);
+      out << '-';
+      newline();
+      col = indent + (col - cutcol);
+      linep = wordp = prevp = cut;
+      wordcol = prevcol = indent;
     }
-    else
+
+    if (!skip && w > 0)
     {
-      out << endl << "WCHAR ERROR" << endl;
-      return;
+      prevp = p;
+      prevcol = col;
+      col += w;
     }
+    p += bytes_read;
   }
-  while(bytes_read > 0);
+
+  // print the rest of the text
+  emit(linep, end);
+}
+
+void mbs_write_wrapped(ostream & out, const string & text,
+    unsigned indent, unsigned wrap_width, int initial)
+{
+  mbs_write_wrapped_range(out, text.data(), text.data() + text.size(), indent, wrap_width, initial);
 }
@@ -17,8 +17,12 @@ unsigned mbs_width (const std::string & str);
 /**
  * Wrap and indent given \a text and write it to the output stream \a out.
  *
+ * The text is wrapped at word boundaries in a single pass, measuring
+ * screen columns (terminal control sequences take none). Whitespace at a
+ * line break is dropped. A '\n' in the text starts a new (indented) line.
+ * No trailing newline is written.
+ *
  * TODO
- * - delete whitespace at the end of lines
  * - keep one-letter words with the next
  *
  * \param out       output stream to write to
@@ -34,6 +38,15 @@ void mbs_write_wrapped (
     const std::string & text,
     unsigned indent, unsigned wrap_width, int initial = -1);
 
+/** \ref mbs_write_wrapped for the text in [\a begin, \a end).
+ * (Not an overload: a string literal and the numeric arguments of the
+ * std::string version would bind to this one.)
+ */
+void mbs_write_wrapped_range (
+    std::ostream & out,
+    const char * begin, const char * end,
+    unsigned indent, unsigned wrap_width, int initial = -1);
+
 /**
  * Returns a substring of a multi-byte character string \a str starting
  * at screen column \a pos and being \a n columns wide, as far as possible
@@ -0,0 +1,201 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+#include <fstream>
+#include <cctype>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "TestSetup.h"
+#include "main.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  typedef map<string,string> JsonRecord;	// member -> raw value (strings unquoted)
+
+  /** Parser for what OutJSON writes: one array of flat objects. */
+  class RecordParser
+  {
+  public:
+    RecordParser( const string & text_r ) : _text( text_r ), _pos( 0 ) {}
+
+    /** \c false unless \a text_r is exactly one array of flat objects. */
+    bool parse( vector<JsonRecord> & records_r )
+    {
+      if ( ! lit( '[' ) )
+        return false;
+      if ( ! lit( ']' ) )
+      {
+        do
+        {
+          JsonRecord rec;
+          if ( ! object( rec ) )
+            return false;
+          records_r.push_back( rec );
+        } while ( lit( ',' ) );
+        if ( ! lit( ']' ) )
+          return false;
+      }
+      skipWs();
+      return _pos == _text.size();
+    }
+
+  private:
+    void skipWs()
+    { while ( _pos < _text.size() && ::isspace( _text[_pos] ) ) ++_pos; }
+
+    bool lit( char ch_r )
+    {
+      skipWs();
+      if ( _pos < _text.size() && _text[_pos] == ch_r )
+      {
+        ++_pos;
+        return true;
+      }
+      return false;
+    }
+
+    bool object( JsonRecord & rec_r )
+    {
+      if ( ! lit( '{' ) )
+        return false;
+      if ( lit( '}' ) )
+        return true;
+      do
+      {
+        string key;
+        string value;
+        if ( ! ( str( key ) && lit( ':' ) && scalar( value ) ) )
+          return false;
+        rec_r[key] = value;
+      } while ( lit( ',' ) );
+      return lit( '}' );
+    }
+
+    bool str( string & value_r )
+    {
+      if ( ! lit( '"' ) )
+        return false;
+      for ( ; _pos < _text.size(); ++_pos )
+      {
+        char ch = _text[_pos];
+        if ( ch == '"' )
+        {
+          ++_pos;
+          return true;
+        }
+        if ( (unsigned char)ch < 0x20 )
+          return false;
+        if ( ch == '\\' )
+        {
+          if ( ++_pos == _text.size() )
+            return false;
+          ch = _text[_pos];
+          if ( ch == 'n' )
+            ch = '\n';
+          else if ( ch == 't' )
+            ch = '\t';
+          else if ( ch == 'u' )
+          {
+            _pos += 4;
+            ch = '?';
+          }
+        }
+        value_r += ch;
+      }
+      return false;
+    }
+
+    bool scalar( string & value_r )
+    {
+      skipWs();
+      if ( _pos < _text.size() && _text[_pos] == '"' )
+        return str( value_r );
+      while ( _pos < _text.size() && ( ::isalnum( _text[_pos] ) || _text[_pos] == '-' || _text[_pos] == '.' ) )
+        value_r += _text[_pos++];
+      return ! value_r.empty();
+    }
+
+    const string & _text;
+    string::size_type _pos;
+  };
+
+  /** Run zypper with \a args_r in a child, returning its stdout and exit code.
+   * The child leaves via _exit, so the output must be complete when
+   * Zypper::main returns.
+   */
+  string runZypper( vector<string> args_r, int & exitcode_r )
+  {
+    args_r.insert( args_r.begin(), "zypper" );
+    int fds[2];
+    BOOST_REQUIRE( ::pipe( fds ) == 0 );
+    pid_t pid = ::fork();
+    BOOST_REQUIRE( pid >= 0 );
+    if ( pid == 0 )
+    {
+      ::close( fds[0] );
+      ::dup2( fds[1], STDOUT_FILENO );
+      vector<char *> argv;
+      for ( string & arg : args_r )
+        argv.push_back( &arg[0] );
+      argv.push_back( 0 );
+      int ret = Zypper::instance()->main( argv.size() - 1, &argv[0] );
+      cout.flush();
+      ::_exit( ret );
+    }
+
+    ::close( fds[1] );
+    string text;
+    char buf[4096];
+    ssize_t got;
+    while ( ( got = ::read( fds[0], buf, sizeof(buf) ) ) > 0 )
+      text.append( buf, got );
+    ::close( fds[0] );
+
+    int status = 0;
+    ::waitpid( pid, &status, 0 );
+    exitcode_r = WIFEXITED( status ) ? WEXITSTATUS( status ) : -1;
+    return text;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(uncovered_command_test)
+{
+  int exitcode = 0;
+  string text( runZypper( { "--non-interactive", "--jsonout", "packages" }, exitcode ) );
+  BOOST_CHECK_EQUAL( exitcode, ZYPPER_EXIT_ERR_INVALID_ARGS );
+
+  vector<JsonRecord> records;
+  BOOST_REQUIRE_MESSAGE( RecordParser( text ).parse( records ), text );
+  BOOST_REQUIRE_EQUAL( records.size(), 1U );
+  BOOST_CHECK_EQUAL( records[0]["type"], "message" );
+  BOOST_CHECK_EQUAL( records[0]["kind"], "error" );
+}
+
+BOOST_AUTO_TEST_CASE(covered_command_test)
+{
+  filesystem::TmpDir root;
+  Pathname reposd( root.path() / "etc/zypp/repos.d" );
+  filesystem::assert_dir( reposd );
+  ofstream( ( reposd / "test.repo" ).c_str() )
+    << "[test]\nname=Test \"quoted\"\nbaseurl=dir:///nonexistent\nenabled=1\n";
+
+  int exitcode = 0;
+  string text( runZypper( { "--non-interactive", "--root", root.path().asString(), "--jsonout", "repos" }, exitcode ) );
+  BOOST_CHECK_EQUAL( exitcode, ZYPPER_EXIT_OK );
+
+  vector<JsonRecord> records;
+  BOOST_REQUIRE_MESSAGE( RecordParser( text ).parse( records ), text );
+  BOOST_REQUIRE_EQUAL( records.size(), 1U );
+  BOOST_CHECK_EQUAL( records[0]["type"], "repo" );
+  BOOST_CHECK_EQUAL( records[0]["alias"], "test" );
+  BOOST_CHECK_EQUAL( records[0]["name"], "Test \"quoted\"" );
+  BOOST_CHECK_EQUAL( records[0]["enabled"], "true" );
+}
@@ -0,0 +1,169 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/** \file tests/PoolNameIndex_test.cc
+ *
+ * Checks that PoolNameIndex and pkg_spec_lookup find the same solvables
+ * as the query of pkg_spec_to_poolquery, matching names case insensitive
+ * and filtering by edition, arch and repo.
+ */
+
+#include <algorithm>
+
+#include "TestSetup.h"
+
+#include "misc.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  /** The solvables found by pkg_spec_to_poolquery, sorted. */
+  vector<sat::Solvable> queried( const Capability & cap_r, const list<string> & repos_r = list<string>() )
+  {
+    PoolQuery q( pkg_spec_to_poolquery( cap_r, repos_r ) );
+    vector<sat::Solvable> ret( q.begin(), q.end() );
+    sort( ret.begin(), ret.end() );
+    return ret;
+  }
+
+  vector<sat::Solvable> sorted( vector<sat::Solvable> solvables_r )
+  {
+    sort( solvables_r.begin(), solvables_r.end() );
+    return solvables_r;
+  }
+
+  /** Check the index finds what the query finds for \a cap_r, and return it. */
+  vector<sat::Solvable> lookup( PoolNameIndex & index_r, const Capability & cap_r, const list<string> & repos_r = list<string>() )
+  {
+    vector<sat::Solvable> ret( sorted( index_r.lookup( cap_r, repos_r ) ) );
+    vector<sat::Solvable> expected( queried( cap_r, repos_r ) );
+    BOOST_CHECK_EQUAL_COLLECTIONS( ret.begin(), ret.end(), expected.begin(), expected.end() );
+    return ret;
+  }
+}
+
+static TestSetup test(Arch_x86_64);
+
+BOOST_AUTO_TEST_CASE(setup)
+{
+  test.loadTargetRepo(TESTS_SRC_DIR "/data/openSUSE-11.1_subset");
+  test.loadRepo(TESTS_SRC_DIR "/data/openSUSE-11.1", "main");
+
+  RepoInfo repo;
+  repo.setAlias("upd");
+  repo.addBaseUrl(Url("file://" TESTS_SRC_DIR "/data/openSUSE-11.1_updates"));
+  repo.setGpgCheck(false);
+  test.loadRepo(repo);
+}
+
+BOOST_AUTO_TEST_CASE(name_case)
+{
+  PoolNameIndex index;
+  // ConsoleKit is installed and in main
+  vector<sat::Solvable> exact( lookup( index, Capability("ConsoleKit") ) );
+  BOOST_CHECK( exact.size() >= 2 );
+  for ( const auto & solv : exact )
+    BOOST_CHECK_EQUAL( solv.name(), "ConsoleKit" );
+
+  vector<sat::Solvable> upper( lookup( index, Capability("CONSOLEKIT") ) );
+  vector<sat::Solvable> lower( lookup( index, Capability("consolekit") ) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( upper.begin(), upper.end(), exact.begin(), exact.end() );
+  BOOST_CHECK_EQUAL_COLLECTIONS( lower.begin(), lower.end(), exact.begin(), exact.end() );
+
+  BOOST_CHECK( lookup( index, Capability("nonexistent-package") ).empty() );
+  // names only, not what a package provides
+  BOOST_CHECK( lookup( index, Capability("libc.so.6()(64bit)") ).empty() );
+
+  // the name lookup for "did you mean" hints
+  vector<sat::Solvable> byName( sorted( index.lookup( ResKind::package, "CONSOLEKIT" ) ) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( byName.begin(), byName.end(), exact.begin(), exact.end() );
+}
+
+BOOST_AUTO_TEST_CASE(edition)
+{
+  PoolNameIndex index;
+  // glibc: 2.9-2.9 installed, 2.8.90-2.3 and 2.8.90-11.1 in main
+  Edition base( "2.8.90-2.3" );
+  vector<sat::Solvable> newer( lookup( index, Capability( "glibc", Rel::GT, base ) ) );
+  BOOST_CHECK( ! newer.empty() );
+  for ( const auto & solv : newer )
+    BOOST_CHECK( solv.edition() > base );
+
+  vector<sat::Solvable> same( lookup( index, Capability( "glibc", Rel::EQ, base ) ) );
+  BOOST_REQUIRE( ! same.empty() );
+  for ( const auto & solv : same )
+    BOOST_CHECK_EQUAL( solv.edition(), base );
+
+  // a version without release matches all its releases
+  vector<sat::Solvable> version( lookup( index, Capability( "glibc", Rel::EQ, Edition("2.8.90") ) ) );
+  BOOST_CHECK( version.size() > same.size() );
+  for ( const auto & solv : version )
+    BOOST_CHECK_EQUAL( solv.edition().version(), "2.8.90" );
+
+  BOOST_CHECK( lookup( index, Capability( "glibc", Rel::LT, Edition("1.0") ) ).empty() );
+}
+
+BOOST_AUTO_TEST_CASE(arch)
+{
+  PoolNameIndex index;
+  vector<sat::Solvable> i686( lookup( index, Capability( Arch_i686, "glibc", Rel::ANY, Edition() ) ) );
+  BOOST_CHECK( ! i686.empty() );
+  for ( const auto & solv : i686 )
+    BOOST_CHECK_EQUAL( solv.arch(), Arch_i686 );
+
+  vector<sat::Solvable> x86_64( lookup( index, Capability( Arch_x86_64, "glibc", Rel::ANY, Edition() ) ) );
+  BOOST_CHECK( ! x86_64.empty() );
+  for ( const auto & solv : x86_64 )
+    BOOST_CHECK_EQUAL( solv.arch(), Arch_x86_64 );
+
+  // arch and edition together
+  vector<sat::Solvable> both( lookup( index, Capability( Arch_i686, "glibc", Rel::EQ, Edition("2.8.90-11.1") ) ) );
+  BOOST_REQUIRE_EQUAL( both.size(), 1U );
+  BOOST_CHECK_EQUAL( both.front().repository().alias(), "main" );
+}
+
+BOOST_AUTO_TEST_CASE(repo)
+{
+  PoolNameIndex index;
+  list<string> main( 1, "main" );
+  vector<sat::Solvable> inMain( lookup( index, Capability("vim"), main ) );
+  BOOST_REQUIRE( ! inMain.empty() );
+  for ( const auto & solv : inMain )
+    BOOST_CHECK_EQUAL( solv.repository().alias(), "main" );
+
+  list<string> upd( 1, "upd" );
+  vector<sat::Solvable> inUpd( lookup( index, Capability("vim"), upd ) );
+  BOOST_REQUIRE( ! inUpd.empty() );
+  for ( const auto & solv : inUpd )
+    BOOST_CHECK_EQUAL( solv.repository().alias(), "upd" );
+
+  list<string> bothRepos( main );
+  bothRepos.push_back( "upd" );
+  BOOST_CHECK_EQUAL( lookup( index, Capability("vim"), bothRepos ).size(), inMain.size() + inUpd.size() );
+
+  BOOST_CHECK( lookup( index, Capability("vim"), list<string>( 1, "nonexistent" ) ).empty() );
+}
+
+BOOST_AUTO_TEST_CASE(spec_lookup)
+{
+  PoolNameIndex index;
+  // plain names go through the index
+  BOOST_CHECK( PoolNameIndex::usable( Capability("ViM") ) );
+  vector<sat::Solvable> vim( sorted( pkg_spec_lookup( index, Capability("ViM") ) ) );
+  vector<sat::Solvable> expected( queried( Capability("ViM") ) );
+  BOOST_CHECK( ! vim.empty() );
+  BOOST_CHECK_EQUAL_COLLECTIONS( vim.begin(), vim.end(), expected.begin(), expected.end() );
+
+  // globs go through the query
+  BOOST_CHECK( ! PoolNameIndex::usable( Capability("vim*") ) );
+  vector<sat::Solvable> glob( sorted( pkg_spec_lookup( index, Capability("vim*") ) ) );
+  expected = queried( Capability("vim*") );
+  BOOST_CHECK( glob.size() > vim.size() );
+  BOOST_CHECK_EQUAL_COLLECTIONS( glob.begin(), glob.end(), expected.begin(), expected.end() );
+}
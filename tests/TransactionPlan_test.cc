@@ -0,0 +1,108 @@
+/*---------------------------------------------------------------------------*\
+                          ____  _ _ __ _ __  ___ _ _
+                         |_ / || | '_ \ '_ \/ -_) '_|
+                         /__|\_, | .__/ .__/\___|_|
+                             |__/|_|  |_|
+\*---------------------------------------------------------------------------*/
+
+/** \file tests/TransactionPlan_test.cc
+ *
+ * Checks that a plan written by write_transaction_plan sets up the same
+ * transaction when applied, and that it is refused for another system.
+ */
+
+#include <fstream>
+
+#include "TestSetup.h"
+
+#include "transaction-plan.h"
+
+using namespace std;
+using namespace zypp;
+
+namespace
+{
+  PoolItem findItem( const string & name_r, const Edition & edition_r, const string & repo_r )
+  {
+    ResPool pool( ResPool::instance() );
+    for_( it, pool.byIdentBegin( ResKind::package, name_r ), pool.byIdentEnd( ResKind::package, name_r ) )
+    {
+      if ( (*it)->edition() == edition_r && (*it)->repository().alias() == repo_r )
+        return *it;
+    }
+    return PoolItem();
+  }
+
+  unsigned transacting()
+  {
+    unsigned ret = 0;
+    for_( it, ResPool::instance().begin(), ResPool::instance().end() )
+    {
+      if ( it->status().transacts() )
+        ++ret;
+    }
+    return ret;
+  }
+
+  void resetAll()
+  {
+    for_( it, ResPool::instance().begin(), ResPool::instance().end() )
+      it->status().resetTransact( ResStatus::USER );
+  }
+}
+
+static TestSetup test(Arch_x86_64);
+
+BOOST_AUTO_TEST_CASE(setup)
+{
+  test.loadTargetRepo(TESTS_SRC_DIR "/data/openSUSE-11.1_subset");
+  test.loadRepo(TESTS_SRC_DIR "/data/openSUSE-11.1", "main");
+}
+
+BOOST_AUTO_TEST_CASE(apply_saved_plan)
+{
+  PoolItem vim( findItem( "vim", Edition("7.2-1.3"), "main" ) );
+  BOOST_REQUIRE( vim );
+  BOOST_REQUIRE( vim.status().setToBeInstalled( ResStatus::USER ) );
+
+  Pathname plan( test.root() / "plan" );
+  BOOST_REQUIRE( write_transaction_plan( test.zypper(), plan ) );
+
+  resetAll();
+  BOOST_CHECK_EQUAL( transacting(), 0U );
+
+  BOOST_REQUIRE( apply_transaction_plan( test.zypper(), plan ) );
+  BOOST_CHECK_EQUAL( transacting(), 1U );
+  BOOST_CHECK( vim.status().isToBeInstalled() );
+  BOOST_CHECK_EQUAL( vim.status().getTransactByValue(), ResStatus::USER );
+  resetAll();
+}
+
+BOOST_AUTO_TEST_CASE(refuse_foreign_plan)
+{
+  PoolItem vim( findItem( "vim", Edition("7.2-1.3"), "main" ) );
+  BOOST_REQUIRE( vim );
+  BOOST_REQUIRE( vim.status().setToBeInstalled( ResStatus::USER ) );
+
+  Pathname plan( test.root() / "plan" );
+  BOOST_REQUIRE( write_transaction_plan( test.zypper(), plan ) );
+  resetAll();
+
+  // same steps, but computed on a system with another rpmdb
+  string text;
+  {
+    ifstream in( plan.c_str() );
+    string line;
+    while ( getline( in, line ) )
+      text += ( str::hasPrefix( line, "rpmdb " ) ? string( "rpmdb 0000" ) : line ) + "\n";
+  }
+  ofstream( plan.c_str() ) << text;
+
+  BOOST_CHECK( ! apply_transaction_plan( test.zypper(), plan ) );
+  BOOST_CHECK_EQUAL( transacting(), 0U );
+
+  // steps which don't exist here
+  ofstream( plan.c_str() ) << "rpmdb 0000\nstep install user package nonsense 1-1 x86_64 main -\n";
+  BOOST_CHECK( ! apply_transaction_plan( test.zypper(), plan ) );
+  BOOST_CHECK_EQUAL( transacting(), 0U );
+}
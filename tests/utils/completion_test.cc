@@ -0,0 +1,67 @@
+#include "TestSetup.h"
+#include "utils/completion.h"
+
+using namespace std;
+
+namespace
+{
+  CompletionIndex sampleIndex()
+  {
+    CompletionIndex index;
+    index.global_options = { "--help", "--root=", "-R=", "--quiet", "-q" };
+    index.commands = {
+      { { "install", "in" }, { "--repo=", "-r=", "--type=", "-t=", "--force" } },
+      { { "remove", "rm" }, { "--type=", "--clean-deps" } },
+      { { "removerepo", "rr" }, { "--all" } },
+      { { "refresh-services", "refs" }, {} },
+      { { "help", "?" }, {} },
+    };
+    index.repos = { "oss", "non-oss", "update" };
+    index.services = { "sles" };
+    index.packages["oss"] = "vim vim-data zypper";
+    index.packages["update"] = "vim";
+    index.packages["@System"] = "vim-small zypper";
+    return index;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(completion_roundtrip_test)
+{
+  CompletionIndex index( sampleIndex() );
+  CompletionIndex read;
+  BOOST_CHECK(read.parse(index.asString()));
+  BOOST_CHECK_EQUAL(read.asString(), index.asString());
+  BOOST_CHECK_EQUAL(read.commands.size(), 5U);
+  BOOST_CHECK(read.commands[3].options.empty());
+  BOOST_CHECK(read.packages["oss"] == "vim vim-data zypper");
+
+  BOOST_CHECK(!read.parse("something else\n"));
+  BOOST_CHECK(!read.parse(""));
+}
+
+BOOST_AUTO_TEST_CASE(completion_complete_test)
+{
+  CompletionIndex index( sampleIndex() );
+
+  // commands and global options
+  BOOST_CHECK(index.complete({ "r" }) == vector<string>({ "refresh-services", "refs", "remove", "removerepo", "rm", "rr" }));
+  BOOST_CHECK(index.complete({ "--r" }) == vector<string>({ "--root" }));
+  BOOST_CHECK(index.complete({ "--root", "/mnt", "i" }) == vector<string>({ "in", "install" }));
+  BOOST_CHECK(index.complete({ "-q", "help", "in" }) == vector<string>({ "in", "install" }));
+  BOOST_CHECK(index.complete({ "bogus", "" }).empty());
+
+  // command options and their arguments
+  BOOST_CHECK(index.complete({ "in", "--" }) == vector<string>({ "--force", "--repo", "--type" }));
+  BOOST_CHECK(index.complete({ "in", "-r", "" }) == vector<string>({ "non-oss", "oss", "update" }));
+  BOOST_CHECK(index.complete({ "in", "--type", "pa" }) == vector<string>({ "package", "patch", "pattern" }));
+  BOOST_CHECK(index.complete({ "rm", "--type", "package", "--c" }) == vector<string>({ "--clean-deps" }));
+
+  // positional arguments
+  BOOST_CHECK(index.complete({ "in", "vi" }) == vector<string>({ "vim", "vim-data" }));
+  BOOST_CHECK(index.complete({ "in", "-r", "oss", "z" }) == vector<string>({ "zypper" }));
+  BOOST_CHECK(index.complete({ "rm", "vi" }) == vector<string>({ "vim-small" }));
+  BOOST_CHECK(index.complete({ "rr", "" }) == vector<string>({ "non-oss", "oss", "update" }));
+  BOOST_CHECK(index.complete({ "refs", "s" }) == vector<string>({ "sles" }));
+}
+
+// vim: set ts=2 sts=8 sw=2 ai et:
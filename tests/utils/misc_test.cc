@@ -0,0 +1,56 @@
+#include "TestSetup.h"
+#include <fstream>
+#include <zypp/TmpPath.h>
+#include "utils/misc.h"
+
+using namespace std;
+using namespace zypp;
+
+BOOST_AUTO_TEST_CASE(read_list_file_test)
+{
+  filesystem::TmpDir dir;
+  Pathname file( dir.path() / "list" );
+  {
+    ofstream out( file.c_str() );
+    out << "# packages to install\n"
+        << "vim\n"
+        << "\n"
+        << "   zypper  libzypp  \n"
+        << "\t# indented comment\n"
+        << "\tglibc>=2.9\n"
+        << "  \n"
+        << "last-line-without-newline";
+  }
+
+  list<string> lines;
+  BOOST_CHECK( read_list_file( file.asString(), lines ) );
+  BOOST_REQUIRE_EQUAL( lines.size(), 4U );
+  list<string>::const_iterator it = lines.begin();
+  BOOST_CHECK_EQUAL( *it++, "vim" );
+  BOOST_CHECK_EQUAL( *it++, "zypper  libzypp" );
+  BOOST_CHECK_EQUAL( *it++, "glibc>=2.9" );
+  BOOST_CHECK_EQUAL( *it++, "last-line-without-newline" );
+
+  // lines are appended
+  BOOST_CHECK( read_list_file( file.asString(), lines ) );
+  BOOST_CHECK_EQUAL( lines.size(), 8U );
+}
+
+BOOST_AUTO_TEST_CASE(read_list_file_empty_test)
+{
+  filesystem::TmpDir dir;
+  Pathname file( dir.path() / "list" );
+  ofstream( file.c_str() ) << "# nothing\n\n   \n";
+
+  list<string> lines;
+  BOOST_CHECK( read_list_file( file.asString(), lines ) );
+  BOOST_CHECK( lines.empty() );
+}
+
+BOOST_AUTO_TEST_CASE(read_list_file_missing_test)
+{
+  filesystem::TmpDir dir;
+  list<string> lines;
+  BOOST_CHECK( ! read_list_file( ( dir.path() / "nonexistent" ).asString(), lines ) );
+  BOOST_CHECK( lines.empty() );
+}
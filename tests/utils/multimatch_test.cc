@@ -0,0 +1,38 @@
+#include "TestSetup.h"
+#include "utils/multimatch.h"
+
+using namespace std;
+
+static vector<unsigned> hits(const SubstringMatcher & matcher, const string & text)
+{
+  vector<unsigned> ret;
+  matcher.match(text, ret);
+  return ret;
+}
+
+BOOST_AUTO_TEST_CASE(substring_matcher_test)
+{
+  vector<string> patterns = { "CVE-2014-1", "cve-2014-12", "2014", "he", "she", "hers" };
+  SubstringMatcher matcher(patterns);
+  BOOST_CHECK_EQUAL(matcher.size(), 6U);
+
+  // case insensitive, overlapping and nested matches, each reported once
+  BOOST_CHECK(hits(matcher, "cve-2014-1234") == vector<unsigned>({ 0, 1, 2 }));
+  BOOST_CHECK(hits(matcher, "CVE-2014-0001") == vector<unsigned>({ 2 }));
+  BOOST_CHECK(hits(matcher, "ushers") == vector<unsigned>({ 3, 4, 5 }));
+  BOOST_CHECK(hits(matcher, "2014 2014") == vector<unsigned>({ 2 }));
+  BOOST_CHECK(hits(matcher, "") == vector<unsigned>());
+  BOOST_CHECK(hits(matcher, "bnc#123456") == vector<unsigned>());
+}
+
+BOOST_AUTO_TEST_CASE(substring_matcher_empty_pattern_test)
+{
+  // an empty pattern matches everything, like a substring PoolQuery
+  vector<string> patterns = { "123", "" };
+  SubstringMatcher matcher(patterns);
+  BOOST_CHECK(hits(matcher, "x") == vector<unsigned>({ 1 }));
+  BOOST_CHECK(hits(matcher, "") == vector<unsigned>({ 1 }));
+  BOOST_CHECK(hits(matcher, "1234") == vector<unsigned>({ 0, 1 }));
+}
+
+// vim: set ts=2 sts=8 sw=2 ai et:
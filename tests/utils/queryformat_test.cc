@@ -0,0 +1,46 @@
+#include "TestSetup.h"
+#include <sstream>
+#include "utils/queryformat.h"
+
+using namespace std;
+
+static const vector<string> tags = { "name", "version", "arch" };
+
+static string format(const QueryFormat & fmt)
+{
+  static const vector<string> values = { "zypper", "1.11.19", "x86_64" };
+  ostringstream str;
+  fmt.print(str, [](unsigned tag) { return values[tag]; });
+  return str.str();
+}
+
+BOOST_AUTO_TEST_CASE(queryformat_test)
+{
+  QueryFormat plain("%{name}-%{version}.%{arch}\\n", tags);
+  BOOST_CHECK(plain.valid());
+  BOOST_CHECK_EQUAL(format(plain), "zypper-1.11.19.x86_64\n");
+
+  QueryFormat padded("[%-8{name}|%8{arch}|%2{version}]", tags);
+  BOOST_CHECK_EQUAL(format(padded), "[zypper  |  x86_64|1.11.19]");
+
+  QueryFormat escapes("100%% \\t\\\\ %{name}\\x", tags);
+  BOOST_CHECK_EQUAL(format(escapes), "100% \t\\ zypper\\x");
+
+  QueryFormat empty("", tags);
+  BOOST_CHECK(empty.valid());
+  BOOST_CHECK_EQUAL(format(empty), "");
+}
+
+BOOST_AUTO_TEST_CASE(queryformat_error_test)
+{
+  BOOST_CHECK(!QueryFormat("%{release}", tags).valid());
+  BOOST_CHECK(!QueryFormat("%{name", tags).valid());
+  BOOST_CHECK(!QueryFormat("50% off", tags).valid());
+  BOOST_CHECK(!QueryFormat("%x{name}", tags).valid());
+  BOOST_CHECK(QueryFormat("%1024{name}", tags).valid());
+  BOOST_CHECK(!QueryFormat("%1025{name}", tags).valid());
+  BOOST_CHECK(!QueryFormat("%-99999999999999999999{name}", tags).valid());
+  BOOST_CHECK_EQUAL(QueryFormat("%{release}", tags).error(), "unknown tag 'release'");
+}
+
+// vim: set ts=2 sts=8 sw=2 ai et:
@@ -0,0 +1,34 @@
+#include "TestSetup.h"
+#include <sstream>
+#include "utils/richtext.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE(processRichText_test)
+{
+  BOOST_CHECK_EQUAL(processRichText("<p>a &amp; b</p>x"), string("a & b\n\nx"));
+  // whitespace other than ' ' is dropped outside of <pre>
+  BOOST_CHECK_EQUAL(processRichText("a\nb<pre>c\nd</pre>"), string("abc\nd"));
+  BOOST_CHECK_EQUAL(processRichText("<ol><li>x</li><li>y</li></ol>"), string("\n1) x\n2) y\n"));
+  BOOST_CHECK_EQUAL(processRichText("<ul><li>x</li></ul>"), string("\n- x\n"));
+  // attributes and self-closing tags
+  BOOST_CHECK_EQUAL(processRichText("<p class=\"x\">a</p>b<br/>c"), string("a\n\nb\nc"));
+  // comments, numeric and unknown entities
+  BOOST_CHECK_EQUAL(processRichText("<!-- DT:Rich -->&#228;&#x41;&unknown;"), string("\xc3\xa4" "A"));
+  // unterminated entity stays as is
+  BOOST_CHECK_EQUAL(processRichText("a & b"), string("a & b"));
+}
+
+BOOST_AUTO_TEST_CASE(printRichText_test)
+{
+  ostringstream s;
+  // wrapped like zypp::str::printIndented
+  printRichText(s, "aaa bbb ccc dddddddddddd\n\nend", 2, 10);
+  BOOST_CHECK_EQUAL(s.str(), string("  aaa bbb\n  ccc\n  dddddddd\n  dddd\n  \n  end\n"));
+
+  s.str("");
+  printRichText(s, "<!-- DT:Rich --><p>one two</p><p>three</p>", 0, 8);
+  BOOST_CHECK_EQUAL(s.str(), string("one two\n\nthree\n\n"));
+}
+
+// vim: set ts=2 sts=8 sw=2 ai et:
@@ -0,0 +1,37 @@
+#include "TestSetup.h"
+#include "utils/suggest.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE(edit_distance_test)
+{
+  BOOST_CHECK_EQUAL(edit_distance("", ""), 0U);
+  BOOST_CHECK_EQUAL(edit_distance("vim", ""), 3U);
+  BOOST_CHECK_EQUAL(edit_distance("vim", "VIM"), 0U);
+  BOOST_CHECK_EQUAL(edit_distance("vim", "vmi"), 1U);   // transposition
+  BOOST_CHECK_EQUAL(edit_distance("vim", "vi"), 1U);
+  BOOST_CHECK_EQUAL(edit_distance("vim", "vin"), 1U);
+  BOOST_CHECK_EQUAL(edit_distance("kitten", "sitting"), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(name_suggester_test)
+{
+  vector<string> names = { "vim", "vim-data", "emacs", "mc", "zypper", "zypper-log",
+                           "libzypp", "gvim", "vim", "ypper" };
+  NameSuggester suggester(names);
+  BOOST_CHECK_EQUAL(suggester.size(), 9U);
+
+  // closest first, then alphabetical
+  BOOST_CHECK(suggester.suggest("vmi", 3) == vector<string>({ "vim" }));
+  BOOST_CHECK(suggester.suggest("vi", 3) == vector<string>({ "vim" }));
+  BOOST_CHECK(suggester.suggest("gim", 3) == vector<string>({ "gvim", "vim" }));
+  BOOST_CHECK(suggester.suggest("zyper", 3) == vector<string>({ "zypper", "ypper" }));
+  BOOST_CHECK(suggester.suggest("zyper", 1) == vector<string>({ "zypper" }));
+  BOOST_CHECK(suggester.suggest("zyppre", 3) == vector<string>({ "zypper" }));
+  BOOST_CHECK(suggester.suggest("emcas", 3) == vector<string>({ "emacs" }));
+  BOOST_CHECK(suggester.suggest("Emacs", 3).empty());   // the name itself
+  BOOST_CHECK(suggester.suggest("foo", 3).empty());
+  BOOST_CHECK(suggester.suggest("", 3).empty());
+}
+
+// vim: set ts=2 sts=8 sw=2 ai et:
@@ -1,4 +1,5 @@
 #include "TestSetup.h"
+#include <sstream>
 #include "utils/text.h"
 
 using namespace std;
@@ -29,7 +30,29 @@ BOOST_AUTO_TEST_CASE(mbs_substr_by_width_test)
 
 BOOST_AUTO_TEST_CASE(mbs_write_wrapped_test)
 {
-  // TODO
+  ostringstream s;
+  mbs_write_wrapped(s, "aaa bbb ccc ddd eee", 2, 10);
+  BOOST_CHECK_EQUAL(s.str(), string("  aaa bbb\n  ccc ddd\n  eee"));
+
+  // too long words are split with a hyphen
+  s.str("");
+  mbs_write_wrapped(s, "abcdefghijklmnop", 2, 10);
+  BOOST_CHECK_EQUAL(s.str(), string("  abcdefg-\n  hijklmn-\n  op"));
+
+  // wrapped by columns, not bytes
+  s.str("");
+  mbs_write_wrapped(s, "玄米茶空想 紅茶", 0, 10);
+  BOOST_CHECK_EQUAL(s.str(), string("玄米茶空想\n紅茶"));
+
+  // color sequences take no columns, '\n' starts an indented line
+  s.str("");
+  mbs_write_wrapped(s, "\033[1ma\033[0mbc def\nghi", 1, 8);
+  BOOST_CHECK_EQUAL(s.str(), string(" \033[1ma\033[0mbc def\n ghi"));
+
+  // a literal with initial indent must not pick the [begin,end) variant
+  s.str("");
+  mbs_write_wrapped(s, "aaa bbb ccc", 1, 8, 3);
+  BOOST_CHECK_EQUAL(s.str(), string("   aaa\n bbb ccc"));
 }
 
 // vim: set ts=2 sts=8 sw=2 ai et: